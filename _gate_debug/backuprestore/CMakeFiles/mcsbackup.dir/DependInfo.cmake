@@ -0,0 +1,25 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/backuprestore/backup.cpp" "backuprestore/CMakeFiles/mcsbackup.dir/backup.cpp.o" "gcc" "backuprestore/CMakeFiles/mcsbackup.dir/backup.cpp.o.d"
+  "/root/repo/backuprestore/backup_manifest.cpp" "backuprestore/CMakeFiles/mcsbackup.dir/backup_manifest.cpp.o" "gcc" "backuprestore/CMakeFiles/mcsbackup.dir/backup_manifest.cpp.o.d"
+  "/root/repo/backuprestore/chunk_store.cpp" "backuprestore/CMakeFiles/mcsbackup.dir/chunk_store.cpp.o" "gcc" "backuprestore/CMakeFiles/mcsbackup.dir/chunk_store.cpp.o.d"
+  "/root/repo/backuprestore/mcsbackup.cpp" "backuprestore/CMakeFiles/mcsbackup.dir/mcsbackup.cpp.o" "gcc" "backuprestore/CMakeFiles/mcsbackup.dir/mcsbackup.cpp.o.d"
+  "/root/repo/backuprestore/progress_reporter.cpp" "backuprestore/CMakeFiles/mcsbackup.dir/progress_reporter.cpp.o" "gcc" "backuprestore/CMakeFiles/mcsbackup.dir/progress_reporter.cpp.o.d"
+  "/root/repo/backuprestore/restore.cpp" "backuprestore/CMakeFiles/mcsbackup.dir/restore.cpp.o" "gcc" "backuprestore/CMakeFiles/mcsbackup.dir/restore.cpp.o.d"
+  "/root/repo/backuprestore/sha256.cpp" "backuprestore/CMakeFiles/mcsbackup.dir/sha256.cpp.o" "gcc" "backuprestore/CMakeFiles/mcsbackup.dir/sha256.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,23 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/mcsbackup.dir/backup.cpp.o"
+  "CMakeFiles/mcsbackup.dir/backup.cpp.o.d"
+  "CMakeFiles/mcsbackup.dir/backup_manifest.cpp.o"
+  "CMakeFiles/mcsbackup.dir/backup_manifest.cpp.o.d"
+  "CMakeFiles/mcsbackup.dir/chunk_store.cpp.o"
+  "CMakeFiles/mcsbackup.dir/chunk_store.cpp.o.d"
+  "CMakeFiles/mcsbackup.dir/mcsbackup.cpp.o"
+  "CMakeFiles/mcsbackup.dir/mcsbackup.cpp.o.d"
+  "CMakeFiles/mcsbackup.dir/progress_reporter.cpp.o"
+  "CMakeFiles/mcsbackup.dir/progress_reporter.cpp.o.d"
+  "CMakeFiles/mcsbackup.dir/restore.cpp.o"
+  "CMakeFiles/mcsbackup.dir/restore.cpp.o.d"
+  "CMakeFiles/mcsbackup.dir/sha256.cpp.o"
+  "CMakeFiles/mcsbackup.dir/sha256.cpp.o.d"
+  "mcsbackup"
+  "mcsbackup.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/mcsbackup.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
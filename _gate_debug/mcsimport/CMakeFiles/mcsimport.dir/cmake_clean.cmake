@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/mcsimport.dir/mcsimport.cpp.o"
+  "CMakeFiles/mcsimport.dir/mcsimport.cpp.o.d"
+  "mcsimport"
+  "mcsimport.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/mcsimport.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
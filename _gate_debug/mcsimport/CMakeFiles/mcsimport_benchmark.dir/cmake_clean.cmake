@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/mcsimport_benchmark.dir/benchmark/mcsimport_benchmark.cpp.o"
+  "CMakeFiles/mcsimport_benchmark.dir/benchmark/mcsimport_benchmark.cpp.o.d"
+  "mcsimport_benchmark"
+  "mcsimport_benchmark.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/mcsimport_benchmark.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,34 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/mcsimport/csv_importer.cpp" "mcsimport/CMakeFiles/mcsimport_core.dir/csv_importer.cpp.o" "gcc" "mcsimport/CMakeFiles/mcsimport_core.dir/csv_importer.cpp.o.d"
+  "/root/repo/mcsimport/csv_input.cpp" "mcsimport/CMakeFiles/mcsimport_core.dir/csv_input.cpp.o" "gcc" "mcsimport/CMakeFiles/mcsimport_core.dir/csv_input.cpp.o.d"
+  "/root/repo/mcsimport/csv_reader.cpp" "mcsimport/CMakeFiles/mcsimport_core.dir/csv_reader.cpp.o" "gcc" "mcsimport/CMakeFiles/mcsimport_core.dir/csv_reader.cpp.o.d"
+  "/root/repo/mcsimport/error_log.cpp" "mcsimport/CMakeFiles/mcsimport_core.dir/error_log.cpp.o" "gcc" "mcsimport/CMakeFiles/mcsimport_core.dir/error_log.cpp.o.d"
+  "/root/repo/mcsimport/import_pipeline.cpp" "mcsimport/CMakeFiles/mcsimport_core.dir/import_pipeline.cpp.o" "gcc" "mcsimport/CMakeFiles/mcsimport_core.dir/import_pipeline.cpp.o.d"
+  "/root/repo/mcsimport/import_stats.cpp" "mcsimport/CMakeFiles/mcsimport_core.dir/import_stats.cpp.o" "gcc" "mcsimport/CMakeFiles/mcsimport_core.dir/import_stats.cpp.o.d"
+  "/root/repo/mcsimport/json_reader.cpp" "mcsimport/CMakeFiles/mcsimport_core.dir/json_reader.cpp.o" "gcc" "mcsimport/CMakeFiles/mcsimport_core.dir/json_reader.cpp.o.d"
+  "/root/repo/mcsimport/mcsapi_row_sink.cpp" "mcsimport/CMakeFiles/mcsimport_core.dir/mcsapi_row_sink.cpp.o" "gcc" "mcsimport/CMakeFiles/mcsimport_core.dir/mcsapi_row_sink.cpp.o.d"
+  "/root/repo/mcsimport/probes.cpp" "mcsimport/CMakeFiles/mcsimport_core.dir/probes.cpp.o" "gcc" "mcsimport/CMakeFiles/mcsimport_core.dir/probes.cpp.o.d"
+  "/root/repo/mcsimport/row_conversion.cpp" "mcsimport/CMakeFiles/mcsimport_core.dir/row_conversion.cpp.o" "gcc" "mcsimport/CMakeFiles/mcsimport_core.dir/row_conversion.cpp.o.d"
+  "/root/repo/mcsimport/row_filter.cpp" "mcsimport/CMakeFiles/mcsimport_core.dir/row_filter.cpp.o" "gcc" "mcsimport/CMakeFiles/mcsimport_core.dir/row_filter.cpp.o.d"
+  "/root/repo/mcsimport/row_sink.cpp" "mcsimport/CMakeFiles/mcsimport_core.dir/row_sink.cpp.o" "gcc" "mcsimport/CMakeFiles/mcsimport_core.dir/row_sink.cpp.o.d"
+  "/root/repo/mcsimport/row_sorter.cpp" "mcsimport/CMakeFiles/mcsimport_core.dir/row_sorter.cpp.o" "gcc" "mcsimport/CMakeFiles/mcsimport_core.dir/row_sorter.cpp.o.d"
+  "/root/repo/mcsimport/spool_directory.cpp" "mcsimport/CMakeFiles/mcsimport_core.dir/spool_directory.cpp.o" "gcc" "mcsimport/CMakeFiles/mcsimport_core.dir/spool_directory.cpp.o.d"
+  "/root/repo/mcsimport/table_schema.cpp" "mcsimport/CMakeFiles/mcsimport_core.dir/table_schema.cpp.o" "gcc" "mcsimport/CMakeFiles/mcsimport_core.dir/table_schema.cpp.o.d"
+  "/root/repo/mcsimport/validation_row_sink.cpp" "mcsimport/CMakeFiles/mcsimport_core.dir/validation_row_sink.cpp.o" "gcc" "mcsimport/CMakeFiles/mcsimport_core.dir/validation_row_sink.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,41 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/mcsimport_core.dir/csv_importer.cpp.o"
+  "CMakeFiles/mcsimport_core.dir/csv_importer.cpp.o.d"
+  "CMakeFiles/mcsimport_core.dir/csv_input.cpp.o"
+  "CMakeFiles/mcsimport_core.dir/csv_input.cpp.o.d"
+  "CMakeFiles/mcsimport_core.dir/csv_reader.cpp.o"
+  "CMakeFiles/mcsimport_core.dir/csv_reader.cpp.o.d"
+  "CMakeFiles/mcsimport_core.dir/error_log.cpp.o"
+  "CMakeFiles/mcsimport_core.dir/error_log.cpp.o.d"
+  "CMakeFiles/mcsimport_core.dir/import_pipeline.cpp.o"
+  "CMakeFiles/mcsimport_core.dir/import_pipeline.cpp.o.d"
+  "CMakeFiles/mcsimport_core.dir/import_stats.cpp.o"
+  "CMakeFiles/mcsimport_core.dir/import_stats.cpp.o.d"
+  "CMakeFiles/mcsimport_core.dir/json_reader.cpp.o"
+  "CMakeFiles/mcsimport_core.dir/json_reader.cpp.o.d"
+  "CMakeFiles/mcsimport_core.dir/mcsapi_row_sink.cpp.o"
+  "CMakeFiles/mcsimport_core.dir/mcsapi_row_sink.cpp.o.d"
+  "CMakeFiles/mcsimport_core.dir/probes.cpp.o"
+  "CMakeFiles/mcsimport_core.dir/probes.cpp.o.d"
+  "CMakeFiles/mcsimport_core.dir/row_conversion.cpp.o"
+  "CMakeFiles/mcsimport_core.dir/row_conversion.cpp.o.d"
+  "CMakeFiles/mcsimport_core.dir/row_filter.cpp.o"
+  "CMakeFiles/mcsimport_core.dir/row_filter.cpp.o.d"
+  "CMakeFiles/mcsimport_core.dir/row_sink.cpp.o"
+  "CMakeFiles/mcsimport_core.dir/row_sink.cpp.o.d"
+  "CMakeFiles/mcsimport_core.dir/row_sorter.cpp.o"
+  "CMakeFiles/mcsimport_core.dir/row_sorter.cpp.o.d"
+  "CMakeFiles/mcsimport_core.dir/spool_directory.cpp.o"
+  "CMakeFiles/mcsimport_core.dir/spool_directory.cpp.o.d"
+  "CMakeFiles/mcsimport_core.dir/table_schema.cpp.o"
+  "CMakeFiles/mcsimport_core.dir/table_schema.cpp.o.d"
+  "CMakeFiles/mcsimport_core.dir/validation_row_sink.cpp.o"
+  "CMakeFiles/mcsimport_core.dir/validation_row_sink.cpp.o.d"
+  "libmcsimport_core.a"
+  "libmcsimport_core.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/mcsimport_core.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,233 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#include "backup.h"
+#include "progress_reporter.h"
+#include "sha256.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+void Backup::scan(const std::string& label, const std::string& root, const std::string& relative) {
+	std::string directory = relative.empty() ? root : root + "/" + relative;
+	DIR* dir = opendir(directory.c_str());
+	if (dir == nullptr) {
+		throw std::runtime_error("Can't read directory " + directory + ": " + std::strerror(errno));
+	}
+	std::vector<std::string> names;
+	while (struct dirent* entry = readdir(dir)) {
+		if (std::strcmp(entry->d_name, ".") != 0 && std::strcmp(entry->d_name, "..") != 0) {
+			names.push_back(entry->d_name);
+		}
+	}
+	closedir(dir);
+	// sorted, so that the manifests of unchanged directories are identical
+	std::sort(names.begin(), names.end());
+	for (auto const& name : names) {
+		std::string path = relative.empty() ? name : relative + "/" + name;
+		if (path.find('\n') != std::string::npos) {
+			throw std::runtime_error("Can't back up " + root + "/" + path + ": its name contains a line break");
+		}
+		struct stat st;
+		// symbolic links are followed, the content they point to is backed up
+		if (stat((root + "/" + path).c_str(), &st) != 0) {
+			throw std::runtime_error("Can't stat " + root + "/" + path + ": " + std::strerror(errno));
+		}
+		if (S_ISDIR(st.st_mode)) {
+			ManifestDirectory d;
+			d.source = label;
+			d.path = path;
+			d.mode = st.st_mode & 07777;
+			this->manifest.directories.push_back(d);
+			scan(label, root, path);
+		}
+		else if (S_ISREG(st.st_mode)) {
+			ManifestFile f;
+			f.source = label;
+			f.path = path;
+			f.size = (std::uint64_t) st.st_size;
+			f.mtime = modificationTime(st);
+			f.mode = st.st_mode & 07777;
+			this->manifest.files.push_back(f);
+		}
+		else if (this->options.verbose) {
+			std::cout << "Skipping " << root << "/" << path << ", it is neither a file nor a directory" << std::endl;
+		}
+	}
+}
+
+void Backup::planFiles(const BackupManifest* previous) {
+	std::unordered_map<std::string, const ManifestFile*> previous_files;
+	if (previous != nullptr && previous->chunk_size == this->manifest.chunk_size && !this->options.checksum) {
+		for (auto const& f : previous->files) {
+			previous_files[f.source + "/" + f.path] = &f;
+		}
+	}
+	for (size_t i = 0; i < this->manifest.files.size(); i++) {
+		ManifestFile& f = this->manifest.files[i];
+		auto it = previous_files.find(f.source + "/" + f.path);
+		if (it != previous_files.end() && it->second->size == f.size && it->second->mtime == f.mtime) {
+			f.chunks = it->second->chunks;
+			f.hash = it->second->hash;
+			this->reused_files++;
+			continue;
+		}
+		if (this->options.verbose) {
+			std::cout << "Reading " << f.source << "/" << f.path << std::endl;
+		}
+		size_t chunk_count = (size_t) ((f.size + this->manifest.chunk_size - 1) / this->manifest.chunk_size);
+		f.chunks.resize(chunk_count);
+		for (size_t c = 0; c < chunk_count; c++) {
+			f.chunks[c].length = (std::uint32_t) std::min(this->manifest.chunk_size, f.size - c * this->manifest.chunk_size);
+			this->jobs.push_back({i, c});
+		}
+		this->bytes_to_read += f.size;
+	}
+}
+
+void Backup::fail(const std::string& message) {
+	std::lock_guard<std::mutex> lock(this->error_mutex);
+	if (!this->failed.exchange(true)) {
+		this->error = message;
+	}
+}
+
+void Backup::hashChunks() {
+	std::vector<char> buffer(this->manifest.chunk_size);
+	int fd = -1;
+	size_t open_file = SIZE_MAX;
+	while (!this->failed) {
+		size_t j = this->next_job++;
+		if (j >= this->jobs.size()) {
+			break;
+		}
+		const ChunkJob& job = this->jobs[j];
+		ManifestFile& f = this->manifest.files[job.file];
+		ManifestChunk& chunk = f.chunks[job.chunk];
+		std::string path = this->manifest.sources[f.source] + "/" + f.path;
+		// the chunks of a file are consecutive jobs, so a worker usually reads on from the file it has open
+		if (open_file != job.file) {
+			if (fd >= 0) {
+				close(fd);
+			}
+			open_file = job.file;
+			fd = open(path.c_str(), O_RDONLY);
+			if (fd < 0) {
+				fail("Can't open " + path + ": " + std::strerror(errno));
+				break;
+			}
+		}
+		std::uint64_t offset = job.chunk * this->manifest.chunk_size;
+		size_t read_bytes = 0;
+		while (read_bytes < chunk.length) {
+			ssize_t r = pread(fd, buffer.data() + read_bytes, chunk.length - read_bytes, (off_t) (offset + read_bytes));
+			if (r < 0 && errno == EINTR) {
+				continue;
+			}
+			if (r <= 0) {
+				break;
+			}
+			read_bytes += (size_t) r;
+		}
+		if (read_bytes < chunk.length) {
+			fail("Can't read " + path + ": it was truncated or is unreadable, is the system still writing to it?");
+			break;
+		}
+		chunk.hash = Sha256::hash(buffer.data(), chunk.length);
+		try {
+			std::uint64_t written = this->store.put(chunk.hash, buffer.data(), chunk.length, this->options.compress);
+			if (written > 0) {
+				this->new_chunks++;
+				this->bytes_stored += written;
+			}
+		}
+		catch (std::exception& e) {
+			fail(e.what());
+			break;
+		}
+		this->bytes_read += chunk.length;
+	}
+	if (fd >= 0) {
+		close(fd);
+	}
+}
+
+void Backup::run() {
+	auto start = std::chrono::steady_clock::now();
+	this->manifest.chunk_size = this->options.chunk_size;
+	this->manifest.created = (std::int64_t) std::time(nullptr);
+	for (auto const& s : this->options.sources) {
+		this->manifest.sources[s.first] = s.second;
+	}
+	for (auto const& s : this->options.sources) {
+		scan(s.first, s.second, "");
+	}
+
+	BackupManifest previous;
+	std::string latest = this->store.latestBackup();
+	if (!latest.empty()) {
+		previous.load(this->store.manifestPath(latest));
+	}
+	planFiles(latest.empty() ? nullptr : &previous);
+	std::cout << "Backing up " << this->manifest.files.size() << " files (" << this->manifest.totalBytes() << " bytes), " << this->reused_files << " unchanged since " << (latest.empty() ? "no previous backup" : latest) << std::endl;
+
+	ProgressReporter reporter(this->options.progress_interval, [this, start] {
+		std::uint64_t read = this->bytes_read;
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << "Progress: " << std::fixed << std::setprecision(1) << (this->bytes_to_read > 0 ? 100.0 * read / this->bytes_to_read : 100.0) << "% (" << read << " of " << this->bytes_to_read << " bytes, " << (read / MIB / seconds) << " MB/s, " << this->new_chunks << " new chunks)" << std::endl;
+	});
+	std::vector<std::thread> workers;
+	for (std::uint32_t t = 0; t < std::min<size_t>(this->options.threads, std::max<size_t>(this->jobs.size(), 1)); t++) {
+		workers.push_back(std::thread(&Backup::hashChunks, this));
+	}
+	for (auto& w : workers) {
+		w.join();
+	}
+	reporter.stop();
+	if (this->failed) {
+		throw std::runtime_error(this->error);
+	}
+
+	for (auto& f : this->manifest.files) {
+		if (f.hash.empty()) {
+			f.hash = f.computeHash();
+		}
+	}
+	this->manifest.save(this->store.manifestPath(this->options.name));
+	this->store.setLatestBackup(this->options.name);
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	size_t chunk_count = 0;
+	for (auto const& f : this->manifest.files) {
+		chunk_count += f.chunks.size();
+	}
+	std::cout << "Backup " << this->options.name << " completed" << std::endl;
+	std::cout << "Files: " << this->manifest.files.size() << " (" << this->reused_files << " unchanged)" << std::endl;
+	std::cout << "Bytes: " << this->manifest.totalBytes() << " (" << this->bytes_read << " read)" << std::endl;
+	std::cout << "Chunks: " << chunk_count << " (" << this->new_chunks << " new)" << std::endl;
+	std::cout << "Bytes stored: " << this->bytes_stored << std::endl;
+	std::cout << "Execution time: " << std::fixed << std::setprecision(3) << seconds << "s (" << std::setprecision(1) << (seconds > 0 ? this->bytes_read / MIB / seconds : 0) << " MB/s)" << std::endl;
+}
@@ -0,0 +1,87 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#pragma once
+
+#include "backup_manifest.h"
+#include "chunk_store.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+static const std::uint64_t MIB = 1024 * 1024;
+
+/**
+* The options of a backup.
+*/
+struct BackupOptions {
+	std::vector<std::pair<std::string, std::string>> sources; // label, directory
+	std::string name;
+	std::uint64_t chunk_size = 4 * MIB;
+	std::uint32_t threads = 5;
+	std::uint32_t progress_interval = 5; // seconds, 0 disables the progress output
+	bool compress = false;
+	bool checksum = false;
+	bool verbose = false;
+};
+
+/**
+* Backs up directories into a chunk store. The files of the directories are split
+* into fixed size chunks that are hashed in parallel, and only chunks that aren't
+* in the store yet are written to it. Files whose size and modification time
+* didn't change since the last backup reuse its chunks without being read, unless
+* checksum is set.
+*/
+class Backup {
+public:
+	Backup(const BackupOptions& backup_options, ChunkStore& chunk_store) : options(backup_options), store(chunk_store) {}
+
+	/*
+	* runs the backup and prints its summary. throws std::runtime_error on I/O errors.
+	*/
+	void run();
+
+private:
+	/**
+	* The hashing of one chunk of a file, the unit of work of the worker threads.
+	*/
+	struct ChunkJob {
+		size_t file;
+		size_t chunk;
+	};
+
+	const BackupOptions& options;
+	ChunkStore& store;
+	BackupManifest manifest;
+	std::vector<ChunkJob> jobs;
+	std::uint64_t bytes_to_read = 0;
+	size_t reused_files = 0;
+
+	std::atomic<size_t> next_job{0};
+	std::atomic<std::uint64_t> bytes_read{0};
+	std::atomic<std::uint64_t> new_chunks{0};
+	std::atomic<std::uint64_t> bytes_stored{0};
+	std::atomic<bool> failed{false};
+	std::mutex error_mutex;
+	std::string error;
+
+	void scan(const std::string& label, const std::string& root, const std::string& relative);
+	void planFiles(const BackupManifest* previous);
+	void hashChunks();
+	void fail(const std::string& message);
+};
@@ -0,0 +1,151 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#include "backup_manifest.h"
+#include "chunk_store.h"
+#include "sha256.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <sys/stat.h>
+
+std::int64_t modificationTime(const struct stat& st) {
+	return (std::int64_t) st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+}
+
+std::string ManifestFile::computeHash() const {
+	Sha256 sha;
+	for (auto const& c : this->chunks) {
+		sha.update(c.hash.data(), c.hash.size());
+	}
+	return sha.hexDigest();
+}
+
+std::uint64_t BackupManifest::totalBytes() const {
+	std::uint64_t bytes = 0;
+	for (auto const& f : this->files) {
+		bytes += f.size;
+	}
+	return bytes;
+}
+
+void BackupManifest::save(const std::string& path) const {
+	std::string tmpFile = path + ".tmp";
+	{
+		std::ofstream out(tmpFile, std::ios::binary | std::ios::trunc);
+		out << "mcsbackup " << FORMAT_VERSION << "\n";
+		out << "chunk_size " << this->chunk_size << "\n";
+		out << "created " << this->created << "\n";
+		for (auto const& s : this->sources) {
+			out << "source " << s.first << " " << s.second << "\n";
+		}
+		for (auto const& d : this->directories) {
+			out << "dir " << d.source << " " << d.mode << " " << d.path << "\n";
+		}
+		for (auto const& f : this->files) {
+			out << "file " << f.source << " " << f.size << " " << f.mtime << " " << f.mode << " " << f.hash << " " << f.path << "\n";
+			for (auto const& c : f.chunks) {
+				out << "chunk " << c.hash << " " << c.length << "\n";
+			}
+		}
+		out.flush();
+		if (!out) {
+			std::remove(tmpFile.c_str());
+			throw std::runtime_error("Can't write manifest file " + tmpFile);
+		}
+	}
+	if (!ChunkStore::renameDurably(tmpFile, path)) {
+		std::remove(tmpFile.c_str());
+		throw std::runtime_error("Can't write manifest file " + path);
+	}
+}
+
+/*
+* splits off the next space separated field of line at position, or the rest of the line if it is the last one
+*/
+static std::string nextField(const std::string& line, size_t& position, bool last) {
+	if (position > line.size()) {
+		return "";
+	}
+	size_t end = last ? line.size() : std::min(line.find(' ', position), line.size());
+	std::string field = line.substr(position, end - position);
+	position = end + 1;
+	return field;
+}
+
+void BackupManifest::load(const std::string& path) {
+	std::ifstream in(path, std::ios::binary);
+	if (!in) {
+		throw std::runtime_error("Can't open manifest file " + path);
+	}
+	*this = BackupManifest();
+	std::string line;
+	size_t line_number = 0;
+	try {
+		while (std::getline(in, line)) {
+			line_number++;
+			size_t position = 0;
+			std::string type = nextField(line, position, false);
+			if (line_number == 1) {
+				if (type != "mcsbackup" || std::stoi(nextField(line, position, true)) != FORMAT_VERSION) {
+					throw std::runtime_error("it isn't a manifest of a supported version");
+				}
+			}
+			else if (type == "chunk_size") {
+				this->chunk_size = std::stoull(nextField(line, position, true));
+			}
+			else if (type == "created") {
+				this->created = std::stoll(nextField(line, position, true));
+			}
+			else if (type == "source") {
+				std::string label = nextField(line, position, false);
+				this->sources[label] = nextField(line, position, true);
+			}
+			else if (type == "dir") {
+				ManifestDirectory d;
+				d.source = nextField(line, position, false);
+				d.mode = (std::uint32_t) std::stoul(nextField(line, position, false));
+				d.path = nextField(line, position, true);
+				this->directories.push_back(d);
+			}
+			else if (type == "file") {
+				ManifestFile f;
+				f.source = nextField(line, position, false);
+				f.size = std::stoull(nextField(line, position, false));
+				f.mtime = std::stoll(nextField(line, position, false));
+				f.mode = (std::uint32_t) std::stoul(nextField(line, position, false));
+				f.hash = nextField(line, position, false);
+				f.path = nextField(line, position, true);
+				this->files.push_back(f);
+			}
+			else if (type == "chunk" && !this->files.empty()) {
+				ManifestChunk c;
+				c.hash = nextField(line, position, false);
+				c.length = (std::uint32_t) std::stoul(nextField(line, position, true));
+				this->files.back().chunks.push_back(c);
+			}
+			else {
+				throw std::runtime_error("unknown entry " + type);
+			}
+		}
+	}
+	catch (std::exception& e) {
+		throw std::runtime_error("Can't read manifest file " + path + " in line " + std::to_string(line_number) + ": " + e.what());
+	}
+	if (line_number == 0) {
+		throw std::runtime_error("Can't read manifest file " + path + ": it is empty");
+	}
+}
@@ -0,0 +1,101 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+struct stat;
+
+/*
+* returns the modification time of a stat result in nanoseconds since the epoch, as manifests record it
+*/
+std::int64_t modificationTime(const struct stat& st);
+
+/**
+* A chunk of a backed up file, named by the SHA-256 digest of its content.
+*/
+struct ManifestChunk {
+	std::string hash;
+	std::uint32_t length;
+};
+
+/**
+* A directory of a backup, so that empty directories are restored as well.
+*/
+struct ManifestDirectory {
+	std::string source;
+	std::string path;
+	std::uint32_t mode;
+};
+
+/**
+* A file of a backup, with the chunks its content is made of in order.
+*/
+struct ManifestFile {
+	std::string source; // the label of the backed up directory
+	std::string path; // relative to the backed up directory
+	std::uint64_t size = 0;
+	std::int64_t mtime = 0; // in nanoseconds since the epoch
+	std::uint32_t mode = 0;
+	std::string hash; // SHA-256 of the concatenated chunk hashes
+	std::vector<ManifestChunk> chunks;
+
+	/*
+	* computes the file hash from the chunks
+	*/
+	std::string computeHash() const;
+};
+
+/**
+* The list of directories, files and chunks of one backup. It is stored as a text
+* file of one entry per line, whose format is stated by its first line:
+*   mcsbackup 1
+*   chunk_size <bytes>
+*   created <seconds since the epoch>
+*   source <label> <path of the backed up directory>
+*   dir <source> <mode> <path>
+*   file <source> <size> <mtime> <mode> <file hash> <path>
+*   chunk <hash> <length>
+* The chunk lines of a file follow its file line. Paths are the last field of a
+* line, so they can contain spaces, but no line breaks.
+*/
+class BackupManifest {
+public:
+	static const int FORMAT_VERSION = 1;
+
+	std::uint64_t chunk_size = 0;
+	std::int64_t created = 0;
+	std::map<std::string, std::string> sources; // label, backed up directory
+	std::vector<ManifestDirectory> directories; // parents before their children
+	std::vector<ManifestFile> files;
+
+	/*
+	* returns the total size of all files
+	*/
+	std::uint64_t totalBytes() const;
+
+	/*
+	* writes the manifest to a temporary file that is renamed to the given path once complete. throws std::runtime_error if it can't be written.
+	*/
+	void save(const std::string& path) const;
+
+	/*
+	* reads the manifest from the given path. throws std::runtime_error if it can't be read or is malformed.
+	*/
+	void load(const std::string& path);
+};
@@ -0,0 +1,280 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#include "chunk_store.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+static const char CHUNK_MAGIC[4] = { 'M', 'C', 'S', 'C' };
+static const size_t CHUNK_HEADER_SIZE = 4 + 1 + 8;
+static const int ZSTD_LEVEL = 3;
+
+static void makeDirectory(const std::string& path) {
+	if (mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) {
+		throw std::runtime_error("Can't create directory " + path + ": " + std::strerror(errno));
+	}
+}
+
+/*
+* flushes a file or directory to disk, returns false if that fails
+*/
+static bool syncPath(const std::string& path) {
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	bool synced = fsync(fd) == 0;
+	return close(fd) == 0 && synced;
+}
+
+ChunkStore::ChunkStore(const std::string& store_directory) {
+	this->directory = store_directory;
+	while (this->directory.size() > 1 && this->directory.back() == '/') {
+		this->directory.pop_back();
+	}
+}
+
+ChunkStore::~ChunkStore() {
+	if (this->lock_file >= 0) {
+		close(this->lock_file);
+	}
+}
+
+void ChunkStore::create() {
+	makeDirectory(this->directory);
+	makeDirectory(this->directory + "/backups");
+	makeDirectory(this->directory + "/chunks");
+	// all subdirectories are created up front, so that concurrent writers don't race for them
+	static const char digits[] = "0123456789abcdef";
+	for (int i = 0; i < 256; i++) {
+		char name[3] = { digits[i >> 4], digits[i & 0xf], '\0' };
+		makeDirectory(this->directory + "/chunks/" + name);
+	}
+}
+
+void ChunkStore::lock(bool exclusive) {
+	std::string path = this->directory + "/lock";
+	this->lock_file = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+	if (this->lock_file < 0 && !exclusive && errno == EROFS) {
+		// nothing can change a read only store while it is read
+		return;
+	}
+	if (this->lock_file < 0) {
+		throw std::runtime_error("Can't open lock file " + path + ": " + std::strerror(errno));
+	}
+	int operation = exclusive ? LOCK_EX : LOCK_SH;
+	if (flock(this->lock_file, operation | LOCK_NB) != 0) {
+		std::cout << "Waiting for another mcsbackup to release the store " << this->directory << std::endl;
+		while (flock(this->lock_file, operation) != 0) {
+			if (errno != EINTR) {
+				throw std::runtime_error("Can't lock file " + path + ": " + std::strerror(errno));
+			}
+		}
+	}
+}
+
+bool ChunkStore::contains(const std::string& hash) const {
+	std::ifstream in(chunkPath(hash), std::ios::binary | std::ios::ate);
+	if (!in) {
+		return false;
+	}
+	std::streamoff size = in.tellg();
+	char header[CHUNK_HEADER_SIZE];
+	in.seekg(0);
+	if (size < (std::streamoff) CHUNK_HEADER_SIZE || !in.read(header, sizeof(header)) || std::memcmp(header, CHUNK_MAGIC, sizeof(CHUNK_MAGIC)) != 0) {
+		return false;
+	}
+	// a compressed chunk can't be checked without decompressing it, an uncompressed one has to be as long as its header says
+	std::uint64_t raw_length = 0;
+	std::memcpy(&raw_length, header + 5, sizeof(raw_length));
+	return header[4] != COMPRESSION_NONE || (std::uint64_t) size - CHUNK_HEADER_SIZE == raw_length;
+}
+
+std::uint64_t ChunkStore::put(const std::string& hash, const char* data, size_t length, bool compress) {
+	static std::atomic<unsigned> counter(0);
+	std::string path = chunkPath(hash);
+	if (contains(hash)) {
+		return 0;
+	}
+	char header[CHUNK_HEADER_SIZE];
+	std::memcpy(header, CHUNK_MAGIC, sizeof(CHUNK_MAGIC));
+	header[4] = COMPRESSION_NONE;
+	std::uint64_t raw_length = length;
+	std::memcpy(header + 5, &raw_length, sizeof(raw_length));
+	const char* content = data;
+	size_t content_length = length;
+#ifdef HAVE_ZSTD
+	std::unique_ptr<char[]> compressed;
+	if (compress) {
+		size_t bound = ZSTD_compressBound(length);
+		compressed.reset(new char[bound]);
+		size_t compressed_length = ZSTD_compress(compressed.get(), bound, data, length, ZSTD_LEVEL);
+		if (!ZSTD_isError(compressed_length) && compressed_length < length) {
+			header[4] = COMPRESSION_ZSTD;
+			content = compressed.get();
+			content_length = compressed_length;
+		}
+	}
+#else
+	(void) compress;
+#endif
+	std::string tmpFile = path + ".tmp." + std::to_string((long long) getpid()) + "." + std::to_string(counter++);
+	std::FILE* file = std::fopen(tmpFile.c_str(), "wb");
+	if (file == nullptr) {
+		throw std::runtime_error("Can't create chunk file " + tmpFile + ": " + std::strerror(errno));
+	}
+	bool written = std::fwrite(header, 1, sizeof(header), file) == sizeof(header) && std::fwrite(content, 1, content_length, file) == content_length;
+	if (std::fclose(file) != 0 || !written || !renameDurably(tmpFile, path)) {
+		std::remove(tmpFile.c_str());
+		throw std::runtime_error("Can't write chunk file " + path);
+	}
+	return sizeof(header) + content_length;
+}
+
+void ChunkStore::get(const std::string& hash, std::vector<char>& data) const {
+	std::string path = chunkPath(hash);
+	std::ifstream in(path, std::ios::binary | std::ios::ate);
+	if (!in) {
+		throw std::runtime_error("Chunk " + hash + " is missing in the store");
+	}
+	std::streamoff size = in.tellg();
+	std::vector<char> content(size > 0 ? (size_t) size : 0);
+	in.seekg(0);
+	in.read(content.data(), content.size());
+	std::uint64_t raw_length = 0;
+	if (!in || content.size() < CHUNK_HEADER_SIZE || std::memcmp(content.data(), CHUNK_MAGIC, sizeof(CHUNK_MAGIC)) != 0) {
+		throw std::runtime_error("Chunk file " + path + " is damaged");
+	}
+	std::memcpy(&raw_length, content.data() + 5, sizeof(raw_length));
+	if (content[4] == COMPRESSION_NONE) {
+		if (content.size() - CHUNK_HEADER_SIZE != raw_length) {
+			throw std::runtime_error("Chunk file " + path + " is damaged");
+		}
+		data.assign(content.begin() + CHUNK_HEADER_SIZE, content.end());
+		return;
+	}
+#ifdef HAVE_ZSTD
+	if (content[4] == COMPRESSION_ZSTD) {
+		data.resize(raw_length);
+		size_t length = ZSTD_decompress(data.data(), data.size(), content.data() + CHUNK_HEADER_SIZE, content.size() - CHUNK_HEADER_SIZE);
+		if (ZSTD_isError(length) || length != raw_length) {
+			throw std::runtime_error("Chunk file " + path + " is damaged");
+		}
+		return;
+	}
+#endif
+	throw std::runtime_error("Chunk file " + path + " uses an unsupported compression");
+}
+
+std::uint64_t ChunkStore::remove(const std::string& hash) {
+	std::string path = chunkPath(hash);
+	struct stat st;
+	if (stat(path.c_str(), &st) != 0 || std::remove(path.c_str()) != 0) {
+		return 0;
+	}
+	return (std::uint64_t) st.st_size;
+}
+
+std::vector<std::string> ChunkStore::listDirectory(const std::string& directory) {
+	std::vector<std::string> names;
+	DIR* dir = opendir(directory.c_str());
+	if (dir == nullptr) {
+		throw std::runtime_error("Can't read directory " + directory + ": " + std::strerror(errno));
+	}
+	while (struct dirent* entry = readdir(dir)) {
+		if (entry->d_name[0] != '.') {
+			names.push_back(entry->d_name);
+		}
+	}
+	closedir(dir);
+	return names;
+}
+
+std::vector<std::string> ChunkStore::chunks() const {
+	std::vector<std::string> hashes;
+	for (auto const& sub : listDirectory(this->directory + "/chunks")) {
+		for (auto const& name : listDirectory(this->directory + "/chunks/" + sub)) {
+			// temporary files of interrupted writes aren't chunks
+			if (name.size() == 64) {
+				hashes.push_back(name);
+			}
+		}
+	}
+	return hashes;
+}
+
+std::vector<std::string> ChunkStore::backups() const {
+	static const std::string suffix = ".manifest";
+	std::vector<std::string> names;
+	for (auto const& name : listDirectory(this->directory + "/backups")) {
+		if (name.size() > suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0) {
+			names.push_back(name.substr(0, name.size() - suffix.size()));
+		}
+	}
+	return names;
+}
+
+std::string ChunkStore::latestBackup() const {
+	std::ifstream in(this->directory + "/backups/LATEST");
+	std::string name;
+	std::getline(in, name);
+	struct stat st;
+	return name != "" && stat(manifestPath(name).c_str(), &st) == 0 ? name : "";
+}
+
+void ChunkStore::setLatestBackup(const std::string& name) {
+	std::string path = this->directory + "/backups/LATEST";
+	std::string tmpFile = path + ".tmp";
+	{
+		std::ofstream out(tmpFile, std::ios::trunc);
+		out << name << "\n";
+		out.flush();
+		if (!out) {
+			throw std::runtime_error("Can't write file " + tmpFile);
+		}
+	}
+	if (!renameDurably(tmpFile, path)) {
+		throw std::runtime_error("Can't write file " + path);
+	}
+}
+
+bool ChunkStore::compressionAvailable() {
+#ifdef HAVE_ZSTD
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool ChunkStore::renameDurably(const std::string& from, const std::string& to) {
+	size_t slash = to.find_last_of('/');
+	std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : to.substr(0, slash);
+	return syncPath(from) && std::rename(from.c_str(), to.c_str()) == 0 && syncPath(directory);
+}
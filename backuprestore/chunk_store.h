@@ -0,0 +1,105 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+* A directory of deduplicated chunks and the manifests of the backups made of them:
+*   chunks/<first two digits of the hash>/<hash>
+*   backups/<name>.manifest
+*   backups/LATEST, the name of the last complete backup
+*   lock, locked exclusively by backups and prunes and shared by restores
+* A chunk file starts with a header of the magic "MCSC", the compression and the
+* uncompressed length, followed by the content. Chunks are written to a temporary
+* file that is renamed once complete and synced to disk, so that writers of the
+* same chunk don't interfere and an interrupted backup or a crash leaves no partial
+* chunk behind.
+*/
+class ChunkStore {
+public:
+	enum Compression { COMPRESSION_NONE = 0, COMPRESSION_ZSTD = 1 };
+
+	explicit ChunkStore(const std::string& store_directory);
+	~ChunkStore();
+
+	/*
+	* creates the directories of the store if they don't exist. throws std::runtime_error if they can't be created.
+	*/
+	void create();
+
+	/*
+	* waits for and takes the lock of the store, exclusive to change it or shared to read it, until the store is destroyed. throws std::runtime_error if it can't be locked.
+	*/
+	void lock(bool exclusive);
+
+	/*
+	* returns true if the chunk with the given hash is stored with a complete header and content
+	*/
+	bool contains(const std::string& hash) const;
+
+	/*
+	* stores a chunk unless it is already stored, zstd compressed if compress is set and that makes it smaller. returns the number of bytes written, 0 if it was already stored. throws std::runtime_error if it can't be written.
+	*/
+	std::uint64_t put(const std::string& hash, const char* data, size_t length, bool compress);
+
+	/*
+	* reads the content of a chunk, without checking its hash. throws std::runtime_error if it is missing or damaged.
+	*/
+	void get(const std::string& hash, std::vector<char>& data) const;
+
+	/*
+	* removes a chunk and returns the size of its file, 0 if it didn't exist
+	*/
+	std::uint64_t remove(const std::string& hash);
+
+	/*
+	* returns the hashes of all stored chunks
+	*/
+	std::vector<std::string> chunks() const;
+
+	/*
+	* returns the names of all backups, in no particular order
+	*/
+	std::vector<std::string> backups() const;
+
+	std::string manifestPath(const std::string& name) const { return this->directory + "/backups/" + name + ".manifest"; }
+	const std::string& path() const { return this->directory; }
+
+	/*
+	* returns the name of the last complete backup, or "" if there is none
+	*/
+	std::string latestBackup() const;
+	void setLatestBackup(const std::string& name);
+
+	/*
+	* returns true if mcsbackup was built with zstd
+	*/
+	static bool compressionAvailable();
+
+	/*
+	* renames a completely written file and syncs it and the directory it is renamed into to disk, so that it survives a crash. returns false if that fails.
+	*/
+	static bool renameDurably(const std::string& from, const std::string& to);
+
+private:
+	std::string directory;
+	int lock_file = -1;
+
+	std::string chunkPath(const std::string& hash) const { return this->directory + "/chunks/" + hash.substr(0, 2) + "/" + hash; }
+	static std::vector<std::string> listDirectory(const std::string& directory);
+};
@@ -0,0 +1,350 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#include "backup.h"
+#include "backup_manifest.h"
+#include "chunk_store.h"
+#include "restore.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+#include <sys/stat.h>
+
+static const int RETURN_SUCCESS = 0;
+static const int RETURN_PARAMETER_ISSUE = 1;
+static const int RETURN_IO_ERROR = 2;
+
+/*
+* lists the backups of a store, oldest first
+*/
+static std::vector<std::pair<std::string, BackupManifest>> loadBackups(ChunkStore& store) {
+	std::vector<std::pair<std::string, BackupManifest>> backups;
+	for (auto const& name : store.backups()) {
+		backups.push_back(std::make_pair(name, BackupManifest()));
+		backups.back().second.load(store.manifestPath(name));
+	}
+	std::sort(backups.begin(), backups.end(), [](const std::pair<std::string, BackupManifest>& a, const std::pair<std::string, BackupManifest>& b) {
+		return a.second.created != b.second.created ? a.second.created < b.second.created : a.first < b.first;
+	});
+	return backups;
+}
+
+static std::string formatTime(std::int64_t seconds) {
+	std::time_t t = (std::time_t) seconds;
+	char buffer[32];
+	std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", std::localtime(&t));
+	return buffer;
+}
+
+static void listBackups(ChunkStore& store) {
+	std::string latest = store.latestBackup();
+	for (auto const& b : loadBackups(store)) {
+		std::cout << b.first << (b.first == latest ? " (latest)" : "") << ": created " << formatTime(b.second.created) << ", " << b.second.files.size() << " files, " << b.second.totalBytes() << " bytes, sources";
+		for (auto const& s : b.second.sources) {
+			std::cout << " " << s.first << "=" << s.second;
+		}
+		std::cout << std::endl;
+	}
+}
+
+/*
+* removes all but the newest keep backups and the chunks only they referenced
+*/
+static void pruneBackups(ChunkStore& store, size_t keep) {
+	auto backups = loadBackups(store);
+	size_t removed = 0;
+	std::set<std::string> referenced;
+	for (size_t i = 0; i < backups.size(); i++) {
+		if (i + keep < backups.size()) {
+			if (std::remove(store.manifestPath(backups[i].first).c_str()) != 0) {
+				throw std::runtime_error("Can't remove manifest file " + store.manifestPath(backups[i].first));
+			}
+			removed++;
+			continue;
+		}
+		for (auto const& f : backups[i].second.files) {
+			for (auto const& c : f.chunks) {
+				referenced.insert(c.hash);
+			}
+		}
+	}
+	size_t removed_chunks = 0;
+	std::uint64_t freed = 0;
+	for (auto const& hash : store.chunks()) {
+		if (referenced.find(hash) == referenced.end()) {
+			freed += store.remove(hash);
+			removed_chunks++;
+		}
+	}
+	std::cout << "Backups removed: " << removed << std::endl;
+	std::cout << "Chunks removed: " << removed_chunks << " (" << freed << " bytes)" << std::endl;
+}
+
+static void printUsage(const char* program) {
+	std::cerr << "Usage: " << program << " backup [options] storeDirectory [label=]sourceDirectory ..." << std::endl;
+	std::cerr << "       " << program << " restore [options] storeDirectory [[label=]targetDirectory ...]" << std::endl;
+	std::cerr << "       " << program << " list storeDirectory" << std::endl;
+	std::cerr << "       " << program << " prune --keep=[n] storeDirectory" << std::endl;
+	std::cerr << std::endl;
+	std::cerr << "storeDirectory            Path to the chunk store, it is created if it doesn't exist." << std::endl;
+	std::cerr << "sourceDirectory           Directory to back up, stored under the label (Default: its name)." << std::endl;
+	std::cerr << "targetDirectory           Directory to restore the label to. (Default: the backed up directory)" << std::endl;
+	std::cerr << std::endl;
+	std::cerr << "OPTIONS:" << std::endl;
+	std::cerr << "-h,--help                 Print this message and exit." << std::endl;
+	std::cerr << "-v,--verbose              Print the files that are read or restored." << std::endl;
+	std::cerr << "-z,--compress             Store the chunks zstd compressed." << std::endl;
+	std::cerr << "-n [value]                Number of parallel threads. (Default: 5)" << std::endl;
+	std::cerr << "--name=[name]             Name of the backup. (Default: backup-YYYYmmdd-HHMMSS, restore: the latest)" << std::endl;
+	std::cerr << "--chunk-size=[MB]         Size of the chunks the files are split into. (Default: 4)" << std::endl;
+	std::cerr << "--checksum                Read and hash unchanged files as well, restore compares existing files by content." << std::endl;
+	std::cerr << "--progress=[seconds]      Interval of the progress output, 0 disables it. (Default: 5)" << std::endl;
+	std::cerr << "--keep=[n]                Number of backups prune keeps. (Default: 3)" << std::endl;
+	std::cerr << "--keep-extra              Leave the files of the target directories that aren't in the backup." << std::endl;
+}
+
+/*
+* parses a positive number option value, returns false if it isn't one
+*/
+static bool parseNumber(const std::string& value, std::uint64_t& number) {
+	if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos || value.size() > 12) {
+		return false;
+	}
+	number = std::stoull(value);
+	return true;
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		printUsage(argv[0]);
+		return RETURN_PARAMETER_ISSUE;
+	}
+	std::string command = argv[1];
+	if (command == "-h" || command == "--help") {
+		printUsage(argv[0]);
+		return RETURN_SUCCESS;
+	}
+	if (command != "backup" && command != "restore" && command != "list" && command != "prune") {
+		std::cerr << "Error: unknown command " << command << std::endl;
+		printUsage(argv[0]);
+		return RETURN_PARAMETER_ISSUE;
+	}
+
+	BackupOptions options;
+	std::uint64_t keep = 3;
+	bool keep_extra = false;
+	std::vector<std::string> arguments;
+	for (int i = 2; i < argc; i++) {
+		std::string arg = argv[i];
+		std::uint64_t number = 0;
+		if (arg == "-h" || arg == "--help") {
+			printUsage(argv[0]);
+			return RETURN_SUCCESS;
+		}
+		else if (arg == "-v" || arg == "--verbose") {
+			options.verbose = true;
+		}
+		else if (arg == "-z" || arg == "--compress") {
+			options.compress = true;
+		}
+		else if (arg == "-zv" || arg == "-vz") {
+			options.compress = true;
+			options.verbose = true;
+		}
+		else if (arg == "-n") {
+			if (i + 1 >= argc || !parseNumber(argv[i + 1], number) || number == 0 || number > 256) {
+				std::cerr << "Error: -n needs a number of threads between 1 and 256" << std::endl;
+				return RETURN_PARAMETER_ISSUE;
+			}
+			options.threads = (std::uint32_t) number;
+			i++;
+		}
+		else if (arg.compare(0, 7, "--name=") == 0) {
+			options.name = arg.substr(7);
+			if (options.name.empty() || options.name == "LATEST" || options.name.find_first_of("/ \n") != std::string::npos || options.name[0] == '.') {
+				std::cerr << "Error: invalid backup name " << options.name << std::endl;
+				return RETURN_PARAMETER_ISSUE;
+			}
+		}
+		else if (arg.compare(0, 13, "--chunk-size=") == 0) {
+			if (!parseNumber(arg.substr(13), number) || number == 0 || number > 1024) {
+				std::cerr << "Error: --chunk-size needs a size between 1 and 1024 MB" << std::endl;
+				return RETURN_PARAMETER_ISSUE;
+			}
+			options.chunk_size = number * MIB;
+		}
+		else if (arg == "--checksum") {
+			options.checksum = true;
+		}
+		else if (arg == "--keep-extra") {
+			keep_extra = true;
+		}
+		else if (arg.compare(0, 11, "--progress=") == 0) {
+			if (!parseNumber(arg.substr(11), number) || number > 86400) {
+				std::cerr << "Error: --progress needs a number of seconds" << std::endl;
+				return RETURN_PARAMETER_ISSUE;
+			}
+			options.progress_interval = (std::uint32_t) number;
+		}
+		else if (arg.compare(0, 7, "--keep=") == 0) {
+			if (!parseNumber(arg.substr(7), number) || number == 0) {
+				std::cerr << "Error: --keep needs a number of backups of at least 1" << std::endl;
+				return RETURN_PARAMETER_ISSUE;
+			}
+			keep = number;
+		}
+		else if (arg.size() > 1 && arg[0] == '-') {
+			std::cerr << "Error: unknown option " << arg << std::endl;
+			printUsage(argv[0]);
+			return RETURN_PARAMETER_ISSUE;
+		}
+		else {
+			arguments.push_back(arg);
+		}
+	}
+
+	if (arguments.empty() || ((command == "list" || command == "prune") && arguments.size() != 1) || (command == "backup" && arguments.size() < 2)) {
+		printUsage(argv[0]);
+		return RETURN_PARAMETER_ISSUE;
+	}
+	if (options.compress && !ChunkStore::compressionAvailable()) {
+		std::cerr << "Error: mcsbackup was built without zstd, -z is not available" << std::endl;
+		return RETURN_PARAMETER_ISSUE;
+	}
+	ChunkStore store(arguments[0]);
+
+	try {
+		if (command == "list") {
+			listBackups(store);
+			return RETURN_SUCCESS;
+		}
+		if (command == "prune") {
+			store.lock(true);
+			pruneBackups(store, keep);
+			return RETURN_SUCCESS;
+		}
+		if (command == "restore") {
+			// prune must not remove the backup while it is restored
+			store.lock(false);
+			RestoreOptions restore_options;
+			restore_options.name = options.name.empty() ? store.latestBackup() : options.name;
+			restore_options.threads = options.threads;
+			restore_options.progress_interval = options.progress_interval;
+			restore_options.checksum = options.checksum;
+			restore_options.keep_extra = keep_extra;
+			restore_options.verbose = options.verbose;
+			struct stat st;
+			if (restore_options.name.empty() || stat(store.manifestPath(restore_options.name).c_str(), &st) != 0) {
+				std::cerr << "Error: there is no backup " << (options.name.empty() ? "" : "named " + options.name + " ") << "in " << store.path() << std::endl;
+				return RETURN_PARAMETER_ISSUE;
+			}
+			BackupManifest manifest;
+			manifest.load(store.manifestPath(restore_options.name));
+			for (size_t i = 1; i < arguments.size(); i++) {
+				std::string label;
+				std::string directory = arguments[i];
+				size_t equals = directory.find('=');
+				if (equals != std::string::npos) {
+					label = directory.substr(0, equals);
+					directory = directory.substr(equals + 1);
+				}
+				else if (manifest.sources.size() == 1) {
+					label = manifest.sources.begin()->first;
+				}
+				else {
+					std::cerr << "Error: the backup has more than one source, the target directory " << directory << " needs a label" << std::endl;
+					return RETURN_PARAMETER_ISSUE;
+				}
+				if (manifest.sources.count(label) == 0) {
+					std::cerr << "Error: the backup has no source labeled " << label << std::endl;
+					return RETURN_PARAMETER_ISSUE;
+				}
+				while (directory.size() > 1 && directory.back() == '/') {
+					directory.pop_back();
+				}
+				restore_options.targets[label] = directory;
+			}
+			if (restore_options.targets.empty()) {
+				restore_options.targets = manifest.sources;
+			}
+			Restore restore(restore_options, store, manifest);
+			restore.run();
+			return RETURN_SUCCESS;
+		}
+
+		for (size_t i = 1; i < arguments.size(); i++) {
+			std::string label;
+			std::string directory = arguments[i];
+			size_t equals = directory.find('=');
+			if (equals != std::string::npos) {
+				label = directory.substr(0, equals);
+				directory = directory.substr(equals + 1);
+			}
+			while (directory.size() > 1 && directory.back() == '/') {
+				directory.pop_back();
+			}
+			if (label.empty()) {
+				label = directory.substr(directory.find_last_of('/') + 1);
+			}
+			struct stat st;
+			if (stat(directory.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+				std::cerr << "Error: source directory " << directory << " doesn't exist" << std::endl;
+				return RETURN_PARAMETER_ISSUE;
+			}
+			if (label.empty() || label.find_first_of("/ \n") != std::string::npos) {
+				std::cerr << "Error: invalid label " << label << " of source directory " << directory << std::endl;
+				return RETURN_PARAMETER_ISSUE;
+			}
+			for (auto const& s : options.sources) {
+				if (s.first == label) {
+					std::cerr << "Error: the label " << label << " is used for more than one source directory" << std::endl;
+					return RETURN_PARAMETER_ISSUE;
+				}
+			}
+			// the manifest records the absolute path, that a restore can default to
+			char resolved[PATH_MAX];
+			if (realpath(directory.c_str(), resolved) != nullptr) {
+				directory = resolved;
+			}
+			options.sources.push_back(std::make_pair(label, directory));
+		}
+		if (options.name.empty()) {
+			std::time_t now = std::time(nullptr);
+			char buffer[32];
+			std::strftime(buffer, sizeof(buffer), "backup-%Y%m%d-%H%M%S", std::localtime(&now));
+			options.name = buffer;
+		}
+
+		store.create();
+		store.lock(true);
+		struct stat st;
+		if (stat(store.manifestPath(options.name).c_str(), &st) == 0) {
+			std::cerr << "Error: a backup named " << options.name << " already exists in " << store.path() << std::endl;
+			return RETURN_PARAMETER_ISSUE;
+		}
+		Backup backup(options, store);
+		backup.run();
+	}
+	catch (std::exception& e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return RETURN_IO_ERROR;
+	}
+	return RETURN_SUCCESS;
+}
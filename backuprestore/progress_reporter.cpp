@@ -0,0 +1,45 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#include "progress_reporter.h"
+
+#include <chrono>
+
+ProgressReporter::ProgressReporter(std::uint32_t interval, std::function<void()> report_function) : report(report_function) {
+	if (interval > 0) {
+		this->thread = std::thread(&ProgressReporter::loop, this, interval);
+	}
+}
+
+ProgressReporter::~ProgressReporter() {
+	stop();
+}
+
+void ProgressReporter::stop() {
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopped = true;
+	}
+	this->condition.notify_all();
+	if (this->thread.joinable()) {
+		this->thread.join();
+	}
+}
+
+void ProgressReporter::loop(std::uint32_t interval) {
+	std::unique_lock<std::mutex> lock(this->mutex);
+	while (!this->condition.wait_for(lock, std::chrono::seconds(interval), [this] { return this->stopped; })) {
+		this->report();
+	}
+}
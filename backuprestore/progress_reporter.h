@@ -0,0 +1,48 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/**
+* Calls a function on a thread of its own every interval seconds, to print the
+* progress of a backup or restore while its workers are busy.
+*/
+class ProgressReporter {
+public:
+	/*
+	* starts the reports, unless interval is 0
+	*/
+	ProgressReporter(std::uint32_t interval, std::function<void()> report_function);
+	~ProgressReporter();
+
+	/*
+	* stops the reports. the function isn't called anymore once it returns.
+	*/
+	void stop();
+
+private:
+	std::function<void()> report;
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool stopped = false;
+	std::thread thread;
+
+	void loop(std::uint32_t interval);
+};
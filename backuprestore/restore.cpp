@@ -0,0 +1,386 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#include "restore.h"
+#include "backup.h"
+#include "progress_reporter.h"
+#include "sha256.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+* creates a directory and its missing parents
+*/
+static void makeDirectories(const std::string& path, mode_t mode) {
+	struct stat st;
+	if (stat(path.c_str(), &st) == 0) {
+		if (!S_ISDIR(st.st_mode)) {
+			throw std::runtime_error("Can't restore directory " + path + ", a file of the same name exists");
+		}
+		return;
+	}
+	size_t slash = path.find_last_of('/');
+	if (slash != std::string::npos && slash > 0) {
+		makeDirectories(path.substr(0, slash), 0755);
+	}
+	if (mkdir(path.c_str(), mode) != 0 && errno != EEXIST) {
+		throw std::runtime_error("Can't create directory " + path + ": " + std::strerror(errno));
+	}
+}
+
+/*
+* removes a file, or a directory with all its content, without following symbolic links
+*/
+static void removeAll(const std::string& path) {
+	struct stat st;
+	if (lstat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+		DIR* dir = opendir(path.c_str());
+		if (dir == nullptr) {
+			throw std::runtime_error("Can't read directory " + path + ": " + std::strerror(errno));
+		}
+		std::vector<std::string> names;
+		while (struct dirent* entry = readdir(dir)) {
+			if (std::strcmp(entry->d_name, ".") != 0 && std::strcmp(entry->d_name, "..") != 0) {
+				names.push_back(entry->d_name);
+			}
+		}
+		closedir(dir);
+		// a read-only directory can't be emptied
+		chmod(path.c_str(), 0700);
+		for (auto const& name : names) {
+			removeAll(path + "/" + name);
+		}
+		if (rmdir(path.c_str()) != 0) {
+			throw std::runtime_error("Can't remove directory " + path + ": " + std::strerror(errno));
+		}
+	}
+	else if (std::remove(path.c_str()) != 0 && errno != ENOENT) {
+		throw std::runtime_error("Can't remove " + path + ": " + std::strerror(errno));
+	}
+}
+
+void Restore::removeExtraFiles() {
+	for (auto const& t : this->options.targets) {
+		struct stat st;
+		if (stat(t.second.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+			continue;
+		}
+		std::set<std::string> files;
+		std::set<std::string> directories;
+		for (auto const& f : this->manifest.files) {
+			if (f.source == t.first) {
+				files.insert(f.path);
+			}
+		}
+		for (auto const& d : this->manifest.directories) {
+			if (d.source == t.first) {
+				directories.insert(d.path);
+			}
+		}
+		removeExtraFiles(t.second, "", files, directories);
+	}
+}
+
+void Restore::removeExtraFiles(const std::string& directory, const std::string& relative, const std::set<std::string>& files, const std::set<std::string>& directories) {
+	static const std::string tmp_suffix = ".mcsrestore";
+	std::string path = relative.empty() ? directory : directory + "/" + relative;
+	DIR* dir = opendir(path.c_str());
+	if (dir == nullptr) {
+		throw std::runtime_error("Can't read directory " + path + ": " + std::strerror(errno));
+	}
+	std::vector<std::string> names;
+	while (struct dirent* entry = readdir(dir)) {
+		if (std::strcmp(entry->d_name, ".") != 0 && std::strcmp(entry->d_name, "..") != 0) {
+			names.push_back(entry->d_name);
+		}
+	}
+	closedir(dir);
+	for (auto const& name : names) {
+		// the temporary files of an interrupted restore are replaced by the files they were written for
+		if (name.size() > tmp_suffix.size() && name.compare(name.size() - tmp_suffix.size(), tmp_suffix.size(), tmp_suffix) == 0) {
+			continue;
+		}
+		std::string entry = relative.empty() ? name : relative + "/" + name;
+		struct stat st;
+		// like the backup, symbolic links in place of backed up files and directories are followed
+		bool exists = stat((directory + "/" + entry).c_str(), &st) == 0;
+		if (exists && S_ISDIR(st.st_mode) && directories.count(entry) > 0) {
+			removeExtraFiles(directory, entry, files, directories);
+		}
+		else if (!exists || S_ISDIR(st.st_mode) || files.count(entry) == 0) {
+			if (this->options.verbose) {
+				std::cout << "Removing " << directory << "/" << entry << ", it isn't in the backup" << std::endl;
+			}
+			removeAll(directory + "/" + entry);
+			this->extra_removed++;
+		}
+	}
+}
+
+void Restore::createDirectories() {
+	for (auto const& t : this->options.targets) {
+		makeDirectories(t.second, 0755);
+	}
+	// writable until the files are restored, the modes of the backup are set afterwards
+	for (auto const& d : this->manifest.directories) {
+		auto it = this->options.targets.find(d.source);
+		if (it != this->options.targets.end()) {
+			makeDirectories(it->second + "/" + d.path, 0700);
+		}
+	}
+}
+
+void Restore::fail(const std::string& message) {
+	std::lock_guard<std::mutex> lock(this->error_mutex);
+	if (!this->failed.exchange(true)) {
+		this->error = message;
+	}
+}
+
+bool Restore::takeFile(size_t home, size_t& file, std::string& directory) {
+	FileQueue* queue = this->queues[home].get();
+	std::unique_lock<std::mutex> lock(queue->mutex);
+	if (queue->files.empty()) {
+		lock.unlock();
+		// steal from the queue with the most bytes left
+		queue = nullptr;
+		std::uint64_t most = 0;
+		for (auto const& q : this->queues) {
+			std::lock_guard<std::mutex> other_lock(q->mutex);
+			if (!q->files.empty() && (queue == nullptr || q->remaining_bytes > most)) {
+				queue = q.get();
+				most = q->remaining_bytes;
+			}
+		}
+		if (queue == nullptr) {
+			return false;
+		}
+		lock = std::unique_lock<std::mutex>(queue->mutex);
+		if (queue->files.empty()) {
+			// taken by another thread in the meantime
+			lock.unlock();
+			return takeFile(home, file, directory);
+		}
+	}
+	file = queue->files.front();
+	queue->files.pop_front();
+	queue->remaining_bytes -= this->manifest.files[file].size;
+	directory = queue->directory;
+	return true;
+}
+
+bool Restore::matches(const ManifestFile& f, const std::string& path, std::vector<char>& buffer) {
+	struct stat st;
+	if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode) || (std::uint64_t) st.st_size != f.size) {
+		return false;
+	}
+	if (!this->options.checksum) {
+		return modificationTime(st) == f.mtime;
+	}
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	bool equal = true;
+	std::uint64_t offset = 0;
+	for (auto const& c : f.chunks) {
+		buffer.resize(c.length);
+		ssize_t r = pread(fd, buffer.data(), c.length, (off_t) offset);
+		if (r != (ssize_t) c.length || Sha256::hash(buffer.data(), c.length) != c.hash) {
+			equal = false;
+			break;
+		}
+		offset += c.length;
+	}
+	close(fd);
+	if (equal && modificationTime(st) != f.mtime) {
+		struct timespec times[2];
+		times[0].tv_sec = times[1].tv_sec = (time_t) (f.mtime / 1000000000);
+		times[0].tv_nsec = times[1].tv_nsec = (long) (f.mtime % 1000000000);
+		utimensat(AT_FDCWD, path.c_str(), times, 0);
+	}
+	return equal;
+}
+
+void Restore::writeFile(const ManifestFile& f, const std::string& path, std::vector<char>& buffer) {
+	size_t slash = path.find_last_of('/');
+	std::string tmpFile = path.substr(0, slash + 1) + "." + path.substr(slash + 1) + ".mcsrestore";
+	int fd = open(tmpFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if (fd < 0) {
+		throw std::runtime_error("Can't create " + tmpFile + ": " + std::strerror(errno));
+	}
+	try {
+		Sha256 file_hash;
+		for (auto const& c : f.chunks) {
+			this->store.get(c.hash, buffer);
+			if (buffer.size() != c.length || Sha256::hash(buffer.data(), buffer.size()) != c.hash) {
+				throw std::runtime_error("Chunk " + c.hash + " of " + f.source + "/" + f.path + " doesn't match its hash, the chunk store is damaged");
+			}
+			size_t written = 0;
+			while (written < buffer.size()) {
+				ssize_t w = write(fd, buffer.data() + written, buffer.size() - written);
+				if (w < 0 && errno == EINTR) {
+					continue;
+				}
+				if (w < 0) {
+					throw std::runtime_error("Can't write " + tmpFile + ": " + std::strerror(errno));
+				}
+				written += (size_t) w;
+			}
+			file_hash.update(c.hash.data(), c.hash.size());
+			this->chunks_verified++;
+			this->bytes_written += c.length;
+			this->bytes_done += c.length;
+		}
+		if (file_hash.hexDigest() != f.hash) {
+			throw std::runtime_error("The chunks of " + f.source + "/" + f.path + " don't match its hash, the manifest is damaged");
+		}
+		struct timespec times[2];
+		times[0].tv_sec = times[1].tv_sec = (time_t) (f.mtime / 1000000000);
+		times[0].tv_nsec = times[1].tv_nsec = (long) (f.mtime % 1000000000);
+		if (fchmod(fd, (mode_t) f.mode) != 0 || futimens(fd, times) != 0 || fsync(fd) != 0) {
+			throw std::runtime_error("Can't write " + tmpFile + ": " + std::strerror(errno));
+		}
+	}
+	catch (...) {
+		close(fd);
+		std::remove(tmpFile.c_str());
+		throw;
+	}
+	if (close(fd) != 0 || std::rename(tmpFile.c_str(), path.c_str()) != 0) {
+		std::remove(tmpFile.c_str());
+		throw std::runtime_error("Can't write " + path + ": " + std::strerror(errno));
+	}
+}
+
+void Restore::restoreFiles(size_t home) {
+	std::vector<char> buffer;
+	size_t file;
+	std::string directory;
+	while (!this->failed && takeFile(home, file, directory)) {
+		const ManifestFile& f = this->manifest.files[file];
+		std::string path = directory + "/" + f.path;
+		try {
+			if (matches(f, path, buffer)) {
+				if (this->options.verbose) {
+					std::cout << "Skipping " << path << ", it matches the backup" << std::endl;
+				}
+				this->files_skipped++;
+				this->bytes_done += f.size;
+			}
+			else {
+				if (this->options.verbose) {
+					std::cout << "Restoring " << path << std::endl;
+				}
+				writeFile(f, path, buffer);
+			}
+			this->files_done++;
+		}
+		catch (std::exception& e) {
+			fail(e.what());
+		}
+	}
+}
+
+void Restore::run() {
+	auto start = std::chrono::steady_clock::now();
+	if (!this->options.keep_extra) {
+		removeExtraFiles();
+	}
+	createDirectories();
+
+	std::map<std::string, FileQueue*> queue_of_source;
+	for (auto const& t : this->options.targets) {
+		this->queues.push_back(std::unique_ptr<FileQueue>(new FileQueue()));
+		this->queues.back()->directory = t.second;
+		queue_of_source[t.first] = this->queues.back().get();
+	}
+	std::vector<size_t> files;
+	for (size_t i = 0; i < this->manifest.files.size(); i++) {
+		if (queue_of_source.count(this->manifest.files[i].source) > 0) {
+			files.push_back(i);
+		}
+	}
+	std::stable_sort(files.begin(), files.end(), [this](size_t a, size_t b) { return this->manifest.files[a].size > this->manifest.files[b].size; });
+	for (size_t i : files) {
+		FileQueue* queue = queue_of_source[this->manifest.files[i].source];
+		queue->files.push_back(i);
+		queue->remaining_bytes += this->manifest.files[i].size;
+		this->bytes_to_restore += this->manifest.files[i].size;
+	}
+	this->files_to_restore = files.size();
+	std::cout << "Restoring " << this->files_to_restore << " files (" << this->bytes_to_restore << " bytes) of backup " << this->options.name << std::endl;
+
+	// each thread starts on the queue with the most bytes per thread
+	size_t thread_count = std::max<size_t>(std::min<size_t>(this->options.threads, this->files_to_restore), 1);
+	std::vector<size_t> homes;
+	std::vector<size_t> threads_of_queue(this->queues.size(), 0);
+	for (size_t t = 0; t < thread_count; t++) {
+		size_t best = 0;
+		for (size_t q = 1; q < this->queues.size(); q++) {
+			if ((double) this->queues[q]->remaining_bytes / (threads_of_queue[q] + 1) > (double) this->queues[best]->remaining_bytes / (threads_of_queue[best] + 1)) {
+				best = q;
+			}
+		}
+		threads_of_queue[best]++;
+		homes.push_back(best);
+	}
+
+	ProgressReporter reporter(this->options.progress_interval, [this, start] {
+		std::uint64_t done = this->bytes_done;
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << "Progress: " << std::fixed << std::setprecision(1) << (this->bytes_to_restore > 0 ? 100.0 * done / this->bytes_to_restore : 100.0) << "% (" << done << " of " << this->bytes_to_restore << " bytes, " << (this->bytes_written / MIB / seconds) << " MB/s, " << this->files_done << " of " << this->files_to_restore << " files)" << std::endl;
+	});
+	std::vector<std::thread> workers;
+	for (size_t home : homes) {
+		workers.push_back(std::thread(&Restore::restoreFiles, this, home));
+	}
+	for (auto& w : workers) {
+		w.join();
+	}
+	reporter.stop();
+	if (this->failed) {
+		throw std::runtime_error(this->error);
+	}
+
+	// children before their parents, so a read-only parent doesn't keep its children from being changed
+	for (auto it = this->manifest.directories.rbegin(); it != this->manifest.directories.rend(); ++it) {
+		auto target = this->options.targets.find(it->source);
+		if (target != this->options.targets.end() && chmod((target->second + "/" + it->path).c_str(), (mode_t) it->mode) != 0) {
+			throw std::runtime_error("Can't set the mode of directory " + target->second + "/" + it->path + ": " + std::strerror(errno));
+		}
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "Restore of " << this->options.name << " completed" << std::endl;
+	std::cout << "Files: " << this->files_to_restore << " (" << this->files_skipped << " already matching)" << std::endl;
+	if (!this->options.keep_extra) {
+		std::cout << "Removed: " << this->extra_removed << " files and directories not in the backup" << std::endl;
+	}
+	std::cout << "Bytes: " << this->bytes_to_restore << " (" << this->bytes_written << " written)" << std::endl;
+	std::cout << "Chunks verified: " << this->chunks_verified << std::endl;
+	std::cout << "Execution time: " << std::fixed << std::setprecision(3) << seconds << "s (" << std::setprecision(1) << (seconds > 0 ? this->bytes_written / MIB / seconds : 0) << " MB/s)" << std::endl;
+}
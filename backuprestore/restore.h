@@ -0,0 +1,100 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#pragma once
+
+#include "backup_manifest.h"
+#include "chunk_store.h"
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+* The options of a restore.
+*/
+struct RestoreOptions {
+	std::string name; // of the backup
+	std::map<std::string, std::string> targets; // source label, directory to restore it to
+	std::uint32_t threads = 5;
+	std::uint32_t progress_interval = 5; // seconds, 0 disables the progress output
+	bool checksum = false;
+	bool keep_extra = false; // leave the files of the targets that aren't in the backup
+	bool verbose = false;
+};
+
+/**
+* Restores the files of a backup from a chunk store. Each target directory, e.g.
+* a DBRoot, has a queue of its files, largest first. The worker threads start on
+* the queues in proportion to their bytes and steal from the queue with the most
+* bytes left once theirs is empty, so that a target with few large files doesn't
+* finish long after the others. Every chunk is checked against its hash and every
+* file against the hash of its chunks while it is written, so a restore needs no
+* second read pass. Files are written to a temporary file that is renamed once
+* complete and given the modification time of the backup, so a restore that is
+* started again skips the files that already match the backup. Files and
+* directories of the targets that aren't in the backup are removed beforehand.
+*/
+class Restore {
+public:
+	Restore(const RestoreOptions& restore_options, ChunkStore& chunk_store, const BackupManifest& backup_manifest) : options(restore_options), store(chunk_store), manifest(backup_manifest) {}
+
+	/*
+	* runs the restore and prints its summary. throws std::runtime_error on I/O errors or damaged chunks.
+	*/
+	void run();
+
+private:
+	/**
+	* The files still to restore into one target directory.
+	*/
+	struct FileQueue {
+		std::string directory;
+		std::mutex mutex;
+		std::deque<size_t> files; // indexes into the manifest files, largest first
+		std::uint64_t remaining_bytes = 0;
+	};
+
+	const RestoreOptions& options;
+	ChunkStore& store;
+	const BackupManifest& manifest;
+	std::vector<std::unique_ptr<FileQueue>> queues;
+	std::uint64_t bytes_to_restore = 0;
+	size_t files_to_restore = 0;
+
+	std::atomic<std::uint64_t> bytes_done{0};
+	std::atomic<std::uint64_t> bytes_written{0};
+	std::atomic<std::uint64_t> chunks_verified{0};
+	std::atomic<size_t> files_done{0};
+	std::atomic<size_t> files_skipped{0};
+	size_t extra_removed = 0;
+	std::atomic<bool> failed{false};
+	std::mutex error_mutex;
+	std::string error;
+
+	void removeExtraFiles();
+	void removeExtraFiles(const std::string& directory, const std::string& relative, const std::set<std::string>& files, const std::set<std::string>& directories);
+	void createDirectories();
+	bool takeFile(size_t home, size_t& file, std::string& directory);
+	void restoreFiles(size_t home);
+	bool matches(const ManifestFile& f, const std::string& path, std::vector<char>& buffer);
+	void writeFile(const ManifestFile& f, const std::string& path, std::vector<char>& buffer);
+	void fail(const std::string& message);
+};
@@ -0,0 +1,123 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#include "sha256.h"
+
+#include <algorithm>
+#include <cstring>
+
+static const std::uint32_t ROUND_CONSTANTS[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static inline std::uint32_t rotateRight(std::uint32_t value, unsigned bits) {
+	return (value >> bits) | (value << (32 - bits));
+}
+
+Sha256::Sha256() {
+	static const std::uint32_t initial_state[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+	std::memcpy(this->state, initial_state, sizeof(this->state));
+}
+
+void Sha256::transform(const std::uint8_t* data) {
+	std::uint32_t w[64];
+	for (unsigned i = 0; i < 16; i++) {
+		w[i] = ((std::uint32_t) data[4 * i] << 24) | ((std::uint32_t) data[4 * i + 1] << 16) | ((std::uint32_t) data[4 * i + 2] << 8) | data[4 * i + 3];
+	}
+	for (unsigned i = 16; i < 64; i++) {
+		std::uint32_t s0 = rotateRight(w[i - 15], 7) ^ rotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+		std::uint32_t s1 = rotateRight(w[i - 2], 17) ^ rotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+		w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+	}
+	std::uint32_t a = this->state[0], b = this->state[1], c = this->state[2], d = this->state[3];
+	std::uint32_t e = this->state[4], f = this->state[5], g = this->state[6], h = this->state[7];
+	for (unsigned i = 0; i < 64; i++) {
+		std::uint32_t s1 = rotateRight(e, 6) ^ rotateRight(e, 11) ^ rotateRight(e, 25);
+		std::uint32_t choice = (e & f) ^ (~e & g);
+		std::uint32_t t1 = h + s1 + choice + ROUND_CONSTANTS[i] + w[i];
+		std::uint32_t s0 = rotateRight(a, 2) ^ rotateRight(a, 13) ^ rotateRight(a, 22);
+		std::uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+		std::uint32_t t2 = s0 + majority;
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+	this->state[0] += a;
+	this->state[1] += b;
+	this->state[2] += c;
+	this->state[3] += d;
+	this->state[4] += e;
+	this->state[5] += f;
+	this->state[6] += g;
+	this->state[7] += h;
+}
+
+void Sha256::update(const void* data, size_t length) {
+	const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+	this->total_length += length;
+	// complete a partial block first, then hash whole blocks straight from the input
+	if (this->block_length > 0) {
+		size_t n = std::min(length, sizeof(this->block) - this->block_length);
+		std::memcpy(this->block + this->block_length, bytes, n);
+		this->block_length += n;
+		bytes += n;
+		length -= n;
+		if (this->block_length < sizeof(this->block)) {
+			return;
+		}
+		transform(this->block);
+		this->block_length = 0;
+	}
+	for (; length >= sizeof(this->block); bytes += sizeof(this->block), length -= sizeof(this->block)) {
+		transform(bytes);
+	}
+	std::memcpy(this->block, bytes, length);
+	this->block_length = length;
+}
+
+std::string Sha256::hexDigest() {
+	std::uint64_t bit_length = this->total_length * 8;
+	std::uint8_t padding[72] = { 0x80 };
+	size_t padding_length = (this->block_length < 56 ? 56 : 120) - this->block_length;
+	for (unsigned i = 0; i < 8; i++) {
+		padding[padding_length + i] = (std::uint8_t) (bit_length >> (56 - 8 * i));
+	}
+	update(padding, padding_length + 8);
+	static const char digits[] = "0123456789abcdef";
+	std::string hex;
+	for (unsigned i = 0; i < 8; i++) {
+		for (int shift = 28; shift >= 0; shift -= 4) {
+			hex += digits[(this->state[i] >> shift) & 0xf];
+		}
+	}
+	return hex;
+}
+
+std::string Sha256::hash(const void* data, size_t length) {
+	Sha256 sha;
+	sha.update(data, length);
+	return sha.hexDigest();
+}
@@ -0,0 +1,51 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/**
+* Computes the SHA-256 digest of a byte stream, that names the chunks of a backup.
+*/
+class Sha256 {
+public:
+	static const size_t DIGEST_SIZE = 32;
+
+	Sha256();
+
+	/*
+	* appends the given bytes to the hashed stream
+	*/
+	void update(const void* data, size_t length);
+
+	/*
+	* finishes the stream and returns its digest as 64 lowercase hex digits. the object can't be updated afterwards.
+	*/
+	std::string hexDigest();
+
+	/*
+	* returns the hex digest of the given bytes
+	*/
+	static std::string hash(const void* data, size_t length);
+
+private:
+	std::uint32_t state[8];
+	std::uint8_t block[64];
+	size_t block_length = 0;
+	std::uint64_t total_length = 0;
+
+	void transform(const std::uint8_t* data);
+};
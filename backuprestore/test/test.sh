@@ -0,0 +1,145 @@
+#!/bin/bash
+#
+# Round trip test of mcsbackup on temporary directories: backs up a source
+# directory, backs it up again incrementally, restores both backups, repairs a
+# restored file with --checksum, removes files that aren't in the backup,
+# rewrites a damaged chunk and prunes the store.
+#
+# Usage: test.sh path/to/mcsbackup
+
+MCSBACKUP="$1"
+if [ -z "$MCSBACKUP" ] || [ ! -x "$MCSBACKUP" ]; then
+    echo "Usage: $0 path/to/mcsbackup"
+    exit 1
+fi
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+SOURCE="$WORK/source"
+STORE="$WORK/store"
+FAILED=0
+
+# reports a failed check and continues with the next one
+fail() {
+    echo "FAILED: $1"
+    FAILED=$((FAILED + 1))
+}
+
+# runs mcsbackup quietly and fails the test if it doesn't return the expected code
+run() {
+    local expected=$1
+    shift
+    "$MCSBACKUP" "$@" --progress=0 > "$WORK/output" 2>&1
+    local result=$?
+    if [ $result -ne $expected ]; then
+        cat "$WORK/output"
+        fail "mcsbackup $* returned $result instead of $expected"
+    fi
+}
+
+# fails the test if the two directories differ
+same() {
+    if ! diff -r "$1" "$2" > /dev/null; then
+        fail "$3: $1 and $2 differ"
+    fi
+}
+
+chunkCount() {
+    find "$STORE/chunks" -type f -name "????????????????????????????????????????????????????????????????" | wc -l
+}
+
+# the source spans several chunks of 1 MB and nested directories
+mkdir -p "$SOURCE/data1/000.dir/000.dir" "$SOURCE/data2" "$SOURCE/empty"
+head -c 3500000 /dev/urandom > "$SOURCE/data1/000.dir/000.dir/FILE000.cdf"
+head -c 100000 /dev/urandom > "$SOURCE/data1/000.dir/FILE001.cdf"
+echo "dbroot 2" > "$SOURCE/data2/small"
+: > "$SOURCE/data2/zero"
+
+echo "Full backup"
+run 0 backup --name=full --chunk-size=1 "$STORE" "$SOURCE"
+cp -a "$SOURCE" "$WORK/full_source"
+grep -q "^Chunks: 6 (6 new)" "$WORK/output" || fail "the full backup didn't store 6 new chunks"
+FULL_CHUNKS=$(chunkCount)
+
+echo "Incremental backup"
+sleep 1
+head -c 100000 /dev/urandom > "$SOURCE/data1/000.dir/FILE001.cdf"
+echo "added" > "$SOURCE/data2/added"
+run 0 backup --name=incremental --chunk-size=1 "$STORE" "$SOURCE"
+grep -q "^Files: 5 (3 unchanged)" "$WORK/output" || fail "the incremental backup didn't reuse the 3 unchanged files"
+grep -q "^Chunks: 7 (2 new)" "$WORK/output" || fail "the incremental backup didn't store 2 new chunks"
+[ $(chunkCount) -eq $((FULL_CHUNKS + 2)) ] || fail "the store doesn't hold the 2 new chunks"
+run 0 list "$STORE"
+grep -q "^incremental (latest)" "$WORK/output" || fail "the incremental backup isn't the latest"
+run 1 backup --name=full "$STORE" "$SOURCE"
+
+echo "Restore"
+run 0 restore "$STORE" "$WORK/restored"
+same "$SOURCE" "$WORK/restored" "restore of the latest backup"
+run 0 restore --name=full "$STORE" "$WORK/restored_full"
+same "$WORK/full_source" "$WORK/restored_full" "restore of the full backup"
+run 1 restore --name=missing "$STORE" "$WORK/restored_missing"
+
+echo "Restore with --checksum"
+# a changed file with the size and modification time of the backup is only found by its content
+FILE="$WORK/restored/data1/000.dir/000.dir/FILE000.cdf"
+printf 'XXXX' | dd of="$FILE" bs=1 seek=2000000 conv=notrunc 2> /dev/null
+touch -r "$SOURCE/data1/000.dir/000.dir/FILE000.cdf" "$FILE"
+run 0 restore "$STORE" "$WORK/restored"
+cmp -s "$SOURCE/data1/000.dir/000.dir/FILE000.cdf" "$FILE" && fail "a restore without --checksum compared the file by content"
+run 0 restore --checksum "$STORE" "$WORK/restored"
+same "$SOURCE" "$WORK/restored" "restore with --checksum"
+
+echo "Extra files"
+# files and directories the backup doesn't have are removed, the temporary files of an interrupted restore are left
+RESTORED="$WORK/restored"
+echo "extra" > "$RESTORED/data2/extra"
+mkdir -p "$RESTORED/data3/000.dir"
+echo "extra" > "$RESTORED/data3/000.dir/FILE000.cdf"
+chmod 500 "$RESTORED/data3/000.dir"
+echo "partial" > "$RESTORED/data1/.FILE002.cdf.mcsrestore"
+run 0 restore --keep-extra "$STORE" "$RESTORED"
+[ -f "$RESTORED/data2/extra" ] && [ -d "$RESTORED/data3" ] || fail "a restore with --keep-extra removed files that aren't in the backup"
+# a directory in place of a backed up file is removed as well
+rm "$RESTORED/data2/small"
+mkdir "$RESTORED/data2/small"
+run 0 restore "$STORE" "$RESTORED"
+grep -q "^Removed: 3 " "$WORK/output" || fail "the restore didn't remove the 3 files and directories that aren't in the backup"
+[ -f "$RESTORED/data1/.FILE002.cdf.mcsrestore" ] || fail "the restore removed a temporary file of an interrupted restore"
+rm "$RESTORED/data1/.FILE002.cdf.mcsrestore"
+same "$SOURCE" "$RESTORED" "restore into a target with extra files"
+
+echo "Damaged chunk"
+CHUNK=$(find "$STORE/chunks" -type f -size +500k | head -n 1)
+truncate -s 1000 "$CHUNK"
+run 2 restore "$STORE" "$WORK/restored_damaged"
+# the next backup finds the chunk incomplete and writes it again
+run 0 backup --name=repaired --chunk-size=1 --checksum "$STORE" "$SOURCE"
+run 0 restore "$STORE" "$WORK/restored_repaired"
+same "$SOURCE" "$WORK/restored_repaired" "restore after the damaged chunk was written again"
+
+echo "Prune"
+run 0 prune --keep=1 "$STORE"
+grep -q "^Backups removed: 2" "$WORK/output" || fail "prune didn't remove 2 backups"
+grep -q "^Chunks removed: 1 " "$WORK/output" || fail "prune didn't remove the 1 chunk only the full backup referred to"
+run 0 list "$STORE"
+grep -q "^repaired (latest)" "$WORK/output" || fail "prune didn't keep the latest backup"
+[ $(wc -l < "$WORK/output") -eq 1 ] || fail "prune kept more than 1 backup"
+run 0 restore "$STORE" "$WORK/restored_pruned"
+same "$SOURCE" "$WORK/restored_pruned" "restore after prune"
+
+if which flock > /dev/null 2>&1; then
+    echo "Lock"
+    flock "$STORE/lock" sleep 2 &
+    sleep 0.5
+    run 0 prune --keep=1 "$STORE"
+    grep -q "^Waiting for another mcsbackup" "$WORK/output" || fail "prune didn't wait for the lock of the store"
+    wait
+fi
+
+if [ $FAILED -ne 0 ]; then
+    echo "$FAILED checks failed"
+    exit 1
+fi
+echo "All checks passed"
+exit 0
@@ -0,0 +1,37 @@
+# Standard FIND_PACKAGE module for zstd, sets the following variables:
+#   - ZSTD_FOUND
+#   - ZSTD_INCLUDE_DIRS (only if ZSTD_FOUND)
+#   - ZSTD_LIBRARIES (only if ZSTD_FOUND)
+
+IF(UNIX)
+# Try to find the header
+FIND_PATH(ZSTD_INCLUDE_DIR NAMES zstd.h)
+
+# Try to find the library
+FIND_LIBRARY(ZSTD_LIBRARY NAMES zstd)
+ENDIF(UNIX)
+
+IF(WIN32)
+# Try to find the header
+FIND_PATH(ZSTD_INCLUDE_DIR NAMES zstd.h PATH_SUFFIXES include lib HINTS $ENV{ZSTD_INSTALL_DIR})
+
+# Try to find the library
+FIND_LIBRARY(ZSTD_LIBRARY NAMES zstd libzstd zstd_static PATH_SUFFIXES lib build/VS2010/bin/x64_Release HINTS $ENV{ZSTD_INSTALL_DIR})
+ENDIF(WIN32)
+
+# Handle the QUIETLY/REQUIRED arguments, set ZSTD_FOUND if all variables are
+# found
+INCLUDE(FindPackageHandleStandardArgs)
+FIND_PACKAGE_HANDLE_STANDARD_ARGS(ZSTD
+                                  REQUIRED_VARS
+                                  ZSTD_LIBRARY
+                                  ZSTD_INCLUDE_DIR)
+
+# Hide internal variables
+MARK_AS_ADVANCED(ZSTD_INCLUDE_DIR ZSTD_LIBRARY)
+
+# Set standard variables
+IF(ZSTD_FOUND)
+    SET(ZSTD_INCLUDE_DIRS "${ZSTD_INCLUDE_DIR}")
+    SET(ZSTD_LIBRARIES "${ZSTD_LIBRARY}")
+ENDIF()
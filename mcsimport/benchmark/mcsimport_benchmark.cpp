@@ -0,0 +1,280 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+/*
+* Measures the csv import stages of mcsimport without a database. Synthetic csv files
+* of different widths, quoting densities and column type mixes are generated into the
+* given directory and imported into a NullRowSink, once on the calling thread and once
+* through the import pipeline. The widest files are also imported with only every
+* eighth column mapped, like a mapping file that picks a few columns of a wide extract. The rows and bytes per second of the whole import and of
+* each stage are printed per file.
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <libmcsapi/mcsapi.h>
+#include "csv_importer.h"
+#include "import_stats.h"
+#include "row_conversion.h"
+#include "row_sink.h"
+
+enum TypeMix { TYPES_INTEGER, TYPES_TEXT, TYPES_MIXED };
+enum Quoting { QUOTING_NONE, QUOTING_SOME, QUOTING_HEAVY };
+
+struct Scenario {
+	size_t columns;
+	Quoting quoting;
+	TypeMix types;
+	size_t mapped; // the number of mapped columns, spread evenly over the row, or 0 for all
+	char delimiter;
+};
+
+static const char* quotingName(Quoting quoting) {
+	switch (quoting) {
+	case QUOTING_NONE: return "none";
+	case QUOTING_SOME: return "some";
+	default: return "heavy";
+	}
+}
+
+static const char* typeMixName(TypeMix types) {
+	switch (types) {
+	case TYPES_INTEGER: return "integer";
+	case TYPES_TEXT: return "text";
+	default: return "mixed";
+	}
+}
+
+/*
+* returns the columnstore type of a column of the given type mix
+*/
+static mcsapi::columnstore_data_types_t columnType(TypeMix types, size_t col) {
+	static const mcsapi::columnstore_data_types_t mixed[] = { mcsapi::DATA_TYPE_BIGINT, mcsapi::DATA_TYPE_VARCHAR, mcsapi::DATA_TYPE_DECIMAL, mcsapi::DATA_TYPE_DOUBLE, mcsapi::DATA_TYPE_DATETIME, mcsapi::DATA_TYPE_INT };
+	switch (types) {
+	case TYPES_INTEGER: return mcsapi::DATA_TYPE_BIGINT;
+	case TYPES_TEXT: return mcsapi::DATA_TYPE_VARCHAR;
+	default: return mixed[col % (sizeof(mixed) / sizeof(mixed[0]))];
+	}
+}
+
+/*
+* appends a random value of the given type to line, enclosed in quotes if quote is set. text values that are quoted contain the delimiter, escaped quotes and line breaks.
+*/
+static void appendValue(std::string& line, mcsapi::columnstore_data_types_t type, bool quote, char delimiter, std::mt19937_64& random) {
+	char buffer[64];
+	switch (type) {
+	case mcsapi::DATA_TYPE_BIGINT:
+		std::snprintf(buffer, sizeof(buffer), "%lld", (long long) (random() % 2000000000000ULL) - 1000000000000LL);
+		break;
+	case mcsapi::DATA_TYPE_INT:
+		std::snprintf(buffer, sizeof(buffer), "%d", (int) (random() % 2000000) - 1000000);
+		break;
+	case mcsapi::DATA_TYPE_DECIMAL:
+		std::snprintf(buffer, sizeof(buffer), "%lld.%02d", (long long) (random() % 100000000), (int) (random() % 100));
+		break;
+	case mcsapi::DATA_TYPE_DOUBLE:
+		std::snprintf(buffer, sizeof(buffer), "%.6f", (double) (random() % 100000000) / 997.0);
+		break;
+	case mcsapi::DATA_TYPE_DATETIME:
+		std::snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d %02d:%02d:%02d", 1990 + (int) (random() % 30), 1 + (int) (random() % 12), 1 + (int) (random() % 28), (int) (random() % 24), (int) (random() % 60), (int) (random() % 60));
+		break;
+	default: {
+		static const char letters[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 ";
+		size_t length = 4 + random() % 24;
+		for (size_t i = 0; i < length && i < sizeof(buffer) - 1; i++) {
+			buffer[i] = letters[random() % (sizeof(letters) - 1)];
+		}
+		buffer[std::min(length, sizeof(buffer) - 1)] = '\0';
+		if (quote) {
+			// the delimiter, an escaped quote and a line break only survive if the field is enclosed
+			switch (random() % 3) {
+			case 0: buffer[length / 2] = delimiter; break;
+			case 1: line += "\"\"\""; line += buffer; line += "\""; return;
+			default: buffer[length / 2] = '\n'; break;
+			}
+		}
+		break;
+	}
+	}
+	if (quote) {
+		line += '"';
+		line += buffer;
+		line += '"';
+	}
+	else {
+		line += buffer;
+	}
+}
+
+/*
+* writes a csv file of at least the given size for the scenario and returns its number of rows
+*/
+static std::uint64_t generate(const std::string& file, const Scenario& scenario, std::uint64_t size) {
+	std::mt19937_64 random(scenario.columns * 31 + scenario.quoting * 7 + scenario.types);
+	unsigned quote_percent = scenario.quoting == QUOTING_NONE ? 0 : (scenario.quoting == QUOTING_SOME ? 10 : 60);
+	std::ofstream out(file, std::ios::binary | std::ios::trunc);
+	std::string line;
+	std::uint64_t written = 0;
+	std::uint64_t rows = 0;
+	while (written < size) {
+		line.clear();
+		for (size_t col = 0; col < scenario.columns; col++) {
+			if (col > 0) {
+				line += scenario.delimiter;
+			}
+			appendValue(line, columnType(scenario.types, col), random() % 100 < quote_percent, scenario.delimiter, random);
+		}
+		line += '\n';
+		out.write(line.data(), line.size());
+		written += line.size();
+		rows++;
+	}
+	if (!out) {
+		std::cerr << "Error: Can't write to benchmark file: " << file << std::endl;
+		std::exit(2);
+	}
+	return rows;
+}
+
+/*
+* imports the file into a NullRowSink and prints the rates of the import and its stages
+*/
+static void run(const std::string& name, const std::string& file, const Scenario& scenario, std::uint64_t rows, std::uint64_t bytes, unsigned threads) {
+	ConversionPlan plan;
+	size_t mapped = scenario.mapped > 0 ? scenario.mapped : scenario.columns;
+	for (size_t col = 0; col < mapped; col++) {
+		ColumnConversion conversion;
+		size_t csv_column = col * (scenario.columns / mapped);
+		conversion.csv_column = (std::int32_t) csv_column;
+		conversion.setColumnType(columnType(scenario.types, csv_column), 18, 2);
+		plan.addColumn(conversion);
+	}
+	ImportStats stats;
+	NullRowSink sink(mapped);
+	CsvImporter importer(scenario.delimiter, '"', '"', false, false, threads);
+	std::vector<std::string> first_row;
+	importer.open(std::vector<std::string>{ file }, first_row);
+	importer.setStats(&stats);
+	ImportStats::Clock::time_point start = ImportStats::Clock::now();
+	importer.import(sink, plan);
+	double seconds = std::chrono::duration<double>(ImportStats::Clock::now() - start).count();
+	if (importer.summary().rows_inserted != rows) {
+		std::cerr << "Error: " << importer.summary().rows_inserted << " of " << rows << " rows of " << file << " were imported" << std::endl;
+		std::exit(2);
+	}
+
+	std::cout << std::left << std::setw(32) << name << std::right << std::setw(3) << threads << std::fixed << std::setprecision(0) << std::setw(12) << rows / seconds << std::setprecision(1) << std::setw(9) << bytes / 1e6 / seconds;
+	for (int stage = 0; stage < ImportStats::STAGE_COUNT; stage++) {
+		double stage_seconds = stats.seconds((ImportStats::Stage) stage);
+		if (stage_seconds <= 0) {
+			continue;
+		}
+		std::cout << "  " << ImportStats::stageName((ImportStats::Stage) stage) << " " << std::setprecision(3) << stage_seconds << "s";
+		// committing and waiting don't process the input, so they have no throughput
+		if (stage != ImportStats::STAGE_COMMIT && stage != ImportStats::STAGE_WAIT) {
+			std::cout << " " << std::setprecision(1) << bytes / 1e6 / stage_seconds << "MB/s";
+		}
+	}
+	std::cout << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 2 || argc > 3) {
+		std::cerr << "Usage: " << argv[0] << " directory [megabytes_per_file]" << std::endl;
+		return 1;
+	}
+	std::string directory = argv[1];
+	std::uint64_t size = (argc == 3 ? std::strtoull(argv[2], nullptr, 10) : 8) * 1000 * 1000;
+	unsigned workers = std::max(2u, std::thread::hardware_concurrency());
+	std::string mkdir = "mkdir -p \"" + directory + "\"";
+#ifdef _WIN32
+	mkdir = "if not exist \"" + directory + "\" mkdir \"" + directory + "\"";
+#endif
+	if (std::system(mkdir.c_str()) != 0) {
+		std::cerr << "Error: Can't create benchmark directory: " << directory << std::endl;
+		return 2;
+	}
+
+	std::cout << "rows and bytes per second of the whole import, stage times are summed over the threads of a stage" << std::endl;
+	std::cout << std::left << std::setw(32) << "file" << std::right << std::setw(3) << "-j" << std::setw(12) << "rows/s" << std::setw(9) << "MB/s" << "  stages" << std::endl;
+	const size_t widths[] = { 4, 16, 64 };
+	const Quoting quotings[] = { QUOTING_NONE, QUOTING_SOME, QUOTING_HEAVY };
+	const TypeMix type_mixes[] = { TYPES_INTEGER, TYPES_TEXT, TYPES_MIXED };
+	for (TypeMix types : type_mixes) {
+		for (size_t columns : widths) {
+			for (Quoting quoting : quotings) {
+				// only text columns are quoted, so the other type mixes are measured without quotes
+				if (types == TYPES_INTEGER && quoting != QUOTING_NONE) {
+					continue;
+				}
+				Scenario scenario{ columns, quoting, types, 0, ',' };
+				std::string name = std::string(typeMixName(types)) + "_" + std::to_string(columns) + "_quoting_" + quotingName(quoting);
+				std::string file = directory + "/" + name + ".csv";
+				std::uint64_t rows = generate(file, scenario, size);
+				std::uint64_t bytes = 0;
+				{
+					std::ifstream in(file, std::ios::binary | std::ios::ate);
+					bytes = (std::uint64_t) in.tellg();
+				}
+				try {
+					run(name, file, scenario, rows, bytes, 0);
+					run(name, file, scenario, rows, bytes, workers);
+					if (columns == widths[2]) {
+						Scenario projected{ columns, quoting, types, columns / 8, ',' };
+						std::string projected_name = name + "_map_" + std::to_string(projected.mapped);
+						run(projected_name, file, projected, rows, bytes, 0);
+						run(projected_name, file, projected, rows, bytes, workers);
+					}
+				}
+				catch (std::exception& e) {
+					std::cerr << "Error: " << e.what() << std::endl;
+					return 2;
+				}
+				std::remove(file.c_str());
+			}
+		}
+	}
+	// the other specialized dialects and the generic tokenizer, on the same mixed rows
+	const char delimiters[] = { '\t', '|', ';' };
+	for (char delimiter : delimiters) {
+		Scenario scenario{ widths[1], QUOTING_SOME, TYPES_MIXED, 0, delimiter };
+		std::string name = std::string("mixed_16_quoting_some_") + csvDialectName(csvDialect(delimiter, '"', '"'));
+		std::string file = directory + "/" + name + ".csv";
+		std::uint64_t rows = generate(file, scenario, size);
+		std::uint64_t bytes = 0;
+		{
+			std::ifstream in(file, std::ios::binary | std::ios::ate);
+			bytes = (std::uint64_t) in.tellg();
+		}
+		try {
+			run(name, file, scenario, rows, bytes, 0);
+			run(name, file, scenario, rows, bytes, workers);
+		}
+		catch (std::exception& e) {
+			std::cerr << "Error: " << e.what() << std::endl;
+			return 2;
+		}
+		std::remove(file.c_str());
+	}
+	return 0;
+}
@@ -0,0 +1,90 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+/**
+* A bounded cache of the values the csv values of one column were converted to, for
+* feeds that repeat the same values over and over. Once full it is cleared and
+* refilled, so that it follows values that drift over time like the day of a
+* timestamp. If fewer than MIN_HIT_PERCENT of the lookups of a window hit, it turns
+* itself off for good, since then it costs more time and memory than it saves.
+*/
+template <typename Value>
+class ConversionMemo {
+public:
+	static const std::uint64_t WINDOW = 16384; // lookups after which the hit rate is checked
+	static const std::uint64_t MIN_HIT_PERCENT = 20;
+
+	explicit ConversionMemo(size_t capacity = 0) : capacity(capacity), active(capacity > 0) {}
+
+	bool enabled() const { return this->active; }
+	bool disabled() const { return this->capacity > 0 && !this->active; } // by a low hit rate
+	std::uint64_t lookupCount() const { return this->lookups; }
+	std::uint64_t hitCount() const { return this->hits; }
+
+	/*
+	* returns the cached value of text, or nullptr if it isn't cached
+	*/
+	Value* find(const std::string& text) {
+		this->lookups++;
+		auto it = this->values.find(text);
+		bool hit = it != this->values.end();
+		if (hit) {
+			this->hits++;
+			this->window_hits++;
+		}
+		if (++this->window_lookups == WINDOW) {
+			if (this->window_hits * 100 < WINDOW * MIN_HIT_PERCENT) {
+				// the value found stays valid until the next call
+				if (hit) {
+					this->last_value = it->second;
+				}
+				this->active = false;
+				std::unordered_map<std::string, Value>().swap(this->values);
+				return hit ? &this->last_value : nullptr;
+			}
+			this->window_lookups = 0;
+			this->window_hits = 0;
+		}
+		return hit ? &it->second : nullptr;
+	}
+
+	/*
+	* caches the value of text and returns the cached copy, that stays valid until the next call
+	*/
+	Value& insert(const std::string& text, const Value& value) {
+		if (!this->active) {
+			return this->last_value = value;
+		}
+		if (this->values.size() >= this->capacity) {
+			this->values.clear();
+		}
+		return this->values.emplace(text, value).first->second;
+	}
+
+private:
+	size_t capacity;
+	bool active;
+	std::unordered_map<std::string, Value> values;
+	Value last_value; // returned once the memo is off
+	std::uint64_t lookups = 0;
+	std::uint64_t hits = 0;
+	std::uint64_t window_lookups = 0;
+	std::uint64_t window_hits = 0;
+};
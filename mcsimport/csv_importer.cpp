@@ -0,0 +1,557 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+#include "csv_importer.h"
+#include "json_reader.h"
+#include "probes.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+
+CsvImporter::CsvImporter(char delimiter, char escape_character, char enclose_by_character, bool header, bool ignore_malformed_csv, unsigned threads) {
+	this->delimiter = delimiter;
+	this->escape_character = escape_character;
+	this->enclose_by_character = enclose_by_character;
+	this->header = header;
+	this->ignore_malformed_csv = ignore_malformed_csv;
+	this->threads = threads;
+}
+
+CsvImporter::~CsvImporter() {
+	delete this->reader;
+	delete this->errorLog;
+	delete this->sorter;
+}
+
+void CsvImporter::setJsonPaths(const std::vector<std::string>& paths) {
+	this->json = true;
+	this->json_paths = paths;
+}
+
+RowReader* CsvImporter::newReader() const {
+	if (this->json) {
+		return new JsonReader(this->json_paths);
+	}
+	RowReader* reader = new CsvReader(this->delimiter, this->escape_character, this->enclose_by_character);
+	reader->setProjection(this->projection);
+	return reader;
+}
+
+void CsvImporter::setFollow(std::uint64_t commit_latency_ms, double idle_seconds, StopFunction stop) {
+	this->follow = true;
+	this->follow_commit_latency = std::chrono::milliseconds(commit_latency_ms);
+	this->follow_idle = idle_seconds;
+	this->follow_stop = stop;
+}
+
+void CsvImporter::open(const std::vector<std::string>& input_files, std::vector<std::string>& first_row) {
+	// check if the source csv files exist and extract the number of columns of the first row of the first file. the first input is only opened once, so that streams like stdin can be imported.
+	for (size_t i = 0; i < input_files.size(); i++) {
+		if (input_files[i] == "-" && input_files.size() > 1) {
+			throw std::runtime_error("stdin can only be imported as the only input file");
+		}
+		if (i > 0 && !std::ifstream(input_files[i], std::ios::binary)) {
+			throw std::runtime_error("Can't open input file " + input_files[i]);
+		}
+	}
+	this->reader = newReader();
+	if (this->follow) {
+		// polled at least twice per commit latency
+		this->follow_input = FollowCsvInput::open(input_files[0], (unsigned) std::max<std::int64_t>(1, std::min<std::int64_t>(FOLLOW_POLL_INTERVAL_MS, this->follow_commit_latency.count() / 2)));
+		if (this->follow_input == nullptr) {
+			throw std::runtime_error("Can't open input file " + input_files[0]);
+		}
+		this->reader->open(this->follow_input);
+	}
+	else if (!this->reader->open(input_files[0])) {
+		throw std::runtime_error("Can't open input file " + input_files[0]);
+	}
+	first_row.clear();
+	if (this->json) {
+		// every row has a field per path and the raw line
+		this->number_of_csv_columns = this->json_paths.size() + 1;
+	}
+	else {
+		std::vector<CsvField> csv_first_row_fields;
+		try {
+			// a followed file may still be empty, its first row defines the number of columns once it was written
+			std::chrono::steady_clock::time_point opened = std::chrono::steady_clock::now();
+			while (!this->reader->peekNextCsvFields(csv_first_row_fields) && this->follow) {
+				if (followEnded(opened)) {
+					throw std::runtime_error("the following ended before the first row was written");
+				}
+			}
+		}
+		catch (std::exception& e) {
+			throw std::runtime_error("Can't read input file " + input_files[0] + ": " + e.what());
+		}
+		for (auto const& f : csv_first_row_fields) {
+			first_row.push_back(f.str());
+		}
+		this->number_of_csv_columns = csv_first_row_fields.size();
+	}
+	this->input_files = input_files;
+	this->file_stats.resize(input_files.size());
+	for (size_t i = 0; i < input_files.size(); i++) {
+		this->file_stats[i].name = input_files[i];
+	}
+}
+
+void CsvImporter::openErrorLogs(const std::string& suffix) {
+	// create all error logs up front, the first one stays open
+	for (size_t i = this->input_files.size(); i-- > 0;) {
+		std::string errFile = (this->input_files[i] == "-" ? "stdin" : this->input_files[i]) + suffix;
+		this->file_stats[i].err_file = errFile;
+		if (this->errorLog == nullptr) {
+			this->errorLog = new ErrorLog();
+		}
+		this->errorLog->open(errFile, false);
+		this->errorLog->writeLine(this->json ? "error_type, json_path, raw_line" : "error_type, column_nr, parsed_raw_row_values");
+	}
+}
+
+void CsvImporter::setCommitInterval(std::uint64_t rows, std::uint64_t bytes, CheckpointFunction checkpoint) {
+	this->commit_rows = rows;
+	this->commit_bytes = bytes;
+	this->checkpoint = checkpoint;
+}
+
+void CsvImporter::setErrorBudget(std::uint64_t max_errors, double max_error_ratio) {
+	this->max_errors = max_errors;
+	this->max_error_ratio = max_error_ratio;
+}
+
+void CsvImporter::setSortKeys(const std::vector<SortKey>& keys, size_t memory_budget, const std::string& temp_directory) {
+	this->sort_keys = keys;
+	this->sort_memory_budget = memory_budget;
+	this->sort_temp_directory = temp_directory;
+}
+
+void CsvImporter::setResumePosition(size_t file, std::uint64_t offset) {
+	this->resume_file = file;
+	this->resume_offset = offset;
+}
+
+void CsvImporter::import(RowSink& sink, const ConversionPlan& plan) {
+	this->sink = &sink;
+	this->plan = &plan;
+	this->statuses.assign(plan.columnCount(), mcsapi::CONVERT_STATUS_NONE);
+	// the error logs state all parsed values of a row, otherwise the fields of unused csv columns are skipped
+	if (this->errorLog == nullptr) {
+		this->projection.assign(this->number_of_csv_columns, 0);
+		for (size_t col = 0; col < plan.columnCount(); col++) {
+			std::int32_t csv_column = plan.column(col).csv_column;
+			if (csv_column >= 0 && (size_t) csv_column < this->projection.size()) {
+				this->projection[csv_column] = 1;
+			}
+		}
+		if (this->filter != nullptr) {
+			this->filter->markColumns(this->projection);
+		}
+		this->reader->setProjection(this->projection);
+	}
+	// the sorted rows are written once all input was read, the parsed fields are kept for the error logs
+	if (!this->sort_keys.empty()) {
+		this->sorter = new RowSorter(plan, this->sort_keys, this->errorLog != nullptr, this->sort_memory_budget, this->sort_temp_directory, this->threads, this->stats);
+	}
+	// several input files, periodic commits and resuming work on the chunks of the import pipeline
+	if (this->follow) {
+		importFollowing();
+	}
+	else if (this->threads > 0 || this->input_files.size() > 1 || this->commit_rows > 0 || this->commit_bytes > 0 || this->resume_file > 0 || this->resume_offset > 0) {
+		importFiles();
+	}
+	else {
+		importSingleThreaded();
+	}
+	if (this->sorter != nullptr) {
+		writeSortedRows();
+		this->sort_runs = this->sorter->runCount();
+		delete this->sorter;
+		this->sorter = nullptr;
+	}
+	checkErrorBudget(true);
+	{
+		StageTimer timer(this->stats, ImportStats::STAGE_COMMIT);
+		MCSIMPORT_PROBE2(commit_start, this->rows_read, this->input_offset);
+		RowSinkSummary summary = sink.commit();
+		MCSIMPORT_PROBE3(commit_end, this->rows_read, this->input_offset, summary.rows_inserted);
+		this->committed.add(summary);
+	}
+	if (this->errorLog != nullptr) {
+		this->errorLog->close();
+	}
+}
+
+void CsvImporter::importFiles() {
+	// tokenize and prepare the rows of all input files on worker threads, and inject them here in input order
+	// when resuming, the input files before the resumed file are skipped and it is continued at the resume offset
+	CsvInput* first_input = this->reader->detach();
+	if (this->resume_file > 0) {
+		delete first_input;
+		first_input = nullptr;
+	}
+	ImportPipeline::OpenFunction open = [this, first_input](size_t i) {
+		i += this->resume_file;
+		std::unique_ptr<CsvInput> input(i == 0 ? first_input : CsvInput::open(this->input_files[i]));
+		if (!input) {
+			throw std::runtime_error("Can't open input file " + this->input_files[i]);
+		}
+		if (i == this->resume_file && this->resume_offset > 0) {
+			input->skip(this->resume_offset);
+		}
+		return input.release();
+	};
+	ImportPipeline pipeline(this->input_files.size() - this->resume_file, open, [this] { return newReader(); }, this->header, std::max(this->threads, 1u), [this](CsvRowBatch& batch) { prepareBatch(batch); }, this->stats);
+	size_t columns = this->plan->columnCount();
+	std::uint64_t rows_since_commit = 0;
+	std::uint64_t bytes_since_commit = 0;
+	for (;;) {
+		CsvRowBatch* batch;
+		{
+			StageTimer timer(this->stats, ImportStats::STAGE_WAIT);
+			batch = pipeline.next();
+		}
+		if (batch == nullptr) {
+			break;
+		}
+		switchInputFile(this->resume_file + batch->input_index);
+		{
+			StageTimer timer(this->stats, ImportStats::STAGE_INJECT);
+			for (size_t row = 0; row < batch->rowCount(); row++) {
+				if (!batch->row_positions.empty()) {
+					this->row_offset = batch->offset + batch->row_positions[row];
+				}
+				importRow(batch->rowFields(row), batch->rowFieldCount(row), batch->values.data() + row * columns, !batch->filtered.empty() && batch->filtered[row]);
+			}
+		}
+		this->input_offset = batch->offset + batch->size;
+		if (this->stats != nullptr) {
+			this->stats->addRows(batch->rowCount());
+		}
+		// commit periodically at chunk boundaries, whose position can be resumed from
+		rows_since_commit += batch->rowCount();
+		bytes_since_commit += batch->size;
+		if ((this->commit_rows > 0 && rows_since_commit >= this->commit_rows) || (this->commit_bytes > 0 && bytes_since_commit >= this->commit_bytes)) {
+			commitCheckpoint(this->resume_file + batch->input_index, this->input_offset);
+			rows_since_commit = 0;
+			bytes_since_commit = 0;
+		}
+	}
+}
+
+void CsvImporter::importSingleThreaded() {
+	std::vector<CsvField> parsed_csv_fields;
+	std::vector<ConvertedValue> values(this->plan->columnCount());
+	// ignore the first line if it is the header
+	if (this->header) {
+		this->reader->getNextCsvFields(parsed_csv_fields);
+	}
+	this->row_offset = this->reader->offset();
+	if (this->stats == nullptr) {
+		while (this->reader->getNextCsvFields(parsed_csv_fields)) {
+			bool filtered = false;
+			if (parsed_csv_fields.size() == this->number_of_csv_columns) {
+				filtered = this->filter != nullptr && !this->filter->matches(parsed_csv_fields.data());
+				if (!filtered) {
+					this->plan->convertRow(parsed_csv_fields.data(), values.data());
+				}
+			}
+			importRow(parsed_csv_fields.data(), parsed_csv_fields.size(), values.data(), filtered);
+			if (mcsimportProbesEnabled()) {
+				this->row_offset = this->reader->offset();
+			}
+		}
+		this->input_offset = this->reader->offset();
+		return;
+	}
+	// the same loop with every stage timed, each clock reading ends one stage and starts the next
+	std::uint64_t offset = this->reader->offset();
+	ImportStats::Clock::time_point stage_start = ImportStats::Clock::now();
+	while (this->reader->getNextCsvFields(parsed_csv_fields)) {
+		ImportStats::Clock::time_point tokenized = ImportStats::Clock::now();
+		this->stats->addTime(ImportStats::STAGE_TOKENIZE, tokenized - stage_start);
+		stage_start = tokenized;
+		bool filtered = false;
+		if (parsed_csv_fields.size() == this->number_of_csv_columns) {
+			filtered = this->filter != nullptr && !this->filter->matches(parsed_csv_fields.data());
+			if (!filtered) {
+				this->plan->convertRow(parsed_csv_fields.data(), values.data());
+			}
+			ImportStats::Clock::time_point converted = ImportStats::Clock::now();
+			this->stats->addTime(ImportStats::STAGE_CONVERT, converted - stage_start);
+			stage_start = converted;
+		}
+		importRow(parsed_csv_fields.data(), parsed_csv_fields.size(), values.data(), filtered);
+		ImportStats::Clock::time_point injected = ImportStats::Clock::now();
+		this->stats->addTime(ImportStats::STAGE_INJECT, injected - stage_start);
+		stage_start = injected;
+		this->stats->addRows(1);
+		this->stats->addBytes(this->reader->offset() - offset);
+		offset = this->reader->offset();
+		this->row_offset = offset;
+	}
+	this->input_offset = offset;
+}
+
+void CsvImporter::importFollowing() {
+	typedef std::chrono::steady_clock Clock;
+	std::vector<CsvField> parsed_csv_fields;
+	std::vector<ConvertedValue> values(this->plan->columnCount());
+	// continue after the last commit of a previous run, or skip the header at the beginning of the file
+	if (this->resume_offset > 0) {
+		if (this->follow_input->fileSize() < this->resume_offset) {
+			throw std::runtime_error("the input file is shorter than the resume offset " + std::to_string(this->resume_offset) + ", it was truncated or replaced");
+		}
+		std::unique_ptr<CsvInput> input(this->reader->detach());
+		input->skip(this->resume_offset);
+		this->reader->open(input.release());
+	}
+	else if (this->header) {
+		this->reader->getNextCsvFields(parsed_csv_fields);
+	}
+	std::uint64_t commit_offset = this->reader->offset();
+	std::uint64_t rows_since_commit = 0;
+	Clock::time_point last_row = Clock::now();
+	Clock::time_point first_uncommitted_row = last_row;
+	for (;;) {
+		this->row_offset = this->reader->offset();
+		bool read = this->reader->getNextCsvFields(parsed_csv_fields);
+		Clock::time_point now = Clock::now();
+		if (read) {
+			bool filtered = false;
+			if (parsed_csv_fields.size() == this->number_of_csv_columns) {
+				filtered = this->filter != nullptr && !this->filter->matches(parsed_csv_fields.data());
+				if (!filtered) {
+					this->plan->convertRow(parsed_csv_fields.data(), values.data());
+				}
+			}
+			importRow(parsed_csv_fields.data(), parsed_csv_fields.size(), values.data(), filtered);
+			if (this->stats != nullptr) {
+				this->stats->addRows(1);
+				this->stats->addBytes(this->reader->offset() - this->row_offset);
+			}
+			if (rows_since_commit++ == 0) {
+				first_uncommitted_row = now;
+			}
+			last_row = now;
+		}
+		// a commit ends at the end of the last complete row, which a restart resumes from
+		this->input_offset = this->reader->offset();
+		bool commit = rows_since_commit > 0 && ((this->commit_rows > 0 && rows_since_commit >= this->commit_rows) || (this->commit_bytes > 0 && this->input_offset - commit_offset >= this->commit_bytes) || now - first_uncommitted_row >= this->follow_commit_latency);
+		if (commit) {
+			commitCheckpoint(0, this->input_offset);
+			commit_offset = this->input_offset;
+			rows_since_commit = 0;
+		}
+		// a file that grows all the time is only checked for the stop after the commits
+		if ((!read || commit) && followEnded(last_row)) {
+			break;
+		}
+	}
+	if (rows_since_commit > 0) {
+		commitCheckpoint(0, this->input_offset);
+	}
+}
+
+bool CsvImporter::followEnded(std::chrono::steady_clock::time_point last_row) const {
+	return (this->follow_stop && this->follow_stop()) || (this->follow_idle > 0 && std::chrono::duration<double>(std::chrono::steady_clock::now() - last_row).count() >= this->follow_idle);
+}
+
+void CsvImporter::commitCheckpoint(size_t file, std::uint64_t offset) {
+	RowSinkSummary summary;
+	{
+		StageTimer timer(this->stats, ImportStats::STAGE_COMMIT);
+		MCSIMPORT_PROBE2(commit_start, this->rows_read, offset);
+		summary = this->sink->commit();
+		MCSIMPORT_PROBE3(commit_end, this->rows_read, offset, summary.rows_inserted);
+	}
+	this->committed.add(summary);
+	if (this->checkpoint) {
+		this->checkpoint(file, offset, summary);
+	}
+}
+
+void CsvImporter::prepareBatch(CsvRowBatch& batch) const {
+	// called on the pipeline's worker threads
+	size_t columns = this->plan->columnCount();
+	batch.values.resize(batch.rowCount() * columns);
+	if (this->filter != nullptr) {
+		batch.filtered.assign(batch.rowCount(), 0);
+	}
+	for (size_t row = 0; row < batch.rowCount(); row++) {
+		if (batch.rowFieldCount(row) != this->number_of_csv_columns) {
+			continue;
+		}
+		if (this->filter != nullptr && !this->filter->matches(batch.rowFields(row))) {
+			batch.filtered[row] = 1;
+			continue;
+		}
+		this->plan->convertRow(batch.rowFields(row), batch.values.data() + row * columns);
+	}
+}
+
+void CsvImporter::importRow(const CsvField* parsed_csv_fields, size_t parsed_csv_field_count, const ConvertedValue* values, bool filtered) {
+	this->rows_read++;
+	this->probe_row = this->rows_read;
+	MCSIMPORT_PROBE3(row_parsed, this->rows_read, this->row_offset, parsed_csv_field_count);
+	if (parsed_csv_field_count != this->number_of_csv_columns) {
+		MCSIMPORT_PROBE3(malformed_line, this->rows_read, this->row_offset, parsed_csv_field_count);
+	}
+	//throw an exception and rollback the transaction if the parsed csv vector has not the exact number of fields as specified and ignore_malformed_csv is false
+	if (parsed_csv_field_count != this->number_of_csv_columns && !this->ignore_malformed_csv && this->json) {
+		std::string errorMsg = "json input parse error: the line isn't a valid json object\nvalues: " + parsed_csv_fields[parsed_csv_field_count - 1].str();
+		if (this->input_files.size() > 1) {
+			errorMsg += "\ninput file: " + this->input_files[this->current_file];
+		}
+		throw std::range_error(errorMsg);
+	}
+	else if (parsed_csv_field_count != this->number_of_csv_columns && !this->ignore_malformed_csv) {
+		std::string errorMsg = "csv input parse error: the csv input file's columns of: " + std::to_string(parsed_csv_field_count) + " doesn't match the expected column count of the first line of: " + std::to_string(this->number_of_csv_columns) + "\nvalues: ";
+		if (parsed_csv_field_count > 0) {
+			for (size_t i = 0; i < parsed_csv_field_count; i++) {
+				errorMsg.append(parsed_csv_fields[i].data, parsed_csv_fields[i].length).append(", ");
+			}
+			errorMsg = errorMsg.substr(0, errorMsg.size() - 2);
+		}
+		if (this->input_files.size() > 1) {
+			errorMsg += "\ninput file: " + this->input_files[this->current_file];
+		}
+		throw std::range_error(errorMsg);
+	}
+	//ignore the csv line if the parsed csv vector has not the exact number of fields as specified and ignore_malformed_csv is true
+	else if (parsed_csv_field_count != this->number_of_csv_columns && this->ignore_malformed_csv) {
+		this->ignored_malformed_csv_lines++;
+		this->file_stats[this->current_file].ignored_malformed_csv_lines++;
+		if (this->errorLog != nullptr) {
+			if (this->json) {
+				this->errorLog->write("MALFORMED_JSON_LINE", "", parsed_csv_fields + parsed_csv_field_count - 1, 1);
+			}
+			else {
+				this->errorLog->write("MALFORMED_CSV_LINE", -1, parsed_csv_fields, parsed_csv_field_count);
+			}
+		}
+		this->errors++;
+		checkErrorBudget(false);
+		return;
+	}
+	// well formed rows rejected by the row filter are skipped
+	if (filtered) {
+		this->filtered_rows++;
+		this->file_stats[this->current_file].filtered++;
+		return;
+	}
+	// otherwise inject the values into the sink, or hand them to the sorter that injects them later
+	if (this->sorter != nullptr) {
+		this->sorter->add(this->current_file, values, parsed_csv_fields, parsed_csv_field_count);
+		return;
+	}
+	writeRow(this->current_file, parsed_csv_fields, parsed_csv_field_count, values);
+}
+
+void CsvImporter::writeSortedRows() {
+	SortedRow row;
+	// the probes report the position of the rows in sorted order
+	this->probe_row = 0;
+	this->row_offset = 0;
+	if (this->stats == nullptr) {
+		while (this->sorter->next(row)) {
+			this->probe_row++;
+			writeRow(row.file, row.fields, row.field_count, row.values);
+		}
+		return;
+	}
+	// merging the sorted rows is timed as sort and writing them as inject stage
+	ImportStats::Clock::time_point stage_start = ImportStats::Clock::now();
+	while (this->sorter->next(row)) {
+		ImportStats::Clock::time_point merged = ImportStats::Clock::now();
+		this->stats->addTime(ImportStats::STAGE_SORT, merged - stage_start);
+		this->probe_row++;
+		writeRow(row.file, row.fields, row.field_count, row.values);
+		stage_start = ImportStats::Clock::now();
+		this->stats->addTime(ImportStats::STAGE_INJECT, stage_start - merged);
+	}
+	this->stats->addTime(ImportStats::STAGE_SORT, ImportStats::Clock::now() - stage_start);
+}
+
+void CsvImporter::writeRow(size_t file_index, const CsvField* parsed_csv_fields, size_t parsed_csv_field_count, const ConvertedValue* values) {
+	InputFileStats& file = this->file_stats[file_index];
+	this->sink->writeRow(values, this->statuses.data());
+	MCSIMPORT_PROBE3(write_row, this->probe_row, this->row_offset, this->statuses.size());
+	file.rows_inserted++;
+	std::uint64_t errors = this->errors;
+	for (size_t col = 0; col < this->statuses.size(); col++) {
+		mcsapi::columnstore_data_convert_status_t status = this->statuses[col];
+		if (status == mcsapi::CONVERT_STATUS_NONE) {
+			continue;
+		}
+		MCSIMPORT_PROBE4(convert_status, this->probe_row, this->row_offset, col, (int) status);
+		const char* statusValue;
+		switch (status) {
+		case mcsapi::CONVERT_STATUS_SATURATED:
+			file.saturated++;
+			statusValue = "SATURATED";
+			break;
+		case mcsapi::CONVERT_STATUS_INVALID:
+			file.invalid++;
+			statusValue = "INVALID";
+			break;
+		case mcsapi::CONVERT_STATUS_TRUNCATED:
+			file.truncated++;
+			statusValue = "TRUNCATED";
+			break;
+		default:
+			statusValue = "UNKNOWN";
+		}
+		//log the value and line that was saturated, invalid or truncated
+		if (this->errorLog != nullptr) {
+			// sorted rows of several input files are interleaved
+			switchInputFile(file_index);
+		}
+		if (this->errorLog != nullptr && this->json) {
+			// json rows are logged as their path and raw line
+			this->errorLog->write(statusValue, this->json_paths[this->plan->column(col).csv_column], parsed_csv_fields + parsed_csv_field_count - 1, 1);
+		}
+		else if (this->errorLog != nullptr) {
+			this->errorLog->write(statusValue, this->plan->column(col).csv_column, parsed_csv_fields, parsed_csv_field_count);
+		}
+		this->errors++;
+	}
+	if (this->errors != errors || this->max_error_ratio >= 0) {
+		checkErrorBudget(false);
+	}
+}
+
+void CsvImporter::checkErrorBudget(bool complete) {
+	if (this->errors > this->max_errors) {
+		throw std::runtime_error("the import was aborted after " + std::to_string(this->errors) + " errors in " + std::to_string(this->rows_read) + " csv rows, more than the maximum of " + std::to_string(this->max_errors) + " errors");
+	}
+	if (this->max_error_ratio >= 0 && (complete || this->rows_read >= ERROR_RATIO_MIN_ROWS) && this->errors > this->max_error_ratio * this->rows_read) {
+		char ratio[32];
+		std::snprintf(ratio, sizeof(ratio), "%g", this->max_error_ratio);
+		throw std::runtime_error("the import was aborted after " + std::to_string(this->errors) + " errors in " + std::to_string(this->rows_read) + " csv rows, more than the maximum error ratio of " + ratio);
+	}
+}
+
+void CsvImporter::switchInputFile(size_t file) {
+	if (file == this->current_file) {
+		return;
+	}
+	this->current_file = file;
+	if (this->errorLog != nullptr) {
+		this->errorLog->open(this->file_stats[file].err_file, true);
+	}
+}
@@ -0,0 +1,192 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <libmcsapi/mcsapi.h>
+#include "csv_reader.h"
+#include "error_log.h"
+#include "import_pipeline.h"
+#include "import_stats.h"
+#include "row_conversion.h"
+#include "row_filter.h"
+#include "row_sink.h"
+#include "row_sorter.h"
+
+/**
+* The accounting of one input file of an import.
+*/
+struct InputFileStats {
+	std::string name;
+	std::string err_file;
+	std::uint64_t rows_inserted = 0;
+	std::uint64_t truncated = 0;
+	std::uint64_t saturated = 0;
+	std::uint64_t invalid = 0;
+	std::uint64_t ignored_malformed_csv_lines = 0;
+	std::uint64_t filtered = 0;
+};
+
+/**
+* Reads csv input files, prepares their rows according to a conversion plan and
+* writes them to a row sink, either on the calling thread or through an import
+* pipeline. Keeps the error logs and the accounting of each input file, and
+* commits periodically if requested.
+*/
+class CsvImporter {
+public:
+	typedef std::function<void(size_t file, std::uint64_t offset, const RowSinkSummary& summary)> CheckpointFunction;
+	typedef std::function<bool()> StopFunction;
+	static const unsigned FOLLOW_POLL_INTERVAL_MS = 100;
+	static const std::uint64_t ERROR_RATIO_MIN_ROWS = 1000;
+
+	/*
+	* with threads > 0 the rows are tokenized and prepared by that many worker threads
+	*/
+	CsvImporter(char delimiter, char escape_character, char enclose_by_character, bool header, bool ignore_malformed_csv, unsigned threads);
+	~CsvImporter();
+
+	/*
+	* reads the input files as JSON Lines instead of csv, the csv columns of a row are the values of the given key paths. has to be called before open.
+	*/
+	void setJsonPaths(const std::vector<std::string>& paths);
+
+	/*
+	* follows the only input file as it is appended to instead of ending at its end, until stop returns true or the file didn't grow for idle_seconds if they are greater than 0. a row is only read once its line break was written. the rows are committed once commit_latency_ms passed since the first uncommitted row was read, or once the commit interval is reached, and the checkpoint function is called after every commit. has to be called before open.
+	*/
+	void setFollow(std::uint64_t commit_latency_ms, double idle_seconds, StopFunction stop);
+
+	/*
+	* opens the given input files, or stdin for "-", and returns the fields of the first row of the first file, that defines the number of csv columns. json input has a fixed number of columns, so first_row stays empty then. throws std::runtime_error if a file can't be opened or read.
+	*/
+	void open(const std::vector<std::string>& input_files, std::vector<std::string>& first_row);
+
+	/*
+	* creates an error log named after each input file and the given suffix, that states malformed rows and values that couldn't be converted exactly. throws std::runtime_error if one can't be created.
+	*/
+	void openErrorLogs(const std::string& suffix);
+
+	/*
+	* aborts the import once more than max_errors errors were found, or once the errors per csv row exceed max_error_ratio, which is checked after ERROR_RATIO_MIN_ROWS rows and at the end. errors are malformed rows that are ignored and values that were truncated, saturated or invalid.
+	*/
+	void setErrorBudget(std::uint64_t max_errors, double max_error_ratio);
+
+	/*
+	* only imports the well formed csv rows that match the given filter, the others are counted as filtered. the filter has to outlive the import.
+	*/
+	void setRowFilter(const RowFilter* filter) { this->filter = filter; }
+
+	/*
+	* writes the rows sorted by the given target columns of the conversion plan, after all rows were read. the sort keeps up to memory_budget bytes of rows in memory and writes the others in sorted runs into temp_directory. can't be combined with periodic commits.
+	*/
+	void setSortKeys(const std::vector<SortKey>& keys, size_t memory_budget, const std::string& temp_directory);
+
+	/*
+	* times the import stages in the given stats
+	*/
+	void setStats(ImportStats* stats) { this->stats = stats; }
+
+	/*
+	* commits after at least the given number of csv rows or input bytes, 0 to only commit at the end. checkpoint is called after every such commit with the input file and byte offset the import can be resumed at.
+	*/
+	void setCommitInterval(std::uint64_t rows, std::uint64_t bytes, CheckpointFunction checkpoint);
+
+	/*
+	* starts the import at the given byte offset of the given input file, skipping the files before
+	*/
+	void setResumePosition(size_t file, std::uint64_t offset);
+
+	/*
+	* imports all rows into the sink and commits them. only the csv columns the plan uses are parsed, unless the other values are needed for the error logs. throws on malformed rows unless they are ignored, and on errors of the input and the sink. the rows since the last commit are left to be rolled back by the caller then.
+	*/
+	void import(RowSink& sink, const ConversionPlan& plan);
+
+	/*
+	* returns the totals of all commits
+	*/
+	const RowSinkSummary& summary() const { return this->committed; }
+	std::uint64_t ignoredMalformedCsvLines() const { return this->ignored_malformed_csv_lines; }
+	std::uint64_t filteredRows() const { return this->filtered_rows; }
+	std::uint64_t errorCount() const { return this->errors; }
+	size_t sortRunCount() const { return this->sort_runs; }
+	const std::vector<InputFileStats>& fileStats() const { return this->file_stats; }
+	const std::vector<std::string>& inputFiles() const { return this->input_files; }
+	size_t csvColumnCount() const { return this->number_of_csv_columns; }
+
+private:
+	char delimiter;
+	char escape_character;
+	char enclose_by_character;
+	bool header;
+	bool ignore_malformed_csv;
+	unsigned threads;
+	bool json = false; // the input is JSON Lines
+	std::vector<std::string> json_paths;
+	bool follow = false; // the input file is followed as it grows
+	std::chrono::milliseconds follow_commit_latency = std::chrono::milliseconds(0);
+	double follow_idle = 0;
+	StopFunction follow_stop;
+	FollowCsvInput* follow_input = nullptr; // the followed input, owned by the reader
+	RowReader* reader = nullptr; // reads the first input file
+	std::vector<char> projection; // the csv columns used by the conversion plan, all if empty
+	std::vector<std::string> input_files;
+	size_t number_of_csv_columns = 0;
+	std::vector<InputFileStats> file_stats;
+	size_t current_file = 0;
+	ErrorLog* errorLog = nullptr; // writes the error logs of all input files
+	const RowFilter* filter = nullptr;
+	ImportStats* stats = nullptr;
+	std::uint64_t commit_rows = 0;
+	std::uint64_t commit_bytes = 0;
+	CheckpointFunction checkpoint;
+	std::vector<SortKey> sort_keys;
+	size_t sort_memory_budget = 0;
+	std::string sort_temp_directory;
+	size_t sort_runs = 0;
+	size_t resume_file = 0;
+	std::uint64_t resume_offset = 0;
+	RowSinkSummary committed;
+	std::uint64_t ignored_malformed_csv_lines = 0;
+	std::uint64_t filtered_rows = 0;
+	std::uint64_t max_errors = UINT64_MAX;
+	double max_error_ratio = -1; // disabled if negative
+	std::uint64_t errors = 0;
+	std::uint64_t rows_read = 0; // csv rows of all input files, including malformed ones
+
+	// state of the running import
+	RowSink* sink = nullptr;
+	const ConversionPlan* plan = nullptr;
+	std::vector<mcsapi::columnstore_data_convert_status_t> statuses;
+	RowSorter* sorter = nullptr; // holds the rows until they are written in sorted order
+	std::uint64_t probe_row = 0; // the row number the probes report
+	std::uint64_t row_offset = 0; // the input offset of the current row, only tracked while a probe is attached
+	std::uint64_t input_offset = 0; // the input offset up to which rows were handed to the sink
+
+	RowReader* newReader() const;
+	void importFiles();
+	void importSingleThreaded();
+	void importFollowing();
+	bool followEnded(std::chrono::steady_clock::time_point last_row) const;
+	void commitCheckpoint(size_t file, std::uint64_t offset);
+	void prepareBatch(CsvRowBatch& batch) const;
+	void importRow(const CsvField* parsed_csv_fields, size_t parsed_csv_field_count, const ConvertedValue* values, bool filtered);
+	void writeRow(size_t file_index, const CsvField* parsed_csv_fields, size_t parsed_csv_field_count, const ConvertedValue* values);
+	void writeSortedRows();
+	void switchInputFile(size_t file);
+	void checkErrorBudget(bool complete);
+};
@@ -0,0 +1,453 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+#include "csv_input.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <sys/stat.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+CsvInput* CsvInput::open(const std::string& input_file) {
+	if (input_file == "-") {
+#ifdef _WIN32
+		_setmode(_fileno(stdin), _O_BINARY);
+#endif
+		return new StreamCsvInput(stdin);
+	}
+#ifndef _WIN32
+	int fd = ::open(input_file.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return nullptr;
+	}
+	// uncompressed regular files are mapped into memory so that the tokenizer can work on them without copying
+	struct stat st;
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 && (std::uint64_t) st.st_size <= std::numeric_limits<size_t>::max()) {
+		void* mapping = mmap(nullptr, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapping != MAP_FAILED) {
+			if (!StreamCsvInput::isCompressed(static_cast<const unsigned char*>(mapping), (size_t) st.st_size)) {
+				::close(fd);
+				return new MappedCsvInput(mapping, (size_t) st.st_size);
+			}
+			munmap(mapping, (size_t) st.st_size);
+		}
+	}
+	std::FILE* file = fdopen(fd, "rb");
+	if (file == nullptr) {
+		::close(fd);
+		return nullptr;
+	}
+#else
+	std::FILE* file = std::fopen(input_file.c_str(), "rb");
+	if (file == nullptr) {
+		return nullptr;
+	}
+#endif
+	return new StreamCsvInput(file);
+}
+
+void CsvInput::skip(std::uint64_t bytes) {
+	while (bytes > 0) {
+		if (this->window_size == 0 && this->source_exhausted) {
+			throw std::runtime_error("the input ends before offset " + std::to_string(this->window_offset + bytes));
+		}
+		size_t consumed = (size_t) std::min<std::uint64_t>(bytes, this->window_size);
+		fill(consumed);
+		bytes -= consumed;
+	}
+}
+
+StreamCsvInput::StreamCsvInput(std::FILE* file, size_t block_size, size_t ring_blocks) : file(file), block_size(block_size), ring(ring_blocks), ring_lengths(ring_blocks), raw(RAW_BUFFER_SIZE) {
+	for (auto& block : this->ring) {
+		block.reset(new char[block_size]);
+	}
+	this->reader = std::thread(&StreamCsvInput::readBlocks, this);
+}
+
+StreamCsvInput::~StreamCsvInput() {
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopping = true;
+	}
+	this->block_consumed.notify_all();
+	this->reader.join();
+	freeDecoder();
+	std::fclose(this->file);
+}
+
+bool StreamCsvInput::isCompressed(const unsigned char* data, size_t length) {
+	return (length >= 2 && data[0] == 0x1f && data[1] == 0x8b) || (length >= 4 && data[0] == 0x28 && data[1] == 0xb5 && data[2] == 0x2f && data[3] == 0xfd);
+}
+
+void StreamCsvInput::fill(size_t consumed) {
+	// move the unconsumed rest to the front of the window
+	size_t remaining = this->window_size - consumed;
+	if (consumed > 0 && remaining > 0) {
+		std::memmove(this->buffer.data(), this->window_data + consumed, remaining);
+	}
+	this->window_data = this->buffer.data();
+	this->window_size = remaining;
+	this->window_offset += consumed;
+	if (this->source_exhausted) {
+		return;
+	}
+
+	// append the next decoded block, the reader thread doesn't touch it until it is marked as consumed
+	std::unique_lock<std::mutex> lock(this->mutex);
+	this->block_decoded.wait(lock, [this] { return this->ring_count > 0 || this->reading_finished; });
+	if (this->ring_count == 0) {
+		this->source_exhausted = true;
+		if (this->error) {
+			std::rethrow_exception(this->error);
+		}
+		return;
+	}
+	const char* block = this->ring[this->ring_head].get();
+	size_t length = this->ring_lengths[this->ring_head];
+	lock.unlock();
+	if (remaining + length > this->buffer.size()) {
+		this->buffer.resize(remaining + length);
+		this->window_data = this->buffer.data();
+	}
+	std::memcpy(this->buffer.data() + remaining, block, length);
+	this->window_size = remaining + length;
+	lock.lock();
+	this->ring_head = (this->ring_head + 1) % this->ring.size();
+	this->ring_count--;
+	this->source_exhausted = this->ring_count == 0 && this->reading_finished && !this->error;
+	lock.unlock();
+	this->block_consumed.notify_one();
+}
+
+void StreamCsvInput::readBlocks() {
+	try {
+		// detect the compression from the magic number at the start of the stream
+		while (this->raw_length < 4 && readRaw()) {}
+		const unsigned char* magic = reinterpret_cast<const unsigned char*>(this->raw.data());
+		if (StreamCsvInput::isCompressed(magic, this->raw_length)) {
+			this->compression = magic[0] == 0x1f ? COMPRESSION_GZIP : COMPRESSION_ZSTD;
+		}
+		initDecoder();
+
+		for (;;) {
+			size_t slot;
+			{
+				std::unique_lock<std::mutex> lock(this->mutex);
+				this->block_consumed.wait(lock, [this] { return this->stopping || this->ring_count < this->ring.size(); });
+				if (this->stopping) {
+					break;
+				}
+				slot = (this->ring_head + this->ring_count) % this->ring.size();
+			}
+			size_t length = decode(this->ring[slot].get(), this->block_size);
+			if (length == 0) {
+				break;
+			}
+			{
+				std::lock_guard<std::mutex> lock(this->mutex);
+				this->ring_lengths[slot] = length;
+				this->ring_count++;
+			}
+			this->block_decoded.notify_one();
+		}
+	}
+	catch (...) {
+		// handed out by fill() after the blocks that were decoded before
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->error = std::current_exception();
+	}
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->reading_finished = true;
+	}
+	this->block_decoded.notify_all();
+}
+
+bool StreamCsvInput::readRaw() {
+	if (this->raw_eof) {
+		return false;
+	}
+	if (this->raw_position > 0) {
+		std::memmove(this->raw.data(), this->raw.data() + this->raw_position, this->raw_length - this->raw_position);
+		this->raw_length -= this->raw_position;
+		this->raw_position = 0;
+	}
+	size_t read = std::fread(this->raw.data() + this->raw_length, 1, this->raw.size() - this->raw_length, this->file);
+	this->raw_length += read;
+	if (std::ferror(this->file)) {
+		throw std::runtime_error("input file couldn't be read");
+	}
+	if (std::feof(this->file)) {
+		this->raw_eof = true;
+	}
+	return read > 0;
+}
+
+size_t StreamCsvInput::decode(char* block, size_t length) {
+	if (this->compression == COMPRESSION_GZIP) {
+		return decodeGzip(block, length);
+	}
+	if (this->compression == COMPRESSION_ZSTD) {
+		return decodeZstd(block, length);
+	}
+	// uncompressed bytes are read directly into the block after the ones used for the detection
+	size_t decoded = 0;
+	if (this->raw_position < this->raw_length) {
+		decoded = std::min(length, this->raw_length - this->raw_position);
+		std::memcpy(block, this->raw.data() + this->raw_position, decoded);
+		this->raw_position += decoded;
+	}
+	if (decoded < length && !this->raw_eof) {
+		decoded += std::fread(block + decoded, 1, length - decoded, this->file);
+		if (std::ferror(this->file)) {
+			throw std::runtime_error("input file couldn't be read");
+		}
+		if (std::feof(this->file)) {
+			this->raw_eof = true;
+		}
+	}
+	return decoded;
+}
+
+void StreamCsvInput::initDecoder() {
+	this->frame_complete = this->compression == COMPRESSION_NONE;
+	if (this->compression == COMPRESSION_GZIP) {
+#ifdef HAVE_ZLIB
+		z_stream* stream = new z_stream();
+		// accept gzip headers only
+		if (inflateInit2(stream, 15 + 16) != Z_OK) {
+			delete stream;
+			throw std::runtime_error("gzip decompression couldn't be initialized");
+		}
+		this->decoder = stream;
+#else
+		throw std::runtime_error("gzip compressed input files are not supported by this build");
+#endif
+	}
+	else if (this->compression == COMPRESSION_ZSTD) {
+#ifdef HAVE_ZSTD
+		this->decoder = ZSTD_createDCtx();
+		if (this->decoder == nullptr) {
+			throw std::runtime_error("zstd decompression couldn't be initialized");
+		}
+#else
+		throw std::runtime_error("zstd compressed input files are not supported by this build");
+#endif
+	}
+}
+
+void StreamCsvInput::freeDecoder() {
+	if (this->decoder == nullptr) {
+		return;
+	}
+#ifdef HAVE_ZLIB
+	if (this->compression == COMPRESSION_GZIP) {
+		z_stream* stream = static_cast<z_stream*>(this->decoder);
+		inflateEnd(stream);
+		delete stream;
+	}
+#endif
+#ifdef HAVE_ZSTD
+	if (this->compression == COMPRESSION_ZSTD) {
+		ZSTD_freeDCtx(static_cast<ZSTD_DCtx*>(this->decoder));
+	}
+#endif
+	this->decoder = nullptr;
+}
+
+size_t StreamCsvInput::decodeGzip(char* block, size_t length) {
+#ifdef HAVE_ZLIB
+	z_stream* stream = static_cast<z_stream*>(this->decoder);
+	stream->next_out = reinterpret_cast<Bytef*>(block);
+	stream->avail_out = (uInt) length;
+	while (stream->avail_out > 0) {
+		if (this->raw_position == this->raw_length && !readRaw()) {
+			if (!this->frame_complete) {
+				throw std::runtime_error("gzip compressed input file is truncated");
+			}
+			break;
+		}
+		stream->next_in = reinterpret_cast<Bytef*>(this->raw.data() + this->raw_position);
+		stream->avail_in = (uInt) (this->raw_length - this->raw_position);
+		int ret = inflate(stream, Z_NO_FLUSH);
+		this->raw_position = this->raw_length - stream->avail_in;
+		if (ret == Z_STREAM_END) {
+			// a gzip file can consist of several members, the next one starts with a new header
+			this->frame_complete = true;
+			inflateReset(stream);
+		}
+		else if (ret == Z_OK || ret == Z_BUF_ERROR) {
+			this->frame_complete = false;
+		}
+		else {
+			throw std::runtime_error("gzip compressed input file couldn't be decompressed");
+		}
+	}
+	return length - stream->avail_out;
+#else
+	(void) block;
+	(void) length;
+	return 0;
+#endif
+}
+
+size_t StreamCsvInput::decodeZstd(char* block, size_t length) {
+#ifdef HAVE_ZSTD
+	ZSTD_DCtx* context = static_cast<ZSTD_DCtx*>(this->decoder);
+	ZSTD_outBuffer output = { block, length, 0 };
+	while (output.pos < output.size) {
+		size_t output_before = output.pos;
+		ZSTD_inBuffer input = { this->raw.data() + this->raw_position, this->raw_length - this->raw_position, 0 };
+		if (input.size == 0 && readRaw()) {
+			input.src = this->raw.data();
+			input.size = this->raw_length;
+		}
+		// without new input the decoder may still flush buffered output of the last frame
+		size_t ret = ZSTD_decompressStream(context, &output, &input);
+		if (ZSTD_isError(ret)) {
+			throw std::runtime_error("zstd compressed input file couldn't be decompressed");
+		}
+		this->raw_position += input.pos;
+		if (input.pos > 0 || output.pos > output_before) {
+			this->frame_complete = ret == 0;
+		}
+		else if (input.size == 0) {
+			if (!this->frame_complete) {
+				throw std::runtime_error("zstd compressed input file is truncated");
+			}
+			break;
+		}
+	}
+	return output.pos;
+#else
+	(void) block;
+	(void) length;
+	return 0;
+#endif
+}
+
+MemoryCsvInput::MemoryCsvInput(const char* data, size_t length) {
+	this->window_data = data;
+	this->window_size = length;
+	this->source_exhausted = true;
+	this->persistent_window = true;
+}
+
+void MemoryCsvInput::fill(size_t consumed) {
+	// the window already covers all data, there is nothing to read
+	this->window_data += consumed;
+	this->window_size -= consumed;
+	this->window_offset += consumed;
+}
+
+FollowCsvInput::FollowCsvInput(std::FILE* file, unsigned poll_interval_ms) : file(file), poll_interval_ms(poll_interval_ms) {
+	// the blocks are read directly into the window
+	std::setvbuf(file, nullptr, _IONBF, 0);
+}
+
+FollowCsvInput::~FollowCsvInput() {
+	std::fclose(this->file);
+}
+
+FollowCsvInput* FollowCsvInput::open(const std::string& input_file, unsigned poll_interval_ms) {
+	std::FILE* file = std::fopen(input_file.c_str(), "rb");
+	if (file == nullptr) {
+		return nullptr;
+	}
+	return new FollowCsvInput(file, poll_interval_ms);
+}
+
+std::uint64_t FollowCsvInput::fileSize() const {
+#ifdef _WIN32
+	struct _stat64 st;
+	if (_fstat64(_fileno(this->file), &st) != 0) {
+#else
+	struct stat st;
+	if (fstat(fileno(this->file), &st) != 0) {
+#endif
+		throw std::runtime_error("input file couldn't be read");
+	}
+	return (std::uint64_t) st.st_size;
+}
+
+void FollowCsvInput::fill(size_t consumed) {
+	// move the unconsumed rest to the front of the window and make room for a block after it
+	size_t remaining = this->window_size - consumed;
+	if (consumed > 0 && remaining > 0) {
+		std::memmove(this->buffer.data(), this->window_data + consumed, remaining);
+	}
+	this->window_size = remaining;
+	this->window_offset += consumed;
+	if (remaining + BLOCK_SIZE > this->buffer.size()) {
+		this->buffer.resize(remaining + BLOCK_SIZE);
+	}
+	this->window_data = this->buffer.data();
+
+	// at the end of the file wait once for it to grow
+	if (read() == 0) {
+		if (fileSize() < this->bytes_read) {
+			throw std::runtime_error("the input file was truncated while it was followed");
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(this->poll_interval_ms));
+		read();
+	}
+	if (!this->compression_checked && this->bytes_read >= 4) {
+		this->compression_checked = true;
+		if (this->window_offset == 0 && StreamCsvInput::isCompressed(reinterpret_cast<const unsigned char*>(this->window_data), this->window_size)) {
+			throw std::runtime_error("compressed input files can't be followed");
+		}
+	}
+}
+
+size_t FollowCsvInput::read() {
+	size_t read = std::fread(this->buffer.data() + this->window_size, 1, this->buffer.size() - this->window_size, this->file);
+	if (std::ferror(this->file)) {
+		throw std::runtime_error("input file couldn't be read");
+	}
+	// the end of the file is only the end of what was written so far
+	std::clearerr(this->file);
+	this->window_size += read;
+	this->bytes_read += read;
+	return read;
+}
+
+#ifndef _WIN32
+MappedCsvInput::MappedCsvInput(void* mapping, size_t length) : MemoryCsvInput(static_cast<const char*>(mapping), length), mapping(mapping), mapping_length(length) {
+	madvise(mapping, length, MADV_SEQUENTIAL);
+}
+
+MappedCsvInput::~MappedCsvInput() {
+	munmap(this->mapping, this->mapping_length);
+}
+#endif
@@ -0,0 +1,197 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+* A window of raw input bytes the csv tokenizer works on. The window always
+* starts at the first byte that wasn't consumed yet and ends at the last byte
+* that was read from the source.
+*/
+class CsvInput {
+public:
+	virtual ~CsvInput() {}
+
+	const char* data() const { return this->window_data; }
+	size_t size() const { return this->window_size; }
+
+	/*
+	* returns the position of the window's first byte in the source
+	*/
+	std::uint64_t offset() const { return this->window_offset; }
+
+	/*
+	* returns true if the window contains all remaining bytes of the source
+	*/
+	bool eof() const { return this->source_exhausted; }
+
+	/*
+	* returns true if the bytes of the window stay valid until the input is destroyed, even after fill() was called
+	*/
+	bool persistent() const { return this->persistent_window; }
+
+	/*
+	* discards the first consumed bytes of the window and appends new data from the source. blocks until at least one new byte was appended or the source is exhausted, only a followed file returns without new data once it waited for the file to grow.
+	*/
+	virtual void fill(size_t consumed) = 0;
+
+	/*
+	* discards the next bytes of the source, throws if the source ends before
+	*/
+	void skip(std::uint64_t bytes);
+
+	/*
+	* opens the given input file, or stdin if it is "-". uncompressed regular files are memory mapped if possible, everything else is streamed. returns nullptr if the file can't be opened.
+	*/
+	static CsvInput* open(const std::string& input_file);
+
+protected:
+	const char* window_data = nullptr;
+	size_t window_size = 0;
+	std::uint64_t window_offset = 0;
+	bool source_exhausted = false;
+	bool persistent_window = false;
+};
+
+/**
+* Provides bytes that are already in memory and owned by the caller.
+*/
+class MemoryCsvInput : public CsvInput {
+public:
+	MemoryCsvInput(const char* data, size_t length);
+	void fill(size_t consumed);
+};
+
+/**
+* Reads a stream like stdin, a pipe or a compressed file on a background thread
+* into a ring of blocks, and decompresses gzip and zstd streams on the way.
+* The compression is detected from the first bytes of the stream.
+*/
+class StreamCsvInput : public CsvInput {
+public:
+	static const size_t DEFAULT_BLOCK_SIZE = 4 * 1024 * 1024;
+	static const size_t DEFAULT_RING_BLOCKS = 4;
+
+	/*
+	* starts reading the given file, the input takes ownership of it
+	*/
+	StreamCsvInput(std::FILE* file, size_t block_size = DEFAULT_BLOCK_SIZE, size_t ring_blocks = DEFAULT_RING_BLOCKS);
+	~StreamCsvInput();
+	void fill(size_t consumed);
+
+	/*
+	* returns true if the given bytes start with a gzip or zstd magic number
+	*/
+	static bool isCompressed(const unsigned char* data, size_t length);
+
+private:
+	enum Compression { COMPRESSION_NONE, COMPRESSION_GZIP, COMPRESSION_ZSTD };
+
+	std::FILE* file;
+	size_t block_size;
+	std::vector<char> buffer; // the window
+
+	// ring of decoded blocks, filled by the reader thread
+	std::vector<std::unique_ptr<char[]>> ring;
+	std::vector<size_t> ring_lengths;
+	size_t ring_head = 0; // next block to consume
+	size_t ring_count = 0; // number of decoded blocks
+	bool reading_finished = false;
+	bool stopping = false;
+	std::exception_ptr error;
+	std::mutex mutex;
+	std::condition_variable block_decoded;
+	std::condition_variable block_consumed;
+	std::thread reader;
+
+	// compressed input of the reader thread
+	Compression compression = COMPRESSION_NONE;
+	std::vector<char> raw;
+	size_t raw_position = 0;
+	size_t raw_length = 0;
+	bool raw_eof = false;
+	bool frame_complete = true; // the decoder is at the boundary of a compressed frame
+	void* decoder = nullptr;
+
+	static const size_t RAW_BUFFER_SIZE = 256 * 1024;
+
+	void readBlocks();
+	bool readRaw();
+	void initDecoder();
+	size_t decode(char* block, size_t length);
+	size_t decodeGzip(char* block, size_t length);
+	size_t decodeZstd(char* block, size_t length);
+	void freeDecoder();
+};
+
+/**
+* Reads an uncompressed file that is still being appended to. At the end of the
+* file fill() waits up to the poll interval for it to grow and returns without
+* new data otherwise, the input is never exhausted. A reader then stops at the
+* incomplete last row and reads it again once the rest of it was written.
+*/
+class FollowCsvInput : public CsvInput {
+public:
+	static const size_t BLOCK_SIZE = 4 * 1024 * 1024;
+
+	/*
+	* follows the given file, the input takes ownership of it
+	*/
+	FollowCsvInput(std::FILE* file, unsigned poll_interval_ms);
+	~FollowCsvInput();
+	void fill(size_t consumed);
+
+	/*
+	* returns the current size of the file
+	*/
+	std::uint64_t fileSize() const;
+
+	/*
+	* opens the given input file to follow it. returns nullptr if it can't be opened.
+	*/
+	static FollowCsvInput* open(const std::string& input_file, unsigned poll_interval_ms);
+
+private:
+	std::FILE* file;
+	unsigned poll_interval_ms;
+	std::vector<char> buffer; // the window
+	std::uint64_t bytes_read = 0;
+	bool compression_checked = false;
+
+	size_t read();
+};
+
+#ifndef _WIN32
+/**
+* Maps the whole source file into memory, the window covers the entire file.
+*/
+class MappedCsvInput : public MemoryCsvInput {
+public:
+	MappedCsvInput(void* mapping, size_t length);
+	~MappedCsvInput();
+
+private:
+	void* mapping;
+	size_t mapping_length;
+};
+#endif
@@ -0,0 +1,551 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+#include "csv_reader.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+#define MCSIMPORT_X86_SIMD
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+static inline unsigned countTrailingZeros(std::uint64_t x) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, x);
+	return (unsigned) index;
+#else
+	return (unsigned) __builtin_ctzll(x);
+#endif
+}
+
+/**
+* The characters of a dialect known at compile time, so that the comparisons with
+* them become constants and the special case of the same escape and enclose by
+* character is decided by the compiler.
+*/
+template <char Delimiter, char Escape, char Enclose>
+struct FixedCsvDialect {
+	FixedCsvDialect(char, char, char) {}
+	char delimiter() const { return Delimiter; }
+	char escape() const { return Escape; }
+	char enclose() const { return Enclose; }
+	bool escapeIsEnclose() const { return Escape == Enclose; }
+};
+typedef FixedCsvDialect<',', '"', '"'> Rfc4180CsvDialect;
+typedef FixedCsvDialect<'\t', '"', '"'> TabCsvDialect;
+typedef FixedCsvDialect<'|', '"', '"'> PipeCsvDialect;
+
+/**
+* The characters of any other dialect, compared at runtime.
+*/
+struct GenericCsvDialect {
+	GenericCsvDialect(char delimiter, char escape_character, char enclose_by_character) : delimiter_character(delimiter), escape_character(escape_character), enclose_by_character(enclose_by_character) {}
+	char delimiter() const { return this->delimiter_character; }
+	char escape() const { return this->escape_character; }
+	char enclose() const { return this->enclose_by_character; }
+	bool escapeIsEnclose() const { return this->escape_character == this->enclose_by_character; }
+
+	char delimiter_character;
+	char escape_character;
+	char enclose_by_character;
+};
+
+CsvDialect csvDialect(char delimiter, char escape_character, char enclose_by_character) {
+	if (escape_character != '"' || enclose_by_character != '"') {
+		return CSV_DIALECT_GENERIC;
+	}
+	switch (delimiter) {
+	case ',': return CSV_DIALECT_RFC4180;
+	case '\t': return CSV_DIALECT_TAB;
+	case '|': return CSV_DIALECT_PIPE;
+	default: return CSV_DIALECT_GENERIC;
+	}
+}
+
+const char* csvDialectName(CsvDialect dialect) {
+	switch (dialect) {
+	case CSV_DIALECT_RFC4180: return "rfc4180";
+	case CSV_DIALECT_TAB: return "tab";
+	case CSV_DIALECT_PIPE: return "pipe";
+	default: return "generic";
+	}
+}
+
+// the structural characters are passed as delimiter, newline, enclose by and escape character, a dialect with the same escape and enclose by character only needs three comparisons
+#ifndef MCSIMPORT_X86_SIMD
+template <class Dialect>
+static std::uint64_t structuralMaskScalar(const char* block, const char* c) {
+	Dialect dialect(c[0], c[3], c[2]);
+	std::uint64_t mask = 0;
+	for (unsigned i = 0; i < 64; i++) {
+		char ch = block[i];
+		if (ch == dialect.delimiter() || ch == '\n' || ch == dialect.enclose() || ch == dialect.escape()) {
+			mask |= (std::uint64_t) 1 << i;
+		}
+	}
+	return mask;
+}
+#else
+template <class Dialect>
+static std::uint64_t structuralMaskSse2(const char* block, const char* c) {
+	Dialect dialect(c[0], c[3], c[2]);
+	const __m128i c0 = _mm_set1_epi8(dialect.delimiter());
+	const __m128i c1 = _mm_set1_epi8('\n');
+	const __m128i c2 = _mm_set1_epi8(dialect.enclose());
+	const __m128i c3 = _mm_set1_epi8(dialect.escape());
+	std::uint64_t mask = 0;
+	for (unsigned i = 0; i < 4; i++) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+		__m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, c0), _mm_cmpeq_epi8(v, c1)), _mm_cmpeq_epi8(v, c2));
+		if (!dialect.escapeIsEnclose()) {
+			m = _mm_or_si128(m, _mm_cmpeq_epi8(v, c3));
+		}
+		mask |= (std::uint64_t) (std::uint32_t) _mm_movemask_epi8(m) << (16 * i);
+	}
+	return mask;
+}
+
+template <class Dialect>
+#ifndef _MSC_VER
+__attribute__((target("avx2")))
+#endif
+static std::uint64_t structuralMaskAvx2(const char* block, const char* c) {
+	Dialect dialect(c[0], c[3], c[2]);
+	const __m256i c0 = _mm256_set1_epi8(dialect.delimiter());
+	const __m256i c1 = _mm256_set1_epi8('\n');
+	const __m256i c2 = _mm256_set1_epi8(dialect.enclose());
+	const __m256i c3 = _mm256_set1_epi8(dialect.escape());
+	__m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+	__m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+	__m256i mlo = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(lo, c0), _mm256_cmpeq_epi8(lo, c1)), _mm256_cmpeq_epi8(lo, c2));
+	__m256i mhi = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(hi, c0), _mm256_cmpeq_epi8(hi, c1)), _mm256_cmpeq_epi8(hi, c2));
+	if (!dialect.escapeIsEnclose()) {
+		mlo = _mm256_or_si256(mlo, _mm256_cmpeq_epi8(lo, c3));
+		mhi = _mm256_or_si256(mhi, _mm256_cmpeq_epi8(hi, c3));
+	}
+	return (std::uint64_t) (std::uint32_t) _mm256_movemask_epi8(mlo) | ((std::uint64_t) (std::uint32_t) _mm256_movemask_epi8(mhi) << 32);
+}
+
+static bool cpuSupportsAvx2() {
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) {
+		return false;
+	}
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) {
+		return false;
+	}
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif
+
+/*
+* returns the mask function of the given dialect for the instruction set of the cpu
+*/
+template <class Dialect>
+static CsvStructuralScanner::MaskFunction structuralMaskFunction(const char*& implementation_name) {
+#ifdef MCSIMPORT_X86_SIMD
+	if (cpuSupportsAvx2()) {
+		implementation_name = "avx2";
+		return structuralMaskAvx2<Dialect>;
+	}
+	implementation_name = "sse2";
+	return structuralMaskSse2<Dialect>;
+#else
+	implementation_name = "scalar";
+	return structuralMaskScalar<Dialect>;
+#endif
+}
+
+CsvStructuralScanner::CsvStructuralScanner(char delimiter, char escape_character, char enclose_by_character) {
+	this->structural_characters[0] = delimiter;
+	this->structural_characters[1] = '\n';
+	this->structural_characters[2] = enclose_by_character;
+	this->structural_characters[3] = escape_character;
+	this->csv_dialect = csvDialect(delimiter, escape_character, enclose_by_character);
+	switch (this->csv_dialect) {
+	case CSV_DIALECT_RFC4180:
+		this->mask_function = structuralMaskFunction<Rfc4180CsvDialect>(this->implementation_name);
+		break;
+	case CSV_DIALECT_TAB:
+		this->mask_function = structuralMaskFunction<TabCsvDialect>(this->implementation_name);
+		break;
+	case CSV_DIALECT_PIPE:
+		this->mask_function = structuralMaskFunction<PipeCsvDialect>(this->implementation_name);
+		break;
+	default:
+		this->mask_function = structuralMaskFunction<GenericCsvDialect>(this->implementation_name);
+	}
+}
+
+std::uint64_t CsvStructuralScanner::maskTail(const char* block, size_t length) const {
+	char padded[64] = { 0 };
+	std::memcpy(padded, block, length);
+	return this->mask(padded) & (((std::uint64_t) 1 << length) - 1);
+}
+
+CsvReader::CsvReader(char delimiter, char escape_character, char enclose_by_character) : scanner(delimiter, escape_character, enclose_by_character) {
+	this->delimiter = delimiter;
+	this->escape_character = escape_character;
+	this->enclose_by_character = enclose_by_character;
+}
+
+CsvReader::~CsvReader() {
+	close();
+}
+
+bool CsvReader::open(const std::string& input_file) {
+	close();
+	this->input = CsvInput::open(input_file);
+	this->position = 0;
+	return this->input != nullptr;
+}
+
+void CsvReader::open(CsvInput* input) {
+	close();
+	this->input = input;
+	this->position = 0;
+}
+
+std::uint64_t CsvReader::offset() const {
+	return this->input != nullptr ? this->input->offset() + this->position : 0;
+}
+
+void CsvReader::close() {
+	delete this->input;
+	this->input = nullptr;
+	this->scan_block = nullptr;
+}
+
+bool CsvReader::getNextCsvFields(std::vector<CsvField>& parsed_csv_fields) {
+	if (this->input == nullptr) {
+		return false;
+	}
+	for (;;) {
+		const char* row_end = nullptr;
+		this->row_begin = this->position;
+		ParseResult result = parseRow(this->input->data() + this->position, this->input->data() + this->input->size(), this->input->eof(), parsed_csv_fields, row_end);
+		if (result == ROW_COMPLETE) {
+			this->position = row_end - this->input->data();
+			return true;
+		}
+		if (result == NO_ROW) {
+			this->position = this->input->size();
+			return false;
+		}
+		// the row continues beyond the input window, read more data and parse it again
+		this->scan_block = nullptr;
+		size_t available = this->input->size() - this->position;
+		this->input->fill(this->position);
+		this->position = 0;
+		if (this->input->size() == available && !this->input->eof()) {
+			return false;
+		}
+	}
+}
+
+bool CsvReader::peekNextCsvFields(std::vector<CsvField>& parsed_csv_fields) {
+	if (!getNextCsvFields(parsed_csv_fields)) {
+		return false;
+	}
+	// the window still starts at or before the row, so it can simply be read again
+	this->position = this->row_begin;
+	this->scan_block = nullptr;
+	return true;
+}
+
+CsvInput* CsvReader::detach() {
+	CsvInput* input = this->input;
+	if (input != nullptr && this->position > 0) {
+		input->fill(this->position);
+	}
+	this->input = nullptr;
+	this->scan_block = nullptr;
+	return input;
+}
+
+size_t CsvReader::findRowsEnd(const char* begin, const char* end, size_t minimum_size, bool eof) const {
+	switch (this->scanner.dialect()) {
+	case CSV_DIALECT_RFC4180:
+		return findRowsEnd(Rfc4180CsvDialect(',', '"', '"'), begin, end, minimum_size, eof);
+	case CSV_DIALECT_TAB:
+		return findRowsEnd(TabCsvDialect('\t', '"', '"'), begin, end, minimum_size, eof);
+	case CSV_DIALECT_PIPE:
+		return findRowsEnd(PipeCsvDialect('|', '"', '"'), begin, end, minimum_size, eof);
+	default:
+		return findRowsEnd(GenericCsvDialect(this->delimiter, this->escape_character, this->enclose_by_character), begin, end, minimum_size, eof);
+	}
+}
+
+template <class Dialect>
+size_t CsvReader::findRowsEnd(const Dialect& dialect, const char* begin, const char* end, size_t minimum_size, bool eof) const {
+	// follows the enclosure state of parseRow() without building the fields
+	const char* skip_until = begin;
+	bool withInEnclosed = false;
+	const char* block = begin;
+	std::uint64_t mask = (size_t) (end - begin) >= 64 ? this->scanner.mask(begin) : this->scanner.maskTail(begin, end - begin);
+	for (;;) {
+		while (mask == 0) {
+			if (end - block <= 64) {
+				return eof ? end - begin : 0;
+			}
+			block += 64;
+			mask = (size_t) (end - block) >= 64 ? this->scanner.mask(block) : this->scanner.maskTail(block, end - block);
+		}
+		const char* s = block + countTrailingZeros(mask);
+		mask &= mask - 1;
+		if (s < skip_until) {
+			continue;
+		}
+		char ch = *s;
+
+		if (withInEnclosed) {
+			if (ch == dialect.escape()) {
+				if (s + 1 == end) {
+					return eof ? end - begin : 0;
+				}
+				if (s[1] != dialect.enclose() && s[1] != dialect.escape() && dialect.escapeIsEnclose()) {
+					withInEnclosed = false;
+				}
+				else {
+					skip_until = s + 2;
+				}
+			}
+			else if (ch == dialect.enclose()) {
+				withInEnclosed = false;
+			}
+		}
+		else if (ch == dialect.delimiter()) {
+			continue;
+		}
+		else if (ch == '\n') {
+			if ((size_t) (s + 1 - begin) >= minimum_size) {
+				return s + 1 - begin;
+			}
+		}
+		else if (ch == dialect.enclose()) {
+			withInEnclosed = true;
+		}
+	}
+}
+
+CsvReader::ParseResult CsvReader::parseRow(const char* begin, const char* end, bool eof, std::vector<CsvField>& parsed_csv_fields, const char*& row_end) {
+	switch (this->scanner.dialect()) {
+	case CSV_DIALECT_RFC4180:
+		return parseRow(Rfc4180CsvDialect(',', '"', '"'), begin, end, eof, parsed_csv_fields, row_end);
+	case CSV_DIALECT_TAB:
+		return parseRow(TabCsvDialect('\t', '"', '"'), begin, end, eof, parsed_csv_fields, row_end);
+	case CSV_DIALECT_PIPE:
+		return parseRow(PipeCsvDialect('|', '"', '"'), begin, end, eof, parsed_csv_fields, row_end);
+	default:
+		return parseRow(GenericCsvDialect(this->delimiter, this->escape_character, this->enclose_by_character), begin, end, eof, parsed_csv_fields, row_end);
+	}
+}
+
+template <class Dialect>
+CsvReader::ParseResult CsvReader::parseRow(const Dialect& dialect, const char* begin, const char* end, bool eof, std::vector<CsvField>& parsed_csv_fields, const char*& row_end) {
+	static const char empty_field[] = "";
+	parsed_csv_fields.clear();
+	this->unescaped.clear();
+	this->unescaped_fields.clear();
+
+	// the current field is either a view [field_begin, field_end) into the input, or if it had to be unescaped the tail of the scratch buffer starting at field_offset
+	const char* field_begin = nullptr;
+	const char* field_end = nullptr;
+	bool field_unescaped = false;
+	size_t field_offset = 0;
+	const char* run = begin; // start of the literal characters that weren't added to the field yet
+	const char* skip_until = begin; // structural characters before this position were already processed
+	bool withInEnclosed = false;
+
+	// fields of columns that aren't projected are only delimited, and kept as their raw text [field_start, end of field)
+	const std::vector<char>& projection = this->projection;
+	auto projected = [&projection](size_t column) {
+		return projection.empty() || (column < projection.size() && projection[column]);
+	};
+	const char* field_start = begin;
+	bool field_projected = projected(0);
+
+	auto append = [&](const char* from, const char* to) {
+		if (from == to || !field_projected) {
+			return;
+		}
+		if (field_unescaped) {
+			this->unescaped.insert(this->unescaped.end(), from, to);
+		}
+		else if (field_begin == nullptr) {
+			field_begin = from;
+			field_end = to;
+		}
+		else if (field_end == from) {
+			field_end = to;
+		}
+		else {
+			field_offset = this->unescaped.size();
+			this->unescaped.insert(this->unescaped.end(), field_begin, field_end);
+			this->unescaped.insert(this->unescaped.end(), from, to);
+			field_unescaped = true;
+		}
+	};
+	auto fieldLength = [&]() -> size_t {
+		return field_unescaped ? this->unescaped.size() - field_offset : (size_t) (field_end - field_begin);
+	};
+	auto pushField = [&](const char* raw_end) {
+		if (!field_projected) {
+			parsed_csv_fields.push_back(CsvField{ field_start, (size_t) (raw_end - field_start) });
+		}
+		else if (field_unescaped) {
+			this->unescaped_fields.push_back(std::make_pair(parsed_csv_fields.size(), field_offset));
+			parsed_csv_fields.push_back(CsvField{ nullptr, this->unescaped.size() - field_offset });
+		}
+		else {
+			parsed_csv_fields.push_back(CsvField{ field_begin != nullptr ? field_begin : empty_field, (size_t) (field_end - field_begin) });
+		}
+		field_begin = nullptr;
+		field_end = nullptr;
+		field_unescaped = false;
+		field_projected = projected(parsed_csv_fields.size());
+	};
+	auto completeRow = [&](const char* next_row) {
+		for (auto const& f : this->unescaped_fields) {
+			parsed_csv_fields[f.first].data = this->unescaped.data() + f.second;
+		}
+		row_end = next_row;
+		return ROW_COMPLETE;
+	};
+
+	// continue with the structural mask of the previous row if this row starts in the same block
+	const char* block;
+	std::uint64_t mask;
+	if (this->scan_block != nullptr && begin >= this->scan_block && begin < this->scan_block + 64) {
+		block = this->scan_block;
+		mask = this->scan_mask & (~(std::uint64_t) 0 << (begin - this->scan_block));
+	}
+	else {
+		block = begin;
+		mask = (size_t) (end - begin) >= 64 ? this->scanner.mask(begin) : this->scanner.maskTail(begin, end - begin);
+	}
+
+	for (;;) {
+		while (mask == 0) {
+			if (end - block <= 64) {
+				// the input window is exhausted
+				this->scan_block = nullptr;
+				if (!eof) {
+					return ROW_INCOMPLETE;
+				}
+				// submit the last field if the input ended without newline
+				append(run, end);
+				if ((field_projected ? fieldLength() > 0 : end > field_start) || parsed_csv_fields.size() > 0) {
+					pushField(end);
+					return completeRow(end);
+				}
+				return NO_ROW;
+			}
+			block += 64;
+			mask = (size_t) (end - block) >= 64 ? this->scanner.mask(block) : this->scanner.maskTail(block, end - block);
+		}
+		const char* s = block + countTrailingZeros(mask);
+		mask &= mask - 1;
+		if (s < skip_until) {
+			continue;
+		}
+		char ch = *s;
+
+		if (withInEnclosed) {
+			// escape character found
+			if (ch == dialect.escape()) {
+				append(run, s);
+				if (s + 1 == end) {
+					if (!eof) {
+						this->scan_block = nullptr;
+						return ROW_INCOMPLETE;
+					}
+					// a trailing escape character at the end of the input is dropped
+					run = end;
+					continue;
+				}
+				char next = s[1];
+				// escaped enclose by or escape character, the following character is taken literally
+				if (next == dialect.enclose() || next == dialect.escape()) {
+					run = s + 1;
+					skip_until = s + 2;
+				}
+				// in case enclose by and escape character are the same and no second enclose by char was found we have to end the enclosed by here
+				else if (dialect.escapeIsEnclose()) {
+					withInEnclosed = false;
+					run = s + 1;
+				}
+				// otherwise keep the escape character and the following character
+				else {
+					run = s;
+					skip_until = s + 2;
+				}
+			}
+			// enclose by character found
+			else if (ch == dialect.enclose()) {
+				append(run, s);
+				run = s + 1;
+				withInEnclosed = false;
+			}
+			// delimiter and newline are part of the enclosed field
+		}
+		else {
+			// delimiter found
+			if (ch == dialect.delimiter()) {
+				append(run, s);
+				pushField(s);
+				run = s + 1;
+				field_start = s + 1;
+			}
+			// endline found
+			else if (ch == '\n') {
+				append(run, s);
+				// remove Windows line ending
+				const char* raw_end = s > field_start && s[-1] == '\r' ? s - 1 : s;
+				if (field_projected && fieldLength() > 0) {
+					if (field_unescaped && this->unescaped.back() == '\r') {
+						this->unescaped.pop_back();
+					}
+					else if (!field_unescaped && *(field_end - 1) == '\r') {
+						field_end--;
+					}
+				}
+				pushField(raw_end);
+				this->scan_block = block;
+				this->scan_mask = mask;
+				return completeRow(s + 1);
+			}
+			// enclose by character found
+			else if (ch == dialect.enclose()) {
+				append(run, s);
+				run = s + 1;
+				withInEnclosed = true;
+			}
+			// an escape character outside of an enclosure is part of the field
+		}
+	}
+}
@@ -0,0 +1,200 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "csv_input.h"
+
+/**
+* A parsed csv field. It points either directly into the input window or, if
+* the field had to be unescaped, into the reader's scratch buffer. It is only
+* valid until the next row is read.
+*/
+struct CsvField {
+	const char* data;
+	size_t length;
+
+	bool empty() const { return this->length == 0; }
+	std::string str() const { return std::string(this->data, this->length); }
+	void assignTo(std::string& target) const { target.assign(this->data, this->length); }
+	template <size_t N>
+	bool operator==(const char (&literal)[N]) const {
+		return this->length == N - 1 && std::memcmp(this->data, literal, N - 1) == 0;
+	}
+	template <size_t N>
+	bool operator!=(const char (&literal)[N]) const {
+		return !(*this == literal);
+	}
+};
+
+/**
+* Splits an input into rows of fields. The fields of a row are only valid until
+* the next row is read.
+*/
+class RowReader {
+public:
+	virtual ~RowReader() {}
+
+	/*
+	* opens the given input file. returns false if it can't be opened.
+	*/
+	virtual bool open(const std::string& input_file) = 0;
+
+	/*
+	* reads from the given input, the reader takes ownership of it
+	*/
+	virtual void open(CsvInput* input) = 0;
+
+	/*
+	* splits the next row into a vector of fields. returns false if there is no further row, or if a followed input didn't grow, the incomplete row is read again by the next call then.
+	*/
+	virtual bool getNextCsvFields(std::vector<CsvField>& parsed_csv_fields) = 0;
+
+	/*
+	* like getNextCsvFields(), but the row stays unread and is returned again by the next call
+	*/
+	virtual bool peekNextCsvFields(std::vector<CsvField>& parsed_csv_fields) = 0;
+
+	/*
+	* hands the input over to the caller without closing it. its window starts at the first row that wasn't read yet.
+	*/
+	virtual CsvInput* detach() = 0;
+
+	/*
+	* returns the position of the next row in the input, or 0 if no input is open
+	*/
+	virtual std::uint64_t offset() const = 0;
+
+	virtual void close() = 0;
+
+	/*
+	* returns the length of the complete rows at the beginning of the given window that end at or after minimum_size bytes. returns 0 if more data is needed to find such a row end, and the length of the whole window if it is the end of the input.
+	*/
+	virtual size_t findRowsEnd(const char* begin, const char* end, size_t minimum_size, bool eof) const = 0;
+
+	/*
+	* restricts the fields that have to be parsed to the columns set in the given mask, all columns if it is empty. the other fields are still counted, but may be returned as their raw text.
+	*/
+	virtual void setProjection(const std::vector<char>& /*columns*/) {}
+};
+
+/**
+* The csv dialects whose tokenizers are specialized at compile time. Any other
+* combination of delimiter, escape and enclose by character is tokenized by the
+* generic one, that compares with the characters at runtime.
+*/
+enum CsvDialect {
+	CSV_DIALECT_RFC4180, // delimiter ',', escape and enclose by character '"'
+	CSV_DIALECT_TAB,     // delimiter '\t', escape and enclose by character '"'
+	CSV_DIALECT_PIPE,    // delimiter '|', escape and enclose by character '"'
+	CSV_DIALECT_GENERIC
+};
+
+/*
+* returns the specialized dialect of the given characters, or CSV_DIALECT_GENERIC
+*/
+CsvDialect csvDialect(char delimiter, char escape_character, char enclose_by_character);
+
+/*
+* returns the name of the dialect as shown by the benchmark
+*/
+const char* csvDialectName(CsvDialect dialect);
+
+/**
+* Finds the csv structural characters (delimiter, newline, enclose by and
+* escape character) 64 bytes at a time and returns a bitmask of their positions.
+*/
+class CsvStructuralScanner {
+public:
+	typedef std::uint64_t (*MaskFunction)(const char* block, const char* structural_characters);
+
+	CsvStructuralScanner(char delimiter, char escape_character, char enclose_by_character);
+
+	/*
+	* returns the bitmask of structural characters of the given 64 byte block
+	*/
+	std::uint64_t mask(const char* block) const { return this->mask_function(block, this->structural_characters); }
+
+	/*
+	* returns the bitmask of structural characters of a block shorter than 64 bytes
+	*/
+	std::uint64_t maskTail(const char* block, size_t length) const;
+
+	/*
+	* returns the name of the chosen implementation (avx2, sse2 or scalar)
+	*/
+	const char* implementation() const { return this->implementation_name; }
+
+	CsvDialect dialect() const { return this->csv_dialect; }
+
+private:
+	char structural_characters[4];
+	CsvDialect csv_dialect;
+	MaskFunction mask_function;
+	const char* implementation_name;
+};
+
+/**
+* Splits csv input into rows of fields. The escape and enclose semantics are:
+* - outside of an enclosure the delimiter ends a field, a newline ends a row, and the enclose by character starts an enclosure
+* - inside of an enclosure the escape character followed by the enclose by or escape character yields that character, otherwise both characters are kept
+* - if escape and enclose by character are the same, a single enclose by character ends the enclosure
+* - a carriage return before a newline that ends a row is removed
+* The tokenizer of the dialect is chosen once in the constructor.
+*/
+class CsvReader : public RowReader {
+public:
+	CsvReader(char delimiter, char escape_character, char enclose_by_character);
+	~CsvReader();
+	bool open(const std::string& input_file);
+	void open(CsvInput* input);
+	bool getNextCsvFields(std::vector<CsvField>& parsed_csv_fields);
+	bool peekNextCsvFields(std::vector<CsvField>& parsed_csv_fields);
+	CsvInput* detach();
+	std::uint64_t offset() const;
+	void close();
+	size_t findRowsEnd(const char* begin, const char* end, size_t minimum_size, bool eof) const;
+
+	/*
+	* fields of columns that aren't projected are skipped without unescaping them, and are returned as their raw text including enclose by and escape characters
+	*/
+	void setProjection(const std::vector<char>& columns) { this->projection = columns; }
+
+private:
+	enum ParseResult { ROW_COMPLETE, ROW_INCOMPLETE, NO_ROW };
+
+	char delimiter;
+	char escape_character;
+	char enclose_by_character;
+	CsvStructuralScanner scanner;
+	CsvInput* input = nullptr;
+	size_t position = 0; // position of the next row in the input window
+	size_t row_begin = 0; // position of the last row that was read
+	const char* scan_block = nullptr; // 64 byte block of the last row end and its remaining structural characters
+	std::uint64_t scan_mask = 0;
+	std::vector<char> projection; // the columns whose fields are parsed, all if empty
+
+	// scratch buffer for unescaped fields, and the fields pointing into it as (field index, offset)
+	std::vector<char> unescaped;
+	std::vector<std::pair<size_t, size_t>> unescaped_fields;
+
+	ParseResult parseRow(const char* begin, const char* end, bool eof, std::vector<CsvField>& parsed_csv_fields, const char*& row_end);
+	template <class Dialect>
+	ParseResult parseRow(const Dialect& dialect, const char* begin, const char* end, bool eof, std::vector<CsvField>& parsed_csv_fields, const char*& row_end);
+	template <class Dialect>
+	size_t findRowsEnd(const Dialect& dialect, const char* begin, const char* end, size_t minimum_size, bool eof) const;
+};
@@ -0,0 +1,118 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#include "error_log.h"
+
+#include <stdexcept>
+
+ErrorLog::ErrorLog() {
+	this->buffer.reserve(BUFFER_SIZE + 4096);
+	this->writer = std::thread(&ErrorLog::writeBlocks, this);
+}
+
+ErrorLog::~ErrorLog() {
+	try {
+		close();
+	}
+	catch (std::exception&) {
+	}
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopping = true;
+	}
+	this->block_queued.notify_all();
+	this->writer.join();
+}
+
+void ErrorLog::open(const std::string& file, bool append) {
+	if (this->file != nullptr) {
+		flush(true);
+	}
+	this->file = std::fopen(file.c_str(), append ? "ab" : "wb");
+	if (this->file == nullptr) {
+		throw std::runtime_error("Can't write to error file: " + file);
+	}
+	this->file_name = file;
+}
+
+void ErrorLog::writeLine(const std::string& line) {
+	this->buffer.append(line).push_back('\n');
+	if (this->buffer.size() >= BUFFER_SIZE) {
+		flush(false);
+	}
+}
+
+void ErrorLog::close() {
+	if (this->file != nullptr) {
+		flush(true);
+	}
+	wait();
+	std::lock_guard<std::mutex> lock(this->mutex);
+	if (this->error) {
+		std::exception_ptr error = this->error;
+		this->error = nullptr;
+		std::rethrow_exception(error);
+	}
+}
+
+void ErrorLog::flush(bool close_file) {
+	Block block;
+	block.file = this->file;
+	block.file_name = this->file_name;
+	block.data.swap(this->buffer);
+	block.close_file = close_file;
+	this->buffer.reserve(BUFFER_SIZE + 4096);
+	if (close_file) {
+		this->file = nullptr;
+	}
+	{
+		std::unique_lock<std::mutex> lock(this->mutex);
+		this->block_written.wait(lock, [this] { return this->queue.size() < MAX_QUEUED_BUFFERS; });
+		this->queue.push_back(std::move(block));
+	}
+	this->block_queued.notify_one();
+}
+
+void ErrorLog::wait() {
+	std::unique_lock<std::mutex> lock(this->mutex);
+	this->block_written.wait(lock, [this] { return this->queue.empty() && !this->writing; });
+}
+
+void ErrorLog::writeBlocks() {
+	for (;;) {
+		Block block;
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			this->block_queued.wait(lock, [this] { return this->stopping || !this->queue.empty(); });
+			if (this->queue.empty()) {
+				return;
+			}
+			block = std::move(this->queue.front());
+			this->queue.pop_front();
+			this->writing = true;
+		}
+		bool failed = block.file != nullptr && !block.data.empty() && std::fwrite(block.data.data(), 1, block.data.size(), block.file) != block.data.size();
+		if (block.close_file && block.file != nullptr && std::fclose(block.file) != 0) {
+			failed = true;
+		}
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			if (failed && !this->error) {
+				this->error = std::make_exception_ptr(std::runtime_error("Can't write to error file: " + block.file_name));
+			}
+			this->writing = false;
+		}
+		this->block_written.notify_all();
+	}
+}
@@ -0,0 +1,108 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "csv_reader.h"
+
+/**
+* Writes the error records of an import to error log files. Records are
+* formatted into a buffer, and full buffers are written by a background thread
+* in large writes, so that logging many errors doesn't slow down the import.
+* At most a few buffers are queued to cap the memory usage.
+*/
+class ErrorLog {
+public:
+	static const size_t BUFFER_SIZE = 1024 * 1024;
+	static const size_t MAX_QUEUED_BUFFERS = 4;
+
+	ErrorLog();
+
+	/*
+	* writes the remaining records, errors are ignored then
+	*/
+	~ErrorLog();
+
+	/*
+	* directs the following records to the given file, which is truncated unless append is set. throws std::runtime_error if it can't be opened.
+	*/
+	void open(const std::string& file, bool append);
+
+	/*
+	* appends a line of text
+	*/
+	void writeLine(const std::string& line);
+
+	/*
+	* appends a record of the given error type, column and the raw fields of the row, separated by commas
+	*/
+	void write(const char* error_type, std::int32_t column, const CsvField* fields, size_t field_count) {
+		write(error_type, std::to_string(column), fields, field_count);
+	}
+
+	/*
+	* appends a record like above for a column that is named, like a json path
+	*/
+	void write(const char* error_type, const std::string& column, const CsvField* fields, size_t field_count) {
+		this->buffer.append(error_type).append(", ").append(column).append(", ");
+		for (size_t i = 0; i < field_count; i++) {
+			if (i > 0) {
+				this->buffer.push_back(',');
+			}
+			this->buffer.append(fields[i].data, fields[i].length);
+		}
+		this->buffer.push_back('\n');
+		if (this->buffer.size() >= BUFFER_SIZE) {
+			flush(false);
+		}
+	}
+
+	/*
+	* writes all records and closes the current file. throws std::runtime_error if a write failed.
+	*/
+	void close();
+
+private:
+	struct Block {
+		std::FILE* file;
+		std::string file_name;
+		std::string data;
+		bool close_file;
+	};
+
+	std::FILE* file = nullptr; // the file new records are written to
+	std::string file_name;
+	std::string buffer; // records that weren't handed over to the writer yet
+
+	std::mutex mutex;
+	std::condition_variable block_queued;
+	std::condition_variable block_written;
+	std::deque<Block> queue;
+	bool writing = false; // the writer is writing a block it took from the queue
+	bool stopping = false;
+	std::exception_ptr error;
+	std::thread writer;
+
+	void flush(bool close_file);
+	void wait();
+	void writeBlocks();
+};
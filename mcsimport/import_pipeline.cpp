@@ -0,0 +1,250 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+#include "import_pipeline.h"
+#include "probes.h"
+
+ImportPipeline::ImportPipeline(size_t input_count, OpenFunction open, ReaderFactory new_reader, bool skip_header, unsigned workers, PrepareFunction prepare, ImportStats* stats, size_t chunk_size) {
+	this->input_count = input_count;
+	this->open = open;
+	this->new_reader = new_reader;
+	this->skip_header = skip_header;
+	this->prepare = prepare;
+	this->stats = stats;
+	this->chunk_size = chunk_size;
+	this->max_in_flight = 2 * (size_t) workers;
+	this->reader = std::thread(&ImportPipeline::readChunks, this);
+	for (unsigned w = 0; w < workers; w++) {
+		this->workers.push_back(std::thread(&ImportPipeline::processChunks, this));
+	}
+}
+
+ImportPipeline::~ImportPipeline() {
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopping = true;
+	}
+	this->work_available.notify_all();
+	this->slot_available.notify_all();
+	this->batch_completed.notify_all();
+	this->reader.join();
+	for (auto& w : this->workers) {
+		w.join();
+	}
+	delete this->current;
+	for (auto b : this->pending) {
+		delete b;
+	}
+	for (auto const& b : this->completed) {
+		delete b.second;
+	}
+}
+
+CsvRowBatch* ImportPipeline::next() {
+	if (this->current != nullptr) {
+		release(this->current);
+		this->current = nullptr;
+	}
+	CsvRowBatch* batch = nullptr;
+	{
+		std::unique_lock<std::mutex> lock(this->mutex);
+		this->batch_completed.wait(lock, [this] { return this->completed.count(this->next_sequence) > 0 || (this->reading_finished && this->next_sequence == this->chunk_count); });
+		auto it = this->completed.find(this->next_sequence);
+		if (it == this->completed.end()) {
+			return nullptr;
+		}
+		batch = it->second;
+		this->completed.erase(it);
+		this->next_sequence++;
+	}
+	if (batch->error) {
+		std::exception_ptr error = batch->error;
+		release(batch);
+		std::rethrow_exception(error);
+	}
+	this->current = batch;
+	return batch;
+}
+
+void ImportPipeline::release(CsvRowBatch* batch) {
+	delete batch;
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->in_flight--;
+	}
+	this->slot_available.notify_one();
+}
+
+void ImportPipeline::readChunks() {
+	CsvRowBatch* failed = nullptr;
+	try {
+		std::shared_ptr<CsvInput> input;
+		if (this->input_count > 0) {
+			input.reset(this->open(0));
+		}
+		for (size_t i = 0; i < this->input_count; i++) {
+			// open the next input ahead, so that a stream already decodes while this one is split. its errors are raised in order.
+			std::shared_ptr<CsvInput> next_input;
+			std::exception_ptr next_error;
+			if (i + 1 < this->input_count) {
+				try {
+					next_input.reset(this->open(i + 1));
+				}
+				catch (...) {
+					next_error = std::current_exception();
+				}
+			}
+			if (!readInput(i, input)) {
+				break;
+			}
+			if (next_error) {
+				std::rethrow_exception(next_error);
+			}
+			input = next_input;
+		}
+	}
+	catch (...) {
+		// the error is handed out in order after all chunks that were read before
+		failed = new CsvRowBatch();
+		failed->error = std::current_exception();
+	}
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		if (failed != nullptr) {
+			failed->sequence = this->chunk_count++;
+			this->completed[failed->sequence] = failed;
+			this->in_flight++;
+		}
+		this->reading_finished = true;
+	}
+	this->work_available.notify_all();
+	this->batch_completed.notify_all();
+}
+
+bool ImportPipeline::readInput(size_t input_index, const std::shared_ptr<CsvInput>& input) {
+	std::unique_ptr<RowReader> boundaries(this->new_reader());
+	size_t position = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			this->slot_available.wait(lock, [this] { return this->stopping || this->in_flight < this->max_in_flight; });
+			if (this->stopping) {
+				return false;
+			}
+		}
+		CsvRowBatch* batch = nullptr;
+		{
+			StageTimer timer(this->stats, ImportStats::STAGE_READ);
+			const char* begin = input->data() + position;
+			size_t length = boundaries->findRowsEnd(begin, input->data() + input->size(), this->chunk_size, input->eof());
+			if (length == 0) {
+				if (input->eof()) {
+					return true;
+				}
+				input->fill(position);
+				position = 0;
+				continue;
+			}
+			batch = new CsvRowBatch();
+			batch->input_index = input_index;
+			batch->offset = input->offset() + position;
+			if (input->persistent()) {
+				batch->data = begin;
+				batch->input = input;
+			}
+			else {
+				batch->buffer.assign(begin, begin + length);
+				batch->data = batch->buffer.data();
+			}
+			batch->size = length;
+			position += length;
+		}
+		if (this->stats != nullptr) {
+			this->stats->addBytes(batch->size);
+		}
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			batch->sequence = this->chunk_count++;
+			this->pending.push_back(batch);
+			this->in_flight++;
+		}
+		this->work_available.notify_one();
+	}
+}
+
+void ImportPipeline::processChunks() {
+	std::unique_ptr<RowReader> reader(this->new_reader());
+	for (;;) {
+		CsvRowBatch* batch = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			this->work_available.wait(lock, [this] { return this->stopping || !this->pending.empty() || this->reading_finished; });
+			if (this->stopping || this->pending.empty()) {
+				return;
+			}
+			batch = this->pending.front();
+			this->pending.pop_front();
+		}
+		try {
+			{
+				StageTimer timer(this->stats, ImportStats::STAGE_TOKENIZE);
+				tokenize(*reader, *batch);
+			}
+			StageTimer timer(this->stats, ImportStats::STAGE_CONVERT);
+			this->prepare(*batch);
+		}
+		catch (...) {
+			batch->error = std::current_exception();
+		}
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->completed[batch->sequence] = batch;
+		}
+		this->batch_completed.notify_all();
+	}
+}
+
+void ImportPipeline::tokenize(RowReader& reader, CsvRowBatch& batch) {
+	// unescaped fields are never longer than their raw row, so reserving the chunk size keeps the pointers into unescaped stable
+	batch.unescaped.reserve(batch.size);
+	const char* chunk_end = batch.data + batch.size;
+	std::vector<CsvField> parsed_csv_fields;
+	bool skip = this->skip_header && batch.offset == 0;
+	bool positions = mcsimportProbesEnabled();
+	size_t position = 0;
+	reader.open(new MemoryCsvInput(batch.data, batch.size));
+	while (reader.getNextCsvFields(parsed_csv_fields)) {
+		if (skip) {
+			skip = false;
+			position = (size_t) reader.offset();
+			continue;
+		}
+		if (positions) {
+			batch.row_positions.push_back(position);
+			position = (size_t) reader.offset();
+		}
+		batch.row_offsets.push_back(batch.fields.size());
+		for (auto const& f : parsed_csv_fields) {
+			if (f.data >= batch.data && f.data + f.length <= chunk_end) {
+				batch.fields.push_back(f);
+			}
+			else {
+				size_t offset = batch.unescaped.size();
+				batch.unescaped.insert(batch.unescaped.end(), f.data, f.data + f.length);
+				batch.fields.push_back(CsvField{ batch.unescaped.data() + offset, f.length });
+			}
+		}
+	}
+	batch.row_offsets.push_back(batch.fields.size());
+	reader.close();
+}
@@ -0,0 +1,110 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "csv_input.h"
+#include "csv_reader.h"
+#include "import_stats.h"
+#include "row_conversion.h"
+
+/**
+* A chunk of complete csv rows, its parsed fields and the values prepared for the target columns.
+*/
+struct CsvRowBatch {
+	std::uint64_t sequence = 0;
+	size_t input_index = 0; // the input the chunk was read from
+	std::uint64_t offset = 0; // position of the chunk in its input
+	const char* data = nullptr; // the raw chunk, either in buffer or in a persistent input window
+	size_t size = 0;
+	std::vector<char> buffer;
+	std::shared_ptr<CsvInput> input; // keeps a persistent input window alive
+	std::vector<char> unescaped; // fields that had to be unescaped
+	std::vector<CsvField> fields; // fields of all rows
+	std::vector<size_t> row_offsets; // index of the first field of each row followed by the total number of fields
+	std::vector<size_t> row_positions; // byte offset of each row in the chunk, only recorded while a probe is attached
+	std::vector<ConvertedValue> values; // prepared values, one per target column and row
+	std::vector<char> filtered; // per row if it was rejected by the row filter, empty without a filter
+	std::exception_ptr error;
+
+	size_t rowCount() const { return this->row_offsets.empty() ? 0 : this->row_offsets.size() - 1; }
+	const CsvField* rowFields(size_t row) const { return this->fields.data() + this->row_offsets[row]; }
+	size_t rowFieldCount(size_t row) const { return this->row_offsets[row + 1] - this->row_offsets[row]; }
+};
+
+/**
+* Splits the inputs on a reader thread into chunks at row boundaries, tokenizes
+* and prepares the chunks on worker threads, and hands them out in input order.
+* Several inputs are read one after another, the next input is already opened
+* while the current one is split, and chunks of different inputs are prepared
+* concurrently. At most two chunks per worker are in flight to cap the memory usage.
+*/
+class ImportPipeline {
+public:
+	typedef std::function<void(CsvRowBatch&)> PrepareFunction;
+	typedef std::function<CsvInput*(size_t)> OpenFunction;
+	typedef std::function<RowReader*()> ReaderFactory;
+	static const size_t DEFAULT_CHUNK_SIZE = 1024 * 1024;
+
+	/*
+	* starts the pipeline on input_count inputs that are opened in order on the reader thread by calling open with their index. open throws if an input can't be opened, the pipeline takes ownership of the returned inputs. each thread splits the inputs with its own reader made by new_reader. the header is skipped in each input that is read from its beginning. the read, tokenize and convert stages are timed in stats unless it is nullptr.
+	*/
+	ImportPipeline(size_t input_count, OpenFunction open, ReaderFactory new_reader, bool skip_header, unsigned workers, PrepareFunction prepare, ImportStats* stats = nullptr, size_t chunk_size = DEFAULT_CHUNK_SIZE);
+	~ImportPipeline();
+
+	/*
+	* returns the next batch in input order or nullptr if the input is exhausted. the batch stays valid until the next call. rethrows errors of the reader and worker threads.
+	*/
+	CsvRowBatch* next();
+
+private:
+	size_t input_count;
+	OpenFunction open;
+	ReaderFactory new_reader;
+	bool skip_header;
+	PrepareFunction prepare;
+	ImportStats* stats;
+	size_t chunk_size;
+	size_t max_in_flight;
+
+	std::mutex mutex;
+	std::condition_variable work_available;
+	std::condition_variable batch_completed;
+	std::condition_variable slot_available;
+	std::deque<CsvRowBatch*> pending;
+	std::map<std::uint64_t, CsvRowBatch*> completed;
+	std::uint64_t chunk_count = 0;
+	std::uint64_t next_sequence = 0;
+	CsvRowBatch* current = nullptr; // the batch last handed out by next()
+	size_t in_flight = 0;
+	bool reading_finished = false;
+	bool stopping = false;
+	std::thread reader;
+	std::vector<std::thread> workers;
+
+	void readChunks();
+	bool readInput(size_t input_index, const std::shared_ptr<CsvInput>& input);
+	void processChunks();
+	void tokenize(RowReader& reader, CsvRowBatch& batch);
+	void release(CsvRowBatch* batch);
+};
@@ -0,0 +1,129 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+#include "import_stats.h"
+
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+
+ImportStats::ImportStats() : start_time(Clock::now()), rows(0), bytes(0) {
+	for (auto& s : this->stage_nanoseconds) {
+		s.store(0);
+	}
+}
+
+ImportStats::~ImportStats() {
+	stopProgress();
+}
+
+double ImportStats::seconds(Stage stage) const {
+	return this->stage_nanoseconds[stage].load(std::memory_order_relaxed) / 1e9;
+}
+
+double ImportStats::elapsedSeconds() const {
+	return std::chrono::duration<double>(Clock::now() - this->start_time).count();
+}
+
+void ImportStats::startProgress(double interval) {
+	this->progress = std::thread(&ImportStats::reportProgress, this, interval);
+}
+
+void ImportStats::stopProgress() {
+	if (!this->progress.joinable()) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopping = true;
+	}
+	this->progress_stopped.notify_all();
+	this->progress.join();
+}
+
+void ImportStats::reportProgress(double interval) {
+	std::uint64_t last_rows = 0;
+	std::uint64_t last_bytes = 0;
+	Clock::time_point last_time = Clock::now();
+	std::unique_lock<std::mutex> lock(this->mutex);
+	for (;;) {
+		if (this->progress_stopped.wait_for(lock, std::chrono::duration<double>(interval), [this] { return this->stopping; })) {
+			return;
+		}
+		std::uint64_t current_rows = rowCount();
+		std::uint64_t current_bytes = byteCount();
+		Clock::time_point now = Clock::now();
+		double seconds = std::chrono::duration<double>(now - last_time).count();
+		std::ostringstream line;
+		line << std::fixed << std::setprecision(1) << "Progress: " << current_rows << " rows, " << current_bytes / 1e6 << " MB, " << (current_rows - last_rows) / seconds << " rows/s, " << (current_bytes - last_bytes) / 1e6 / seconds << " MB/s";
+		std::cerr << line.str() << std::endl;
+		last_rows = current_rows;
+		last_bytes = current_bytes;
+		last_time = now;
+	}
+}
+
+const char* ImportStats::stageName(Stage stage) {
+	switch (stage) {
+	case STAGE_READ:
+		return "read";
+	case STAGE_TOKENIZE:
+		return "tokenize";
+	case STAGE_CONVERT:
+		return "convert";
+	case STAGE_INJECT:
+		return "inject";
+	case STAGE_COMMIT:
+		return "commit";
+	case STAGE_WAIT:
+		return "wait";
+	case STAGE_SORT:
+		return "sort";
+	default:
+		return "unknown";
+	}
+}
+
+std::string ImportStats::jsonString(const std::string& value) {
+	std::string json = "\"";
+	for (char c : value) {
+		switch (c) {
+		case '"':
+			json += "\\\"";
+			break;
+		case '\\':
+			json += "\\\\";
+			break;
+		case '\n':
+			json += "\\n";
+			break;
+		case '\r':
+			json += "\\r";
+			break;
+		case '\t':
+			json += "\\t";
+			break;
+		default:
+			if ((unsigned char) c < 0x20) {
+				char escaped[7];
+				std::snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char) c);
+				json += escaped;
+			}
+			else {
+				json += c;
+			}
+		}
+	}
+	return json + "\"";
+}
@@ -0,0 +1,104 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+* Counters and timers of the import stages, updated by all threads of the import
+* with relaxed atomics. Stage times are summed over the threads a stage runs on.
+*/
+class ImportStats {
+public:
+	enum Stage {
+		STAGE_READ,     // reading and splitting the input into chunks
+		STAGE_TOKENIZE, // splitting rows into fields, includes reading without -j
+		STAGE_CONVERT,  // preparing the values of the target columns
+		STAGE_INJECT,   // setColumn() and writeRow()
+		STAGE_COMMIT,   // commit()
+		STAGE_WAIT,     // injection waiting for the next prepared chunk, or for a sort run to be written
+		STAGE_SORT,     // sorting, writing and merging the runs of -sort_by
+		STAGE_COUNT
+	};
+	typedef std::chrono::steady_clock Clock;
+
+	ImportStats();
+	~ImportStats();
+
+	void addTime(Stage stage, Clock::duration duration) { this->stage_nanoseconds[stage].fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count(), std::memory_order_relaxed); }
+	void addRows(std::uint64_t rows) { this->rows.fetch_add(rows, std::memory_order_relaxed); }
+	void addBytes(std::uint64_t bytes) { this->bytes.fetch_add(bytes, std::memory_order_relaxed); }
+
+	double seconds(Stage stage) const;
+	double elapsedSeconds() const;
+	std::uint64_t rowCount() const { return this->rows.load(std::memory_order_relaxed); }
+	std::uint64_t byteCount() const { return this->bytes.load(std::memory_order_relaxed); }
+
+	/*
+	* prints the rows and bytes processed and their rates since the last report to stderr every interval seconds, until stopProgress() is called
+	*/
+	void startProgress(double interval);
+	void stopProgress();
+
+	/*
+	* returns the name of the stage as used in the stats output
+	*/
+	static const char* stageName(Stage stage);
+
+	/*
+	* returns the given string as quoted and escaped json string
+	*/
+	static std::string jsonString(const std::string& value);
+
+private:
+	Clock::time_point start_time;
+	std::atomic<std::int64_t> stage_nanoseconds[STAGE_COUNT];
+	std::atomic<std::uint64_t> rows;
+	std::atomic<std::uint64_t> bytes;
+
+	std::thread progress;
+	std::mutex mutex;
+	std::condition_variable progress_stopped;
+	bool stopping = false;
+
+	void reportProgress(double interval);
+};
+
+/**
+* Adds the time from its construction to its destruction to a stage, if stats are collected.
+*/
+class StageTimer {
+public:
+	StageTimer(ImportStats* stats, ImportStats::Stage stage) : stats(stats), stage(stage) {
+		if (stats != nullptr) {
+			this->start = ImportStats::Clock::now();
+		}
+	}
+	~StageTimer() {
+		if (this->stats != nullptr) {
+			this->stats->addTime(this->stage, ImportStats::Clock::now() - this->start);
+		}
+	}
+
+private:
+	ImportStats* stats;
+	ImportStats::Stage stage;
+	ImportStats::Clock::time_point start;
+};
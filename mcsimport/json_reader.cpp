@@ -0,0 +1,489 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#include "json_reader.h"
+
+#include <cstring>
+
+static const char json_true[] = "1";
+static const char json_false[] = "0";
+static const char json_empty[] = "";
+
+static inline bool isJsonWhitespace(char c) {
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static int hexDigit(char c) {
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	}
+	if (c >= 'a' && c <= 'f') {
+		return c - 'a' + 10;
+	}
+	if (c >= 'A' && c <= 'F') {
+		return c - 'A' + 10;
+	}
+	return -1;
+}
+
+/*
+* reads the four hex digits of a \u escape sequence
+*/
+static bool parseHex4(const char* p, const char* end, std::uint32_t& value) {
+	if (end - p < 4) {
+		return false;
+	}
+	value = 0;
+	for (int i = 0; i < 4; i++) {
+		int digit = hexDigit(p[i]);
+		if (digit < 0) {
+			return false;
+		}
+		value = (value << 4) | (std::uint32_t) digit;
+	}
+	return true;
+}
+
+template <class Buffer>
+static void appendUtf8(std::uint32_t code_point, Buffer& target) {
+	if (code_point < 0x80) {
+		target.push_back((char) code_point);
+	}
+	else if (code_point < 0x800) {
+		target.push_back((char) (0xC0 | (code_point >> 6)));
+		target.push_back((char) (0x80 | (code_point & 0x3F)));
+	}
+	else if (code_point < 0x10000) {
+		target.push_back((char) (0xE0 | (code_point >> 12)));
+		target.push_back((char) (0x80 | ((code_point >> 6) & 0x3F)));
+		target.push_back((char) (0x80 | (code_point & 0x3F)));
+	}
+	else {
+		target.push_back((char) (0xF0 | (code_point >> 18)));
+		target.push_back((char) (0x80 | ((code_point >> 12) & 0x3F)));
+		target.push_back((char) (0x80 | ((code_point >> 6) & 0x3F)));
+		target.push_back((char) (0x80 | (code_point & 0x3F)));
+	}
+}
+
+/*
+* decodes the rest of a string that starts with an escape sequence at p into target up to the closing quote. returns the position after the quote or nullptr if the string is malformed. the decoded text is never longer than the escaped one.
+*/
+template <class Buffer>
+static const char* unescapeString(const char* p, const char* end, Buffer& target) {
+	while (p < end) {
+		char c = *p;
+		if (c == '"') {
+			return p + 1;
+		}
+		if ((unsigned char) c < 0x20) {
+			return nullptr;
+		}
+		if (c != '\\') {
+			target.push_back(c);
+			p++;
+			continue;
+		}
+		if (p + 1 == end) {
+			return nullptr;
+		}
+		switch (p[1]) {
+		case '"': target.push_back('"'); break;
+		case '\\': target.push_back('\\'); break;
+		case '/': target.push_back('/'); break;
+		case 'b': target.push_back('\b'); break;
+		case 'f': target.push_back('\f'); break;
+		case 'n': target.push_back('\n'); break;
+		case 'r': target.push_back('\r'); break;
+		case 't': target.push_back('\t'); break;
+		case 'u': {
+			std::uint32_t code_point;
+			if (!parseHex4(p + 2, end, code_point)) {
+				return nullptr;
+			}
+			p += 6;
+			// a high surrogate is combined with the following low surrogate
+			if (code_point >= 0xD800 && code_point <= 0xDBFF) {
+				std::uint32_t low;
+				if (end - p < 6 || p[0] != '\\' || p[1] != 'u' || !parseHex4(p + 2, end, low) || low < 0xDC00 || low > 0xDFFF) {
+					return nullptr;
+				}
+				code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+				p += 6;
+			}
+			else if (code_point >= 0xDC00 && code_point <= 0xDFFF) {
+				return nullptr;
+			}
+			appendUtf8(code_point, target);
+			continue;
+		}
+		default:
+			return nullptr;
+		}
+		p += 2;
+	}
+	return nullptr;
+}
+
+JsonReader::JsonReader(const std::vector<std::string>& paths) {
+	this->path_count = paths.size();
+	for (size_t i = 0; i < paths.size(); i++) {
+		std::vector<KeyNode>* nodes = &this->keys;
+		KeyNode* node = nullptr;
+		size_t begin = 0;
+		for (;;) {
+			size_t dot = paths[i].find('.', begin);
+			std::string key = paths[i].substr(begin, dot == std::string::npos ? std::string::npos : dot - begin);
+			node = nullptr;
+			for (auto& n : *nodes) {
+				if (n.key == key) {
+					node = &n;
+					break;
+				}
+			}
+			if (node == nullptr) {
+				nodes->push_back(KeyNode());
+				node = &nodes->back();
+				node->key = key;
+			}
+			if (dot == std::string::npos) {
+				break;
+			}
+			nodes = &node->children;
+			begin = dot + 1;
+		}
+		node->field = (std::int32_t) i;
+	}
+}
+
+JsonReader::~JsonReader() {
+	close();
+}
+
+bool JsonReader::open(const std::string& input_file) {
+	close();
+	this->input = CsvInput::open(input_file);
+	this->position = 0;
+	return this->input != nullptr;
+}
+
+void JsonReader::open(CsvInput* input) {
+	close();
+	this->input = input;
+	this->position = 0;
+}
+
+std::uint64_t JsonReader::offset() const {
+	return this->input != nullptr ? this->input->offset() + this->position : 0;
+}
+
+void JsonReader::close() {
+	delete this->input;
+	this->input = nullptr;
+}
+
+bool JsonReader::getNextCsvFields(std::vector<CsvField>& parsed_csv_fields) {
+	if (this->input == nullptr) {
+		return false;
+	}
+	for (;;) {
+		const char* data = this->input->data();
+		const char* begin = data + this->position;
+		const char* end = data + this->input->size();
+		const char* newline = (const char*) std::memchr(begin, '\n', end - begin);
+		if (newline == nullptr && !this->input->eof()) {
+			// the line continues beyond the input window, read more data
+			size_t available = end - begin;
+			this->input->fill(this->position);
+			this->position = 0;
+			if (this->input->size() == available && !this->input->eof()) {
+				return false;
+			}
+			continue;
+		}
+		if (newline == nullptr && begin == end) {
+			return false;
+		}
+		const char* line_end = newline != nullptr ? newline : end;
+		size_t line_begin = this->position;
+		this->position = (newline != nullptr ? newline + 1 : end) - data;
+		if (line_end > begin && line_end[-1] == '\r') {
+			line_end--;
+		}
+		const char* p = begin;
+		while (p < line_end && isJsonWhitespace(*p)) {
+			p++;
+		}
+		if (p == line_end) {
+			continue;
+		}
+		this->row_begin = line_begin;
+		parseLine(begin, line_end, parsed_csv_fields);
+		return true;
+	}
+}
+
+bool JsonReader::peekNextCsvFields(std::vector<CsvField>& parsed_csv_fields) {
+	if (!getNextCsvFields(parsed_csv_fields)) {
+		return false;
+	}
+	// the window still starts at or before the row, so it can simply be read again
+	this->position = this->row_begin;
+	return true;
+}
+
+CsvInput* JsonReader::detach() {
+	CsvInput* input = this->input;
+	if (input != nullptr && this->position > 0) {
+		input->fill(this->position);
+	}
+	this->input = nullptr;
+	return input;
+}
+
+size_t JsonReader::findRowsEnd(const char* begin, const char* end, size_t minimum_size, bool eof) const {
+	// json strings can't contain newlines, so every newline ends a row
+	if ((size_t) (end - begin) >= minimum_size) {
+		const char* from = begin + (minimum_size > 0 ? minimum_size - 1 : 0);
+		const char* newline = (const char*) std::memchr(from, '\n', end - from);
+		if (newline != nullptr) {
+			return newline + 1 - begin;
+		}
+	}
+	return eof ? end - begin : 0;
+}
+
+void JsonReader::parseLine(const char* begin, const char* end, std::vector<CsvField>& parsed_csv_fields) {
+	parsed_csv_fields.assign(this->path_count, CsvField{ json_empty, 0 });
+	this->unescaped.clear();
+	this->unescaped.reserve(end - begin);
+	this->cursor = begin;
+	this->line_end = end;
+	this->row_fields = parsed_csv_fields.data();
+	skipWhitespace();
+	bool valid = this->cursor < end && *this->cursor == '{' && parseObject(&this->keys, 1);
+	if (valid) {
+		skipWhitespace();
+		valid = this->cursor == end;
+	}
+	if (!valid) {
+		parsed_csv_fields.clear();
+	}
+	parsed_csv_fields.push_back(CsvField{ begin, (size_t) (end - begin) });
+}
+
+void JsonReader::skipWhitespace() {
+	while (this->cursor < this->line_end && isJsonWhitespace(*this->cursor)) {
+		this->cursor++;
+	}
+}
+
+bool JsonReader::parseObject(const std::vector<KeyNode>* nodes, unsigned depth) {
+	if (depth > MAX_DEPTH) {
+		return false;
+	}
+	this->cursor++;
+	skipWhitespace();
+	if (this->cursor < this->line_end && *this->cursor == '}') {
+		this->cursor++;
+		return true;
+	}
+	for (;;) {
+		CsvField key;
+		if (this->cursor == this->line_end || *this->cursor != '"' || !parseString(&key, true)) {
+			return false;
+		}
+		const KeyNode* node = nullptr;
+		if (nodes != nullptr) {
+			for (auto const& n : *nodes) {
+				if (n.key.size() == key.length && std::memcmp(n.key.data(), key.data, key.length) == 0) {
+					node = &n;
+					break;
+				}
+			}
+		}
+		skipWhitespace();
+		if (this->cursor == this->line_end || *this->cursor != ':') {
+			return false;
+		}
+		this->cursor++;
+		skipWhitespace();
+		if (!parseValue(node, depth)) {
+			return false;
+		}
+		skipWhitespace();
+		if (this->cursor == this->line_end) {
+			return false;
+		}
+		if (*this->cursor == '}') {
+			this->cursor++;
+			return true;
+		}
+		if (*this->cursor != ',') {
+			return false;
+		}
+		this->cursor++;
+		skipWhitespace();
+	}
+}
+
+bool JsonReader::parseArray(unsigned depth) {
+	if (depth > MAX_DEPTH) {
+		return false;
+	}
+	this->cursor++;
+	skipWhitespace();
+	if (this->cursor < this->line_end && *this->cursor == ']') {
+		this->cursor++;
+		return true;
+	}
+	for (;;) {
+		if (!parseValue(nullptr, depth)) {
+			return false;
+		}
+		skipWhitespace();
+		if (this->cursor == this->line_end) {
+			return false;
+		}
+		if (*this->cursor == ']') {
+			this->cursor++;
+			return true;
+		}
+		if (*this->cursor != ',') {
+			return false;
+		}
+		this->cursor++;
+		skipWhitespace();
+	}
+}
+
+bool JsonReader::parseValue(const KeyNode* node, unsigned depth) {
+	if (this->cursor == this->line_end) {
+		return false;
+	}
+	CsvField* field = node != nullptr && node->field >= 0 ? &this->row_fields[node->field] : nullptr;
+	const char* begin = this->cursor;
+	switch (*this->cursor) {
+	case '"':
+		return parseString(field, false);
+	case '{': {
+		// the object is searched for nested keys, and its raw text is the value if the path ends here
+		if (!parseObject(node != nullptr && !node->children.empty() ? &node->children : nullptr, depth + 1)) {
+			return false;
+		}
+		break;
+	}
+	case '[':
+		if (!parseArray(depth + 1)) {
+			return false;
+		}
+		break;
+	case 't':
+		if (!parseLiteral("true", 4)) {
+			return false;
+		}
+		if (field != nullptr) {
+			*field = CsvField{ json_true, 1 };
+		}
+		return true;
+	case 'f':
+		if (!parseLiteral("false", 5)) {
+			return false;
+		}
+		if (field != nullptr) {
+			*field = CsvField{ json_false, 1 };
+		}
+		return true;
+	case 'n':
+		if (!parseLiteral("null", 4)) {
+			return false;
+		}
+		if (field != nullptr) {
+			*field = CsvField{ json_empty, 0 };
+		}
+		return true;
+	default:
+		return parseNumber(field);
+	}
+	if (field != nullptr) {
+		*field = CsvField{ begin, (size_t) (this->cursor - begin) };
+	}
+	return true;
+}
+
+bool JsonReader::parseString(CsvField* field, bool key) {
+	const char* begin = ++this->cursor;
+	const char* p = begin;
+	while (p < this->line_end && *p != '"' && *p != '\\' && (unsigned char) *p >= 0x20) {
+		p++;
+	}
+	if (p == this->line_end || (unsigned char) *p < 0x20) {
+		return false;
+	}
+	if (*p == '"') {
+		// no escape sequences, the field points into the input
+		if (field != nullptr) {
+			*field = CsvField{ begin, (size_t) (p - begin) };
+		}
+		this->cursor = p + 1;
+		return true;
+	}
+	if (key) {
+		this->key_buffer.assign(begin, p);
+		this->cursor = unescapeString(p, this->line_end, this->key_buffer);
+		if (field != nullptr) {
+			*field = CsvField{ this->key_buffer.data(), this->key_buffer.size() };
+		}
+		return this->cursor != nullptr;
+	}
+	// strings with escape sequences are unescaped into the scratch buffer, which doesn't grow beyond the reserved line length
+	size_t offset = this->unescaped.size();
+	this->unescaped.insert(this->unescaped.end(), begin, p);
+	this->cursor = unescapeString(p, this->line_end, this->unescaped);
+	if (this->cursor == nullptr) {
+		return false;
+	}
+	if (field != nullptr) {
+		*field = CsvField{ this->unescaped.data() + offset, this->unescaped.size() - offset };
+	}
+	else {
+		this->unescaped.resize(offset);
+	}
+	return true;
+}
+
+bool JsonReader::parseNumber(CsvField* field) {
+	// the characters of a number are taken as they are, their conversion checks if they form a valid one
+	const char* begin = this->cursor;
+	if (*begin != '-' && (*begin < '0' || *begin > '9')) {
+		return false;
+	}
+	const char* p = begin + 1;
+	while (p < this->line_end && ((*p >= '0' && *p <= '9') || *p == '.' || *p == 'e' || *p == 'E' || *p == '+' || *p == '-')) {
+		p++;
+	}
+	if (field != nullptr) {
+		*field = CsvField{ begin, (size_t) (p - begin) };
+	}
+	this->cursor = p;
+	return true;
+}
+
+bool JsonReader::parseLiteral(const char* literal, size_t length) {
+	if ((size_t) (this->line_end - this->cursor) < length || std::memcmp(this->cursor, literal, length) != 0) {
+		return false;
+	}
+	this->cursor += length;
+	return true;
+}
@@ -0,0 +1,86 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "csv_input.h"
+#include "csv_reader.h"
+
+/**
+* Splits JSON Lines (ndjson) input into rows of fields. Each line holds one json
+* object, and each field is the value of one of the given key paths. A path
+* names a key of the object, or of nested objects separated by dots like
+* "address.city". The fields are:
+* - the text of strings, unescaped if needed
+* - the text of numbers
+* - "1" for true and "0" for false
+* - an empty field for null and for keys that are missing
+* - the raw json text of objects and arrays
+* The row ends with an additional field that holds the whole line. A line that
+* isn't a json object is returned as only that field, so its number of fields
+* shows that it is malformed. Empty lines are skipped.
+*/
+class JsonReader : public RowReader {
+public:
+	static const unsigned MAX_DEPTH = 64; // objects and arrays nested deeper are malformed
+
+	explicit JsonReader(const std::vector<std::string>& paths);
+	~JsonReader();
+	bool open(const std::string& input_file);
+	void open(CsvInput* input);
+	bool getNextCsvFields(std::vector<CsvField>& parsed_csv_fields);
+	bool peekNextCsvFields(std::vector<CsvField>& parsed_csv_fields);
+	CsvInput* detach();
+	std::uint64_t offset() const;
+	void close();
+	size_t findRowsEnd(const char* begin, const char* end, size_t minimum_size, bool eof) const;
+
+	/*
+	* returns the number of fields of a well formed row, that is the number of paths and the line
+	*/
+	size_t fieldCount() const { return this->path_count + 1; }
+
+private:
+	// the keys of the paths as a tree, a key either selects a field or continues a path into a nested object
+	struct KeyNode {
+		std::string key;
+		std::int32_t field = -1;
+		std::vector<KeyNode> children;
+	};
+	std::vector<KeyNode> keys;
+	size_t path_count;
+
+	CsvInput* input = nullptr;
+	size_t position = 0; // position of the next row in the input window
+	size_t row_begin = 0; // position of the last row that was read
+
+	// parser state of the current line
+	const char* cursor = nullptr;
+	const char* line_end = nullptr;
+	CsvField* row_fields = nullptr;
+	std::vector<char> unescaped; // scratch buffer for unescaped strings, reserved to the line length so that fields stay valid
+	std::string key_buffer; // scratch buffer for keys with escape sequences
+
+	void parseLine(const char* begin, const char* end, std::vector<CsvField>& parsed_csv_fields);
+	bool parseObject(const std::vector<KeyNode>* nodes, unsigned depth);
+	bool parseArray(unsigned depth);
+	bool parseValue(const KeyNode* node, unsigned depth);
+	bool parseString(CsvField* field, bool key);
+	bool parseNumber(CsvField* field);
+	bool parseLiteral(const char* literal, size_t length);
+	void skipWhitespace();
+};
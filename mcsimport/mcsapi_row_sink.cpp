@@ -0,0 +1,132 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+#include "mcsapi_row_sink.h"
+
+#include <ctime>
+
+McsapiRowSink::McsapiRowSink(mcsapi::ColumnStoreDriver* driver, const std::string& database, const std::string& table, size_t columns) : driver(driver), database(database), table(table), columns(columns) {
+	this->bulk = driver->createBulkInsert(database, table, 0, 0);
+}
+
+McsapiRowSink::~McsapiRowSink() {
+	delete this->bulk;
+}
+
+void McsapiRowSink::setConversionCache(size_t capacity) {
+	this->datetime_memos.clear();
+#ifndef _WIN32
+	if (capacity > 0) {
+		this->datetime_memos.resize(this->columns, ConversionMemo<tm>(capacity));
+	}
+#else
+	// the cache parses the dates with strptime, that the Windows C runtime lacks
+	(void) capacity;
+#endif
+}
+
+void McsapiRowSink::writeRow(const ConvertedValue* values, mcsapi::columnstore_data_convert_status_t* statuses) {
+	if (this->bulk == nullptr) {
+		this->bulk = this->driver->createBulkInsert(this->database, this->table, 0, 0);
+	}
+	for (size_t col = 0; col < this->columns; col++) {
+		const ConvertedValue& v = values[col];
+		switch (v.type) {
+		case ConvertedValue::VALUE_NULL:
+			this->bulk->setNull(col, &statuses[col]);
+			break;
+		case ConvertedValue::VALUE_DATETIME: {
+			v.text.assignTo(this->string_value);
+#ifndef _WIN32
+			if (!this->datetime_memos.empty() && this->datetime_memos[col].enabled()) {
+				// the parsed fields are cached, ColumnStoreDateTime owns its implementation and can't be copied into the cache
+				ConversionMemo<tm>& memo = this->datetime_memos[col];
+				tm* time = memo.find(this->string_value);
+				if (time == nullptr) {
+					tm parsed = tm();
+					if (strptime(this->string_value.c_str(), v.format->c_str(), &parsed) != nullptr) {
+						time = &memo.insert(this->string_value, parsed);
+					}
+				}
+				if (time != nullptr) {
+					tm fields = *time; // set() may normalize the fields it is given
+					if (this->datetime_value.set(fields)) {
+						this->bulk->setColumn(col, this->datetime_value, &statuses[col]);
+						break;
+					}
+				}
+				// mcsapi is left to report a value that doesn't match the format or isn't a valid date
+			}
+#endif
+			mcsapi::ColumnStoreDateTime dt = mcsapi::ColumnStoreDateTime(this->string_value, *v.format);
+			this->bulk->setColumn(col, dt, &statuses[col]);
+			break;
+		}
+		case ConvertedValue::VALUE_DATETIME_FIELDS: {
+			tm time = tm();
+			time.tm_year = v.datetime.year - 1900;
+			time.tm_mon = v.datetime.month - 1;
+			time.tm_mday = v.datetime.day;
+			time.tm_hour = v.datetime.hour;
+			time.tm_min = v.datetime.minute;
+			time.tm_sec = v.datetime.second;
+			this->datetime_value.set(time);
+			this->bulk->setColumn(col, this->datetime_value, &statuses[col]);
+			break;
+		}
+		case ConvertedValue::VALUE_TRUE:
+			this->bulk->setColumn(col, 1, &statuses[col]);
+			break;
+		case ConvertedValue::VALUE_INT:
+			this->bulk->setColumn(col, v.int_value, &statuses[col]);
+			break;
+		case ConvertedValue::VALUE_UINT:
+			this->bulk->setColumn(col, v.uint_value, &statuses[col]);
+			break;
+		case ConvertedValue::VALUE_DECIMAL:
+			this->decimal_value.set(v.int_value, v.scale);
+			this->bulk->setColumn(col, this->decimal_value, &statuses[col]);
+			break;
+		case ConvertedValue::VALUE_DOUBLE:
+			this->bulk->setColumn(col, v.double_value, &statuses[col]);
+			break;
+		default:
+			v.text.assignTo(this->string_value);
+			this->bulk->setColumn(col, this->string_value, &statuses[col]);
+		}
+	}
+	this->bulk->writeRow();
+}
+
+RowSinkSummary McsapiRowSink::commit() {
+	RowSinkSummary summary;
+	if (this->bulk == nullptr) {
+		return summary;
+	}
+	this->bulk->commit();
+	mcsapi::ColumnStoreSummary& sum = this->bulk->getSummary();
+	summary.execution_time = sum.getExecutionTime();
+	summary.rows_inserted = sum.getRowsInsertedCount();
+	summary.truncation_count = sum.getTruncationCount();
+	summary.saturated_count = sum.getSaturatedCount();
+	summary.invalid_count = sum.getInvalidCount();
+	delete this->bulk;
+	this->bulk = nullptr;
+	return summary;
+}
+
+void McsapiRowSink::rollback() {
+	if (this->bulk != nullptr) {
+		this->bulk->rollback();
+	}
+}
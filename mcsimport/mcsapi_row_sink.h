@@ -0,0 +1,63 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <libmcsapi/mcsapi.h>
+#include "conversion_memo.h"
+#include "row_sink.h"
+
+/**
+* Injects the rows into a ColumnStore table through mcsapi bulk inserts. Each
+* commit ends the current bulk insert, the next row starts a new one.
+*/
+class McsapiRowSink : public RowSink {
+public:
+	/*
+	* starts a bulk insert into the given table, throws mcsapi::ColumnStoreError if that isn't possible
+	*/
+	McsapiRowSink(mcsapi::ColumnStoreDriver* driver, const std::string& database, const std::string& table, size_t columns);
+	~McsapiRowSink();
+
+	/*
+	* returns the number of columns of the table as resolved by the bulk insert started in the constructor
+	*/
+	size_t tableColumnCount() const { return this->bulk->getColumnCount(); }
+
+	/*
+	* caches up to capacity dates per column that mcsapi parses with a date format, which is the costliest conversion of repeated values. 0 disables the cache.
+	*/
+	void setConversionCache(size_t capacity);
+
+	/*
+	* returns the cache of each column, empty if it is disabled
+	*/
+	const std::vector<ConversionMemo<tm>>& conversionCaches() const { return this->datetime_memos; }
+
+	void writeRow(const ConvertedValue* values, mcsapi::columnstore_data_convert_status_t* statuses);
+	RowSinkSummary commit();
+	void rollback();
+
+private:
+	mcsapi::ColumnStoreDriver* driver;
+	std::string database;
+	std::string table;
+	size_t columns;
+	mcsapi::ColumnStoreBulkInsert* bulk = nullptr;
+	std::string string_value; // reused buffer for values that are handed over to mcsapi as string
+	mcsapi::ColumnStoreDateTime datetime_value; // reused for natively parsed and cached dates
+	mcsapi::ColumnStoreDecimal decimal_value; // reused for natively parsed decimals
+	std::vector<ConversionMemo<tm>> datetime_memos; // per column, the fields of dates parsed with a date format that mcsapi has to parse
+};
@@ -14,13 +14,37 @@
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <iomanip>
 #include <string>
 #include <sstream>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <libmcsapi/mcsapi.h>
 #include <yaml-cpp/yaml.h>
 #include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <glob.h>
+#include <unistd.h>
+#endif
+#include "csv_importer.h"
+#include "import_stats.h"
+#include "mcsapi_row_sink.h"
+#include "row_conversion.h"
+#include "row_filter.h"
+#include "row_sink.h"
+#include "spool_directory.h"
+#include "table_schema.h"
+#include "validation_row_sink.h"
 
 class InputParser {
 public:
@@ -28,6 +52,7 @@ public:
 		for (int i = 1; i < argc; ++i)
 			this->tokens.push_back(std::string(argv[i]));
 	}
+	explicit InputParser(const std::vector<std::string>& tokens) : tokens(tokens) {}
 	const std::string& getCmdOption(const std::string &option) const {
 		std::vector<std::string>::const_iterator itr;
 		itr = std::find(this->tokens.begin(), this->tokens.end(), option);
@@ -41,251 +66,693 @@ public:
 		return std::find(this->tokens.begin(), this->tokens.end(), option)
 			!= this->tokens.end();
 	}
+	// returns the tokens from the given position up to the first option, "-" alone isn't an option
+	std::vector<std::string> getPositionalArguments(size_t first) const {
+		std::vector<std::string> arguments;
+		for (size_t i = first; i < this->tokens.size(); i++) {
+			if (this->tokens[i].size() > 1 && this->tokens[i][0] == '-') {
+				break;
+			}
+			arguments.push_back(this->tokens[i]);
+		}
+		return arguments;
+	}
 private:
 	std::vector <std::string> tokens;
 };
 
+// set by SIGINT and SIGTERM to end a spool or follow import
+static volatile std::sig_atomic_t stopping = 0;
+
+static void requestStop(int) {
+	stopping = 1;
+}
+
+/**
+* The options of an import, as given on the command line or in a manifest entry
+*/
+struct ImportOptions {
+	std::vector<std::string> input_files;
+	std::string database;
+	std::string table;
+	std::string mapping_file;
+	std::string columnStoreXML;
+	std::string inputDateFormat;
+	std::int32_t nullOption = 0;
+	unsigned threads = 0;
+	std::uint64_t commit_rows = 0;
+	std::uint64_t commit_bytes = 0;
+	std::string checkpoint_file;
+	bool resume = false;
+	bool follow = false;
+	std::uint64_t commit_ms = 1000; // latency of the commits of a followed file
+	double follow_idle = 0; // ends following once the file didn't grow that long, 0 to follow until stopped
+	double progress_interval = 0;
+	std::string stats_json_file;
+	std::string catalog_cache_file;
+	double catalog_cache_ttl = 600;
+	std::vector<std::string> sort_by; // target columns
+	std::uint64_t sort_memory = 512 * 1024 * 1024;
+	std::string sort_tmpdir;
+	std::uint64_t conversion_cache = 0; // cached dates per column, 0 disables the cache
+	bool validate_only = false;
+	bool ndjson = false;
+	std::uint64_t max_errors = UINT64_MAX;
+	double max_error_ratio = -1;
+	bool default_non_mapped = false;
+	bool ignore_malformed_csv = false;
+	bool header = false;
+	bool error_log = false;
+	char delimiter = ',';
+	char escape_character = '"';
+	char enclose_by_character = '"';
+};
+
+/**
+* Thrown by MCSRemoteImport after a setup error was reported and everything was cleaned up, mcsimport exits with 2 then
+*/
+struct SetupError {};
+
+/**
+* Thrown by MCSRemoteImport if the table of a shared catalog doesn't match the bulk insert anymore, the catalog needs to be read again then
+*/
+struct OutdatedCatalogError : SetupError {};
+
+/**
+* Thrown by MCSRemoteImport if mcsapi failed during the setup, e.g. because the table wasn't found or the connection was lost
+*/
+struct McsapiError : SetupError {};
+
 class MCSRemoteImport {
 public:
-	MCSRemoteImport(std::string input_file, std::string database, std::string table, std::string mapping_file, std::string columnStoreXML, char delimiter, std::string inputDateFormat, bool default_non_mapped, char escape_character, char enclose_by_character, bool header, bool error_log, std::int32_t nullOption, bool ignore_malformed_csv) {
+	/*
+	* prepares the import of the given options. the summary and errors are written to out and err. a shared driver and catalog are used instead of connecting on its own if given. throws SetupError after the reason was written to err.
+	*/
+	MCSRemoteImport(const ImportOptions& options, std::ostream& out = std::cout, std::ostream& err = std::cerr, mcsapi::ColumnStoreDriver* shared_driver = nullptr, mcsapi::ColumnStoreSystemCatalog* shared_catalog = nullptr) : out(out), err(err) {
+		const std::vector<std::string>& input_files = options.input_files;
+		const std::string& database = options.database;
+		const std::string& table = options.table;
+		const std::string& mapping_file = options.mapping_file;
+		char delimiter = options.delimiter;
+		char escape_character = options.escape_character;
+		char enclose_by_character = options.enclose_by_character;
+		bool header = options.header;
+		bool default_non_mapped = options.default_non_mapped;
+		bool validate_only = options.validate_only;
+		bool ndjson = options.ndjson;
+		bool error_log = options.error_log;
+		std::uint64_t commit_rows = options.commit_rows;
+		std::uint64_t commit_bytes = options.commit_bytes;
+		bool resume = options.resume;
 		// check if we can connect to the ColumnStore database and extract the number of columns of the target table
+		this->database = database;
+		this->table = table;
+		this->catalog_cache_file = shared_catalog == nullptr ? options.catalog_cache_file : "";
+		this->columnStoreXML = options.columnStoreXML;
 		try {
-			if (columnStoreXML == "") {
-				this->driver = new mcsapi::ColumnStoreDriver();
+			if (shared_driver != nullptr) {
+				this->driver = shared_driver;
+				this->owns_driver = false;
+				this->schema = TableSchema(shared_catalog->getTable(database, table));
+			}
+			else {
+				if (options.columnStoreXML == "") {
+					this->driver = new mcsapi::ColumnStoreDriver();
+				}
+				else {
+					this->driver = new mcsapi::ColumnStoreDriver(options.columnStoreXML);
+				}
+				// the table is only resolved through the system catalog if it isn't cached
+				this->schema_cached = this->catalog_cache_file != "" && loadCachedSchema(options.catalog_cache_ttl);
+				if (!this->schema_cached) {
+					this->schema = TableSchema(this->driver->getSystemCatalog().getTable(database, table));
+				}
+			}
+			if (validate_only) {
+				this->sink = new ValidationRowSink(this->schema);
 			}
 			else {
-				this->driver = new mcsapi::ColumnStoreDriver(columnStoreXML);
+				this->mcsapi_sink = new McsapiRowSink(this->driver, database, table, this->schema.columnCount());
+				this->sink = this->mcsapi_sink;
+				// mcsapi only exposes the column count of the table the bulk insert resolved, a cached table whose count differs is stale
+				if (this->schema_cached && this->mcsapi_sink->tableColumnCount() != (size_t) this->schema.columnCount()) {
+					this->out << "Notice: The cached catalog entry of " << database << "." << table << " is outdated and is refetched" << std::endl;
+					this->schema_cached = false;
+					this->schema = TableSchema(this->driver->getSystemCatalog().getTable(database, table));
+					delete this->sink;
+					this->mcsapi_sink = new McsapiRowSink(this->driver, database, table, this->schema.columnCount());
+					this->sink = this->mcsapi_sink;
+				}
+				this->mcsapi_sink->setConversionCache((size_t) options.conversion_cache);
+				// a shared catalog is read once, the table might have been altered since
+				if (shared_catalog != nullptr && this->mcsapi_sink->tableColumnCount() != (size_t) this->schema.columnCount()) {
+					this->err << "Error: The system catalog entry of " << database << "." << table << " is outdated" << std::endl;
+					clean();
+					throw OutdatedCatalogError();
+				}
+			}
+			if (this->catalog_cache_file != "" && !this->schema_cached) {
+				storeCachedSchema(false);
 			}
-			this->cat = driver->getSystemCatalog();
-			this->tab = cat.getTable(database, table);
-			this->cs_table_columns = tab.getColumnCount();
-			this->bulk = driver->createBulkInsert(database, table, 0, 0);
+			this->cs_table_columns = this->schema.columnCount();
+			this->validate_only = validate_only;
 		}
 		catch (mcsapi::ColumnStoreError &e) {
-			std::cerr << "Error during mcsapi initialization: " << e.what() << std::endl;
+			this->err << "Error during mcsapi initialization: " << e.what() << std::endl;
 			clean();
-			std::exit(2);
+			throw McsapiError();
 		}
 
 		// check if delimiter and escape_character differ, and delimiter and enclose_by_character differ
 		if (delimiter == escape_character || delimiter == enclose_by_character) {
-			std::cerr << "Error: Different values need to be chosen for delimiter and enclose_by_character, and delimiter and escape_character" << std::endl;
-			std::cerr << "delimiter: " << delimiter << std::endl;
-			std::cerr << "enclose_by_character: " << enclose_by_character << std::endl;
-			std::cerr << "escape_character: " << escape_character << std::endl;
+			this->err << "Error: Different values need to be chosen for delimiter and enclose_by_character, and delimiter and escape_character" << std::endl;
+			this->err << "delimiter: " << delimiter << std::endl;
+			this->err << "enclose_by_character: " << enclose_by_character << std::endl;
+			this->err << "escape_character: " << escape_character << std::endl;
 			clean();
-			std::exit(2);
+			throw SetupError();
 		}
 
-		this->delimiter = delimiter;
-		this->escape_character = escape_character;
-		this->enclose_by_character = enclose_by_character;
-		this->nullOption = nullOption;
-		this->ignore_malformed_csv = ignore_malformed_csv;
+		this->importer = new CsvImporter(delimiter, escape_character, enclose_by_character, header, options.ignore_malformed_csv, options.threads);
+		this->importer->setErrorBudget(options.max_errors, options.max_error_ratio);
+		if (options.follow) {
+			this->importer->setFollow(options.commit_ms, options.follow_idle, [] { return stopping != 0; });
+		}
+		this->following = options.follow;
+		this->nullOption = options.nullOption;
+		this->ignore_malformed_csv = options.ignore_malformed_csv;
 
-		// check if the source csv file exists and extract the number of columns of its first row
-		std::ifstream csvFile(input_file);
-		if (!csvFile) {
-			std::cerr << "Error: Can't open input file " << input_file << std::endl;
-			clean();
-			std::exit(2);
+		// json values are selected by the key paths of the mapping, so it is generated before the input is opened
+		this->ndjson = ndjson;
+		this->inputDateFormat = options.inputDateFormat;
+		if (ndjson) {
+			generateMapping(INT32_MAX, default_non_mapped, mapping_file);
+			this->importer->setJsonPaths(this->json_paths);
 		}
-		std::ifstream csvFileStream(input_file);
-		std::vector<std::string> csv_header_fields;
-		getNextCsvFields(csvFileStream, csv_header_fields);
-		if (!csvFileStream.eof()) {
-			csvFileStream.close();
+
+		// check if the source csv files exist and extract the number of columns of the first row of the first file
+		std::vector<std::string> csv_first_row;
+		try {
+			this->importer->open(input_files, csv_first_row);
+		}
+		catch (std::exception& e) {
+			this->err << "Error: " << e.what() << std::endl;
+			clean();
+			throw SetupError();
 		}
-		this->number_of_csv_columns = csv_header_fields.size();
+		this->number_of_csv_columns = csv_first_row.size();
 		if (header) {
-			this->csv_header_field_names = csv_header_fields;
+			// source columns can be referred to by their header names, the first column of a name wins
+			for (size_t i = 0; i < csv_first_row.size(); i++) {
+				this->csv_header_columns.insert(std::make_pair(csv_first_row[i], (int32_t) i));
+			}
 		}
-		this->input_file = input_file;
-		this->inputDateFormat = inputDateFormat;
-		this->header = header;
+		this->input_files = input_files;
 
-		// check if there is no logging file and if mcsimport is able to create one
+		// check if there is no logging file and if mcsimport is able to create one for each input file
 		if (error_log) {
 			std::chrono::milliseconds ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
-			std::string errFile = input_file + "." + std::to_string(ms.count()) + ".err";
-			this->errFileStream.open(errFile);
-			if (!this->errFileStream) {
-				std::cerr << "Error: Can't write to error file: " << errFile << std::endl;
+			try {
+				this->importer->openErrorLogs("." + std::to_string(ms.count()) + ".err");
+			}
+			catch (std::exception& e) {
+				this->err << "Error: " << e.what() << std::endl;
 				clean();
-				std::exit(2);
+				throw SetupError();
 			}
-			this->errFileStream << "error_type, column_nr, parsed_raw_row_values" << std::endl;
 		}
 		this->error_log = error_log;
 
-		if (mapping_file == "") { // if no mapping file was provided use implicit mapping of columnstore_column to csv_column
-			generateImplicitMapping(this->number_of_csv_columns, default_non_mapped);
+		// continue after the last commit of a previous import if requested
+		this->checkpoint_file = options.checkpoint_file != "" ? options.checkpoint_file : (input_files[0] == "-" ? "stdin" : input_files[0]) + ".checkpoint";
+		if (resume) {
+			loadCheckpoint();
 		}
-		else { // if a mapping file was provided infer the mapping from the mapping file
-			generateExplicitMapping(this->number_of_csv_columns, default_non_mapped, mapping_file);
+		this->checkpointing = commit_rows > 0 || commit_bytes > 0 || resume || options.follow;
+		if (commit_rows > 0 || commit_bytes > 0 || options.follow) {
+			this->importer->setCommitInterval(commit_rows, commit_bytes, [this](size_t file, std::uint64_t offset, const RowSinkSummary& summary) { writeCheckpoint(file, offset, summary); });
+		}
+
+		// stage timers are only taken if they are reported
+		this->progress_interval = options.progress_interval;
+		this->stats_json_file = options.stats_json_file;
+		if (options.progress_interval > 0 || options.stats_json_file != "") {
+			this->stats = new ImportStats();
+			this->importer->setStats(this->stats);
+		}
+
+		if (!ndjson) {
+			generateMapping(this->number_of_csv_columns, default_non_mapped, mapping_file);
+		}
+		if (!this->rowFilter.empty()) {
+			this->importer->setRowFilter(&this->rowFilter);
+		}
+		generateConversionPlan();
+
+		// the sort keys are compared in the types of their target columns
+		if (!options.sort_by.empty()) {
+			std::vector<SortKey> keys;
+			for (auto const& name : options.sort_by) {
+				std::int32_t col = this->schema.findColumn(name);
+				if (col < 0) {
+					this->err << "Error: The sort column " << name << " doesn't exist in " << database << "." << table << std::endl;
+					clean();
+					throw SetupError();
+				}
+				keys.push_back(SortKey{ (size_t) col, this->schema.column(col).type, this->schema.column(col).scale });
+			}
+			this->importer->setSortKeys(keys, (size_t) options.sort_memory, options.sort_tmpdir != "" ? options.sort_tmpdir : RowSorter::defaultTempDirectory());
+			this->sorted = true;
 		}
 	}
 	int32_t import() {
-		std::ofstream errFile;
-		std::uint64_t ignored_malformed_csv_lines = 0;
+		if (this->progress_interval > 0) {
+			this->stats->startProgress(this->progress_interval);
+		}
+		if (this->following) {
+			this->out << "Following input file " << this->input_files[0] << " until SIGINT or SIGTERM is received" << std::endl;
+		}
 		try {
-			// generate a map of columnstore target column types
-			std::map<int32_t, mcsapi::columnstore_data_types_t> columnstore_column_types; // columnstore_column #, columnstore_column_data_type
-			for (int32_t c = 0; c < this->cs_table_columns; c++) {
-				columnstore_column_types[c] = tab.getColumn(c).getType();
-			}
-
-			std::ifstream csvFileStream(this->input_file);
-			std::vector<std::string> parsed_csv_fields;
-			// ignore the first line if it is the header
-			if (header) {
-				getNextCsvFields(csvFileStream, parsed_csv_fields);
-			}
-			mcsapi::columnstore_data_convert_status_t status;
-			while (getNextCsvFields(csvFileStream, parsed_csv_fields)){
-				//throw an exception and rollback the transaction if the parsed csv vector has not the exact number of fields as specified and ignore_malformed_csv is false
- 				if (parsed_csv_fields.size() != this->number_of_csv_columns && !ignore_malformed_csv) {
-					std::string errorMsg = "csv input parse error: the csv input file's columns of: " + std::to_string(parsed_csv_fields.size()) + " doesn't match the expected column count of the first line of: " + std::to_string(number_of_csv_columns) + "\nvalues: ";
-					if (parsed_csv_fields.size() > 0) {
-						for (int i = 0; i < parsed_csv_fields.size(); i++) {
-							errorMsg.append(parsed_csv_fields[i] + ", ");
-						}
-						errorMsg = errorMsg.substr(0, errorMsg.size() - 2);
-					}
-					throw std::range_error(errorMsg);
-				}
-				//ignore the csv line if the parsed csv vector has not the exact number of fields as specified and ignore_malformed_csv is true
-				else if (parsed_csv_fields.size() != this->number_of_csv_columns && ignore_malformed_csv) {
-					ignored_malformed_csv_lines++;
-					if (error_log) {
-						std::string parsed_raw_csv_field_string = vectorToString(parsed_csv_fields);
-						this->errFileStream << "MALFORMED_CSV_LINE, -1, " << parsed_raw_csv_field_string << std::endl;
-					}
-				}
-				// otherwise inject the values into the cs table
-				else {
-					for (int32_t col = 0; col < this->cs_table_columns; col++) {
-						int32_t csvColumn = this->mapping[col];
-						// set default values
-						if (csvColumn == CUSTOM_DEFAULT_VALUE || csvColumn == COLUMNSTORE_DEFAULT_VALUE) {
-							if ((customDefaultValue[col] == "" && this->tab.getColumn(col).isNullable()) || (this->nullOption == 1 && customDefaultValue[col] == "NULL" && this->tab.getColumn(col).isNullable())) {
-								bulk->setNull(col, &status);
-							}
-							else {
-								bulk->setColumn(col, customDefaultValue[col], &status);
-							}
-						}
-						// set values from csv vector
-						else {
-							// if the vector contains an empty value insert it as NULL
-							if ((parsed_csv_fields[csvColumn] == "") || (this->nullOption == 1 && parsed_csv_fields[csvColumn] == "NULL")) {
-								bulk->setNull(col, &status);
-							}
-							// if an (custom) input date format is specified and the target column is of type DATE or DATETIME, transform the input to ColumnStoreDateTime and inject it
-							else if ((this->customInputDateFormat.find(col) != this->customInputDateFormat.end() || this->inputDateFormat != "") && (columnstore_column_types[col] == mcsapi::DATA_TYPE_DATE || columnstore_column_types[col] == mcsapi::DATA_TYPE_DATETIME)) {
-								if (this->customInputDateFormat.find(col) != this->customInputDateFormat.end()) {
-									mcsapi::ColumnStoreDateTime dt = mcsapi::ColumnStoreDateTime((std::string) parsed_csv_fields[csvColumn], this->customInputDateFormat[col]);
-									bulk->setColumn(col, dt, &status);
-								}
-								else {
-									mcsapi::ColumnStoreDateTime dt = mcsapi::ColumnStoreDateTime((std::string) parsed_csv_fields[csvColumn], this->inputDateFormat);
-									bulk->setColumn(col, dt, &status);
-								}
-							}
-							// if value is true and target column is any NUMERIC type, transform true to 1 and inject it
-							else if (parsed_csv_fields[csvColumn] == "true" && (columnstore_column_types[col] == mcsapi::DATA_TYPE_BIGINT || columnstore_column_types[col] == mcsapi::DATA_TYPE_BIT || columnstore_column_types[col] == mcsapi::DATA_TYPE_DECIMAL || columnstore_column_types[col] == mcsapi::DATA_TYPE_DOUBLE || columnstore_column_types[col] == mcsapi::DATA_TYPE_FLOAT || columnstore_column_types[col] == mcsapi::DATA_TYPE_INT || columnstore_column_types[col] == mcsapi::DATA_TYPE_MEDINT || columnstore_column_types[col] == mcsapi::DATA_TYPE_SMALLINT || columnstore_column_types[col] == mcsapi::DATA_TYPE_TINYINT || columnstore_column_types[col] == mcsapi::DATA_TYPE_UBIGINT || columnstore_column_types[col] == mcsapi::DATA_TYPE_UDECIMAL || columnstore_column_types[col] == mcsapi::DATA_TYPE_UDOUBLE || columnstore_column_types[col] == mcsapi::DATA_TYPE_UFLOAT || columnstore_column_types[col] == mcsapi::DATA_TYPE_UINT || columnstore_column_types[col] == mcsapi::DATA_TYPE_UMEDINT || columnstore_column_types[col] == mcsapi::DATA_TYPE_USMALLINT || columnstore_column_types[col] == mcsapi::DATA_TYPE_UTINYINT)) {
-								bulk->setColumn(col, 1, &status);
-							}
-							else { // otherwise just inject the plain value as string
-								bulk->setColumn(col, (std::string) parsed_csv_fields[csvColumn], &status);
-							}
-						}
-						if (error_log && status != mcsapi::CONVERT_STATUS_NONE) {
-							//log the value and line that was saturated, invalid or truncated
-							std::string statusValue;
-							switch (status) {
-							case mcsapi::CONVERT_STATUS_SATURATED:
-								statusValue = "SATURATED";
-								break;
-							case mcsapi::CONVERT_STATUS_INVALID:
-								statusValue = "INVALID";
-								break;
-							case mcsapi::CONVERT_STATUS_TRUNCATED:
-								statusValue = "TRUNCATED";
-								break;
-							default:
-								statusValue = "UNKNOWN";
-							}
-							std::string parsed_raw_csv_field_string = vectorToString(parsed_csv_fields);
-							this->errFileStream << statusValue << ", " << csvColumn << ", " << parsed_raw_csv_field_string << std::endl;
-						}
-					}
-					bulk->writeRow();
-				}
+			this->importer->import(*this->sink, this->conversionPlan);
+			// the import is complete, so there is nothing left to resume. a followed file may grow further and keeps its checkpoint.
+			if (this->checkpointing && !this->following) {
+				std::remove(this->checkpoint_file.c_str());
 			}
-			bulk->commit();
 		}
 		catch (std::exception& e) {
-			std::cerr << "Error during mcsapi bulk operation: " << e.what() << std::endl;
-			bulk->rollback();
-			std::cerr << "Rollback performed." << std::endl;
+			// values that mcsapi can't convert are errors of the data, not of mcsapi
+			this->mcsapi_failed = dynamic_cast<mcsapi::ColumnStoreError*>(&e) != nullptr && dynamic_cast<mcsapi::ColumnStoreDataError*>(&e) == nullptr;
+			this->err << "Error during mcsapi bulk operation: " << e.what() << std::endl;
+			this->sink->rollback();
+			this->err << "Rollback performed." << std::endl;
+			// the failure might be caused by an outdated cached table, which is refetched by the next import
+			if (this->schema_cached) {
+				storeCachedSchema(true);
+			}
+			if (this->importer->summary().rows_inserted > 0) {
+				this->err << "Rows committed before the error: " << this->importer->summary().rows_inserted << std::endl;
+				this->err << "The import can be continued from checkpoint file " << this->checkpoint_file << " with -resume" << std::endl;
+			}
+			writeStats(false);
+			this->result = this->importer->summary();
 			clean();
 			return 3;
 		}
-		mcsapi::ColumnStoreSummary& sum = bulk->getSummary();
-		std::cout << "Execution time: " << sum.getExecutionTime() << "s" << std::endl;
-		std::cout << "Rows inserted: " << sum.getRowsInsertedCount() << std::endl;
-		std::cout << "Truncation count: " << sum.getTruncationCount() << std::endl;
-		std::cout << "Saturated count: " << sum.getSaturatedCount() << std::endl;
-		std::cout << "Invalid count: " << sum.getInvalidCount() << std::endl;
+		const RowSinkSummary& sum = this->importer->summary();
+		if (this->validate_only) {
+			this->out << "Validation only, the rows were checked but not written to " << this->database << "." << this->table << std::endl;
+		}
+		this->out << "Execution time: " << sum.execution_time << "s" << std::endl;
+		this->out << "Rows inserted: " << sum.rows_inserted << std::endl;
+		this->out << "Truncation count: " << sum.truncation_count << std::endl;
+		this->out << "Saturated count: " << sum.saturated_count << std::endl;
+		this->out << "Invalid count: " << sum.invalid_count << std::endl;
 		if (this->ignore_malformed_csv) {
-			std::cout << "Ignored malformed csv count: " << ignored_malformed_csv_lines << std::endl;
+			this->out << "Ignored malformed csv count: " << this->importer->ignoredMalformedCsvLines() << std::endl;
+		}
+		if (!this->rowFilter.empty()) {
+			this->out << "Rows filtered: " << this->importer->filteredRows() << std::endl;
+		}
+		if (this->sorted) {
+			this->out << "Sort runs written: " << this->importer->sortRunCount() << std::endl;
+		}
+		if (this->mcsapi_sink != nullptr) {
+			const auto& caches = this->mcsapi_sink->conversionCaches();
+			for (size_t col = 0; col < caches.size(); col++) {
+				if (caches[col].lookupCount() > 0) {
+					std::ostringstream line;
+					line << std::fixed << std::setprecision(1) << "Conversion cache of column " << this->schema.column((std::int32_t) col).name << ": " << 100.0 * caches[col].hitCount() / caches[col].lookupCount() << "% hit rate (" << caches[col].hitCount() << " of " << caches[col].lookupCount() << " lookups)" << (caches[col].disabled() ? ", disabled" : "");
+					this->out << line.str() << std::endl;
+				}
+			}
+		}
+		if (this->input_files.size() > 1) {
+			for (auto const& f : this->importer->fileStats()) {
+				this->out << "Input file: " << f.name << std::endl;
+				this->out << "  Rows inserted: " << f.rows_inserted << std::endl;
+				this->out << "  Truncation count: " << f.truncated << std::endl;
+				this->out << "  Saturated count: " << f.saturated << std::endl;
+				this->out << "  Invalid count: " << f.invalid << std::endl;
+				if (this->ignore_malformed_csv) {
+					this->out << "  Ignored malformed csv count: " << f.ignored_malformed_csv_lines << std::endl;
+				}
+				if (!this->rowFilter.empty()) {
+					this->out << "  Rows filtered: " << f.filtered << std::endl;
+				}
+				if (this->error_log) {
+					this->out << "  Error log: " << f.err_file << std::endl;
+				}
+			}
 		}
+		writeStats(true);
+		this->result = sum;
 
 		clean();
 		return 0;
 	}
+
+	/*
+	* returns the totals of the commits of import(), also if it failed
+	*/
+	const RowSinkSummary& summary() const { return this->result; }
+
+	/*
+	* returns true if import() failed in mcsapi, e.g. because the table was altered or the connection was lost, rather than because of the input
+	*/
+	bool failedInMcsapi() const { return this->mcsapi_failed; }
 private:
+	std::ostream& out;
+	std::ostream& err;
 	mcsapi::ColumnStoreDriver* driver = nullptr;
-	mcsapi::ColumnStoreBulkInsert* bulk = nullptr;
-	mcsapi::ColumnStoreSystemCatalog cat;
-	mcsapi::ColumnStoreSystemCatalogTable tab;
-	std::string input_file;
-	std::ofstream errFileStream;
+	bool owns_driver = true; // the driver isn't shared with other imports
+	TableSchema schema; // the columns of the target table
+	bool schema_cached = false; // the schema was read from the catalog cache
+	std::string catalog_cache_file;
+	std::string columnStoreXML;
+	std::string database;
+	std::string table;
+	bool validate_only = false; // the rows are only validated by a ValidationRowSink
+	RowSink* sink = nullptr;
+	McsapiRowSink* mcsapi_sink = nullptr; // the sink unless validate_only
+	CsvImporter* importer = nullptr;
+	RowSinkSummary result;
+	bool mcsapi_failed = false;
+	std::vector<std::string> input_files;
+	std::string checkpoint_file;
+	bool checkpointing = false; // if a checkpoint file can exist
+	bool following = false; // the input file is followed as it grows
+	std::uint64_t checkpoint_rows = 0; // rows committed by all runs of the import
+	ImportStats* stats = nullptr; // stage timers and counters, only if they are reported
+	double progress_interval = 0;
+	std::string stats_json_file;
 	std::string inputDateFormat;
-	bool header;
 	bool error_log;
 	bool ignore_malformed_csv;
-	char delimiter;
-	char escape_character;
-	char enclose_by_character;
 	std::int32_t nullOption;
 	int32_t cs_table_columns = -1;
 	int32_t number_of_csv_columns = -1;
-	std::vector<std::string> csv_header_field_names;
+	std::unordered_map<std::string, int32_t> csv_header_columns; // name of the header line's field, csv column
+	bool ndjson = false; // the input is JSON Lines, whose csv columns are the values of json_paths
+	std::vector<std::string> json_paths;
 	enum mapping_codes {COLUMNSTORE_DEFAULT_VALUE=-1, CUSTOM_DEFAULT_VALUE=-2};
 	std::map<int32_t, int32_t> mapping; // columnstore_column #, csv_column # or item of mapping_codes
 	std::map<int32_t, std::string> customInputDateFormat; //columnstore_column #, csv_input_date_format
 	std::map<int32_t, std::string> customDefaultValue; // columnstore_column #, custom_default_value
+	ConversionPlan conversionPlan; // how each columnstore column's value is derived from a csv row
+	RowFilter rowFilter; // the csv rows to import, all if empty
+	bool sorted = false; // the rows are written sorted by -sort_by
+
+	/**
+	* Records that the import can be resumed at the given input file and byte offset after a periodic commit
+	*/
+	void writeCheckpoint(size_t file, std::uint64_t offset, const RowSinkSummary& summary) {
+		this->checkpoint_rows += summary.rows_inserted;
+
+		// write the checkpoint to a temporary file first, so that a crash can't leave a partial checkpoint behind
+		YAML::Emitter out;
+		out << YAML::BeginMap;
+		out << YAML::Key << "database" << YAML::Value << this->database;
+		out << YAML::Key << "table" << YAML::Value << this->table;
+		out << YAML::Key << "input_files" << YAML::Value << this->input_files;
+		out << YAML::Key << "input_file" << YAML::Value << file;
+		out << YAML::Key << "offset" << YAML::Value << offset;
+		out << YAML::Key << "rows" << YAML::Value << this->checkpoint_rows;
+		out << YAML::EndMap;
+		std::string tmpFile = this->checkpoint_file + ".tmp";
+		std::ofstream tmpStream(tmpFile, std::ios::trunc);
+		tmpStream << out.c_str() << std::endl;
+		tmpStream.close();
+		if (!tmpStream) {
+			throw std::runtime_error("Can't write to checkpoint file: " + tmpFile);
+		}
+#ifndef _WIN32
+		// the checkpoint has to be on disk before it replaces the previous one, so that the import resumes after this commit also after a crash of the host
+		int fd = ::open(tmpFile.c_str(), O_RDONLY);
+		bool synced = fd >= 0 && fsync(fd) == 0;
+		if (fd >= 0) {
+			::close(fd);
+		}
+		if (!synced) {
+			throw std::runtime_error("Can't write to checkpoint file: " + tmpFile);
+		}
+#endif
+#ifdef _WIN32
+		std::remove(this->checkpoint_file.c_str());
+#endif
+		if (std::rename(tmpFile.c_str(), this->checkpoint_file.c_str()) != 0) {
+			throw std::runtime_error("Can't write to checkpoint file: " + this->checkpoint_file);
+		}
+	}
+
+	/**
+	* Reads the position to resume at from the checkpoint file, or starts at the beginning if there is none
+	*/
+	void loadCheckpoint() {
+		if (!std::ifstream(this->checkpoint_file)) {
+			this->out << "No checkpoint file " << this->checkpoint_file << " found, the import starts at the beginning" << std::endl;
+			return;
+		}
+		size_t resume_file;
+		std::uint64_t resume_offset;
+		try {
+			YAML::Node checkpoint = YAML::LoadFile(this->checkpoint_file);
+			if (checkpoint["database"].as<std::string>() != this->database || checkpoint["table"].as<std::string>() != this->table || checkpoint["input_files"].as<std::vector<std::string>>() != this->input_files) {
+				this->err << "Error: The checkpoint file " << this->checkpoint_file << " belongs to an import of different input files or into a different table" << std::endl;
+				clean();
+				throw SetupError();
+			}
+			resume_file = checkpoint["input_file"].as<size_t>();
+			resume_offset = checkpoint["offset"].as<std::uint64_t>();
+			this->checkpoint_rows = checkpoint["rows"].as<std::uint64_t>();
+		}
+		catch (YAML::Exception& e) {
+			this->err << "Error: Can't read checkpoint file " << this->checkpoint_file << ": " << e.what() << std::endl;
+			clean();
+			throw SetupError();
+		}
+		if (resume_file >= this->input_files.size()) {
+			this->err << "Error: The checkpoint file " << this->checkpoint_file << " refers to input file number " << resume_file << " of " << this->input_files.size() << std::endl;
+			clean();
+			throw SetupError();
+		}
+		this->importer->setResumePosition(resume_file, resume_offset);
+		this->out << "Resuming after " << this->checkpoint_rows << " committed rows at byte " << resume_offset << " of input file " << this->input_files[resume_file] << std::endl;
+	}
+
+	/**
+	* Reads the columns of the target table from the catalog cache. returns false if the table isn't cached for the same Columnstore.xml, its entry is older than ttl seconds, or the cache can't be read.
+	*/
+	bool loadCachedSchema(double ttl) {
+		std::int64_t now = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+		try {
+			YAML::Node cache = YAML::LoadFile(this->catalog_cache_file);
+			for (std::size_t i = 0; i < cache.size(); i++) {
+				YAML::Node entry = cache[i];
+				if (entry["database"].as<std::string>() != this->database || entry["table"].as<std::string>() != this->table || entry["columnstore_xml"].as<std::string>() != this->columnStoreXML) {
+					continue;
+				}
+				std::int64_t fetched = entry["fetched"].as<std::int64_t>();
+				if (now < fetched || now - fetched > ttl) {
+					return false;
+				}
+				TableSchema schema;
+				schema.database = this->database;
+				schema.table = this->table;
+				schema.oid = entry["oid"].as<std::uint32_t>();
+				for (auto const& c : entry["columns"]) {
+					ColumnSchema column;
+					column.name = c["name"].as<std::string>();
+					column.type = (mcsapi::columnstore_data_types_t) c["type"].as<int>();
+					column.position = c["position"].as<std::uint32_t>();
+					column.width = c["width"].as<std::uint32_t>();
+					column.precision = c["precision"].as<std::uint32_t>();
+					column.scale = c["scale"].as<std::uint32_t>();
+					column.nullable = c["nullable"].as<bool>();
+					column.default_value = c["default"].as<std::string>();
+					schema.addColumn(column);
+				}
+				if (schema.columns.empty()) {
+					return false;
+				}
+				this->schema = schema;
+				return true;
+			}
+		}
+		catch (YAML::Exception&) { }
+		return false;
+	}
+
+	/**
+	* Writes the columns of the target table into the catalog cache, or removes its entry if it turned out to be outdated. the entries of other tables are kept. errors are only reported as warnings, since the import doesn't depend on the cache.
+	*/
+	void storeCachedSchema(bool remove) {
+		YAML::Node cache;
+		try {
+			cache = YAML::LoadFile(this->catalog_cache_file);
+		}
+		catch (YAML::Exception&) { }
+		YAML::Emitter out;
+		out << YAML::BeginSeq;
+		try {
+			for (std::size_t i = 0; cache.IsSequence() && i < cache.size(); i++) {
+				YAML::Node entry = cache[i];
+				if (entry["database"].as<std::string>() != this->database || entry["table"].as<std::string>() != this->table || entry["columnstore_xml"].as<std::string>() != this->columnStoreXML) {
+					out << entry;
+				}
+			}
+		}
+		catch (YAML::Exception&) { }
+		if (!remove) {
+			out << YAML::BeginMap;
+			out << YAML::Key << "database" << YAML::Value << this->database;
+			out << YAML::Key << "table" << YAML::Value << this->table;
+			out << YAML::Key << "columnstore_xml" << YAML::Value << YAML::DoubleQuoted << this->columnStoreXML;
+			out << YAML::Key << "fetched" << YAML::Value << std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+			out << YAML::Key << "oid" << YAML::Value << this->schema.oid;
+			out << YAML::Key << "columns" << YAML::Value << YAML::BeginSeq;
+			for (auto const& c : this->schema.columns) {
+				out << YAML::Flow << YAML::BeginMap;
+				out << YAML::Key << "name" << YAML::Value << c.name;
+				out << YAML::Key << "type" << YAML::Value << (int) c.type;
+				out << YAML::Key << "position" << YAML::Value << c.position;
+				out << YAML::Key << "width" << YAML::Value << c.width;
+				out << YAML::Key << "precision" << YAML::Value << c.precision;
+				out << YAML::Key << "scale" << YAML::Value << c.scale;
+				out << YAML::Key << "nullable" << YAML::Value << c.nullable;
+				out << YAML::Key << "default" << YAML::Value << YAML::DoubleQuoted << c.default_value;
+				out << YAML::EndMap;
+			}
+			out << YAML::EndSeq;
+			out << YAML::EndMap;
+		}
+		out << YAML::EndSeq;
+
+		// concurrent imports replace the cache as a whole, so that it is never read partially written
+		std::chrono::milliseconds ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
+		std::string tmpFile = this->catalog_cache_file + "." + std::to_string(ms.count()) + ".tmp";
+		std::ofstream tmpStream(tmpFile, std::ios::trunc);
+		tmpStream << out.c_str() << std::endl;
+		tmpStream.close();
+#ifdef _WIN32
+		std::remove(this->catalog_cache_file.c_str());
+#endif
+		if (!tmpStream || std::rename(tmpFile.c_str(), this->catalog_cache_file.c_str()) != 0) {
+			std::remove(tmpFile.c_str());
+			this->err << "Warning: Can't write to catalog cache file: " << this->catalog_cache_file << std::endl;
+		}
+	}
+
+	/**
+	* Stops the progress output and writes the stats json file if requested
+	*/
+	void writeStats(bool committed) {
+		if (this->stats == nullptr) {
+			return;
+		}
+		this->stats->stopProgress();
+		if (this->stats_json_file == "") {
+			return;
+		}
+		double elapsed = this->stats->elapsedSeconds();
+		const RowSinkSummary& sum = this->importer->summary();
+		const std::vector<InputFileStats>& file_stats = this->importer->fileStats();
+		std::ofstream json(this->stats_json_file);
+		json << "{" << std::endl;
+		json << "  \"database\": " << ImportStats::jsonString(this->database) << "," << std::endl;
+		json << "  \"table\": " << ImportStats::jsonString(this->table) << "," << std::endl;
+		json << "  \"committed\": " << (committed ? "true" : "false") << "," << std::endl;
+		json << "  \"validate_only\": " << (this->validate_only ? "true" : "false") << "," << std::endl;
+		json << "  \"elapsed_time\": " << elapsed << "," << std::endl;
+		json << "  \"execution_time\": " << sum.execution_time << "," << std::endl;
+		json << "  \"rows_read\": " << this->stats->rowCount() << "," << std::endl;
+		json << "  \"bytes_read\": " << this->stats->byteCount() << "," << std::endl;
+		json << "  \"rows_per_second\": " << (elapsed > 0 ? this->stats->rowCount() / elapsed : 0) << "," << std::endl;
+		json << "  \"megabytes_per_second\": " << (elapsed > 0 ? this->stats->byteCount() / 1e6 / elapsed : 0) << "," << std::endl;
+		json << "  \"rows_inserted\": " << sum.rows_inserted << "," << std::endl;
+		json << "  \"truncation_count\": " << sum.truncation_count << "," << std::endl;
+		json << "  \"saturated_count\": " << sum.saturated_count << "," << std::endl;
+		json << "  \"invalid_count\": " << sum.invalid_count << "," << std::endl;
+		json << "  \"ignored_malformed_csv_count\": " << this->importer->ignoredMalformedCsvLines() << "," << std::endl;
+		json << "  \"filtered_count\": " << this->importer->filteredRows() << "," << std::endl;
+		json << "  \"sort_runs\": " << this->importer->sortRunCount() << "," << std::endl;
+		json << "  \"conversion_cache\": [";
+		if (this->mcsapi_sink != nullptr) {
+			const auto& caches = this->mcsapi_sink->conversionCaches();
+			bool first = true;
+			for (size_t col = 0; col < caches.size(); col++) {
+				if (caches[col].lookupCount() > 0) {
+					json << (first ? "" : ", ") << "{\"column\": " << ImportStats::jsonString(this->schema.column((std::int32_t) col).name) << ", \"lookups\": " << caches[col].lookupCount() << ", \"hits\": " << caches[col].hitCount() << ", \"disabled\": " << (caches[col].disabled() ? "true" : "false") << "}";
+					first = false;
+				}
+			}
+		}
+		json << "]," << std::endl;
+		json << "  \"error_count\": " << this->importer->errorCount() << "," << std::endl;
+		json << "  \"stage_times\": {";
+		for (int stage = 0; stage < ImportStats::STAGE_COUNT; stage++) {
+			json << (stage > 0 ? ", " : "") << "\"" << ImportStats::stageName((ImportStats::Stage) stage) << "\": " << this->stats->seconds((ImportStats::Stage) stage);
+		}
+		json << "}," << std::endl;
+		json << "  \"input_files\": [" << std::endl;
+		for (size_t i = 0; i < file_stats.size(); i++) {
+			const InputFileStats& f = file_stats[i];
+			json << "    {\"name\": " << ImportStats::jsonString(f.name) << ", \"rows_inserted\": " << f.rows_inserted << ", \"truncation_count\": " << f.truncated << ", \"saturated_count\": " << f.saturated << ", \"invalid_count\": " << f.invalid << ", \"ignored_malformed_csv_count\": " << f.ignored_malformed_csv_lines << ", \"filtered_count\": " << f.filtered << ", \"error_log\": " << ImportStats::jsonString(f.err_file) << "}" << (i + 1 < file_stats.size() ? "," : "") << std::endl;
+		}
+		json << "  ]" << std::endl;
+		json << "}" << std::endl;
+		if (!json) {
+			this->err << "Error: Can't write to stats file: " << this->stats_json_file << std::endl;
+		}
+	}
+
+	void generateMapping(int32_t csv_first_row_number_of_columns, bool default_non_mapped, std::string mapping_file) {
+		if (mapping_file == "") { // if no mapping file was provided use implicit mapping of columnstore_column to csv_column
+			generateImplicitMapping(csv_first_row_number_of_columns, default_non_mapped);
+		}
+		else { // if a mapping file was provided infer the mapping from the mapping file
+			generateExplicitMapping(csv_first_row_number_of_columns, default_non_mapped, mapping_file);
+		}
+	}
+
+	/*
+	* returns the csv column of the given json key path, a path that is used by several mappings is only read once
+	*/
+	int32_t getJsonColumn(const std::string& path) {
+		for (size_t i = 0; i < this->json_paths.size(); i++) {
+			if (this->json_paths[i] == path) {
+				return (int32_t) i;
+			}
+		}
+		this->json_paths.push_back(path);
+		return (int32_t) this->json_paths.size() - 1;
+	}
 
 	/**
 	* Generates an implicit 1:1 mapping of csv columns to cs columns
 	*/
 	void generateImplicitMapping(int32_t csv_first_row_number_of_columns, bool default_non_mapped) {
+		// json keys are mapped to the cs columns of the same name, missing keys are NULL
+		if (this->ndjson) {
+			for (int32_t x = 0; x < this->cs_table_columns; x++) {
+				this->mapping[x] = getJsonColumn(this->schema.column(x).name);
+			}
+			return;
+		}
+
 		// check the column sizes of csv input and columnstore target for compatibility
 		if (csv_first_row_number_of_columns < this->cs_table_columns && !default_non_mapped) {
-			std::cerr << "Error: Column size of input file is less than the column size of the target table" << std::endl;
+			this->err << "Error: Column size of input file is less than the column size of the target table" << std::endl;
 			clean();
-			std::exit(2);
+			throw SetupError();
 		}
 		else if (csv_first_row_number_of_columns < this->cs_table_columns && default_non_mapped){
-			std::cout << "Warning: Column size of input file is less than the column size of the target table." << std::endl;
-			std::cout << "Default values will be used for non mapped columnstore columns." << std::endl;
+			this->out << "Warning: Column size of input file is less than the column size of the target table." << std::endl;
+			this->out << "Default values will be used for non mapped columnstore columns." << std::endl;
 		}
 
 		if (csv_first_row_number_of_columns > this->cs_table_columns) {
-			std::cout << "Warning: Column size of input file is higher than the column size of the target table." << std::endl;
-			std::cout << "Remaining csv columns won't be injected." << std::endl;
+			this->out << "Warning: Column size of input file is higher than the column size of the target table." << std::endl;
+			this->out << "Remaining csv columns won't be injected." << std::endl;
 		}
 
 		// generate the mapping
@@ -295,7 +762,7 @@ private:
 			}
 			else { // map to the default value
 				this->mapping[x] = this->COLUMNSTORE_DEFAULT_VALUE;
-				this->customDefaultValue[x] = this->tab.getColumn(x).getDefaultValue();
+				this->customDefaultValue[x] = this->schema.column(x).default_value;
 			}
 		}
 	}
@@ -308,9 +775,9 @@ private:
 		// check if the mapping file exists
 		std::ifstream map(mapping_file);
 		if (!map) {
-			std::cerr << "Error: Can't open mapping file " << mapping_file << std::endl;
+			this->err << "Error: Can't open mapping file " << mapping_file << std::endl;
 			clean();
-			std::exit(2);
+			throw SetupError();
 		}
 		map.close();
 
@@ -320,9 +787,9 @@ private:
 			yaml = YAML::LoadFile(mapping_file);
 		}
 		catch (YAML::ParserException& e) {
-			std::cerr << "Error: Mapping file " << mapping_file << " couldn't be parsed." << std::endl << e.what() << std::endl;
+			this->err << "Error: Mapping file " << mapping_file << " couldn't be parsed." << std::endl << e.what() << std::endl;
 			clean();
-			std::exit(2);
+			throw SetupError();
 		}
 
 		// generate the mapping
@@ -330,61 +797,75 @@ private:
 			int32_t csv_column_counter = 0;
 			for (std::size_t i = 0; i < yaml.size(); i++) {
 				YAML::Node entry = yaml[i];
+				// the target is resolved once per expression
+				YAML::Node target = entry["target"];
+				int32_t targetId = target && target.IsDefined() ? getTargetId(target.as<std::string>()) : -1;
 				// handling of the column definition expressions
-				if (entry["column"]) {
+				YAML::Node column = entry["column"];
+				if (column) {
 					int32_t csv_column = -1;
-					if (entry["column"].IsNull()) { // no explicit column number was given, use the implicit from csv_column_counter
+					if (this->ndjson && !column.IsSequence()) { // the column is a json key path, that defaults to the name of the target
+						if (!column.IsNull()) {
+							csv_column = getJsonColumn(column.as<std::string>());
+						}
+						else if (targetId >= 0) {
+							csv_column = getJsonColumn(this->schema.column(targetId).name);
+						}
+					}
+					else if (column.IsNull()) { // no explicit column number was given, use the implicit from csv_column_counter
 						csv_column = csv_column_counter;
 						csv_column_counter++;
 					}
-					else if (entry["column"].IsSequence()) { //ignore scalar
+					else if (column.IsSequence()) { //ignore scalar
 						csv_column_counter++;
 					}
-					else if (entry["column"].IsDefined()) { // an explicit column number was given
-						csv_column = entry["column"].as<std::int32_t>();
+					else if (column.IsDefined()) { // an explicit column number or header name was given
+						csv_column = getSourceColumn(column.as<std::string>());
 					}
 					// handle the mapping in non-ignore case
 					if (csv_column >= 0) {
 						// check if the specified csv column is valid
 						if (csv_column >= csv_first_row_number_of_columns) {
-							std::cerr << "Warning: Specified source column " << csv_column << " is out of bounds.  This mapping will be ignored." << std::endl;
+							this->err << "Warning: Specified source column " << csv_column << " is out of bounds.  This mapping will be ignored." << std::endl;
 						}
 						// check if the specified target is valid
-						else if(!entry["target"]){
-							std::cerr << "Warning: No target column specified for source column " << csv_column << ". This mapping will be ignored." << std::endl;
+						else if(!target){
+							this->err << "Warning: No target column specified for source column " << csv_column << ". This mapping will be ignored." << std::endl;
 						} 
-						else if (getTargetId(entry["target"].as<std::string>()) < 0) {
-							std::cerr << "Warning: Specified target column " << entry["target"] << " could not be found. This mapping will be ignored." << std::endl;
+						else if (targetId < 0) {
+							this->err << "Warning: Specified target column " << target << " could not be found. This mapping will be ignored." << std::endl;
 						} // if all tests pass, do the mapping
 						else {
-							int32_t targetId = getTargetId(entry["target"].as<std::string>());
 							if (this->mapping.find(targetId) != this->mapping.end()) {
-								std::cerr << "Warning: Already existing mapping for source column " << mapping[targetId] << " mapped to ColumnStore column " << targetId << " is overwritten by new mapping." << std::endl;
+								this->err << "Warning: Already existing mapping for source column " << mapping[targetId] << " mapped to ColumnStore column " << targetId << " is overwritten by new mapping." << std::endl;
 							}
 							this->mapping[targetId] = csv_column;
 							handleOptionalColumnParameter(csv_column, targetId, entry);
 						}
 					}
 				}
+				// handling of the row filter expressions
+				else if (entry["filter"]) {
+					addRowFilter(entry, csv_first_row_number_of_columns);
+				}
 				// handling of the target definition expressions
-				else if (entry["target"] && entry["target"].IsDefined()) { //target default value configuration
+				else if (target && target.IsDefined()) { //target default value configuration
 					//check if the specified target is valid
-					if (getTargetId(entry["target"].as<std::string>()) < 0) {
-						std::cerr << "Warning: Specified target column " << entry["target"] << " could not be found. This target default value definition will be ignored." << std::endl;
+					if (targetId < 0) {
+						this->err << "Warning: Specified target column " << target << " could not be found. This target default value definition will be ignored." << std::endl;
 					}
 					// check if there is a default value defined
 					else if (!(entry["value"] && entry["value"].IsDefined())) {
-						std::cerr << "Warning: No default value specified for target column " << entry["target"] << ". This target default value definition will be ignored." << std::endl;
+						this->err << "Warning: No default value specified for target column " << target << ". This target default value definition will be ignored." << std::endl;
 					}
 					// if all tests pass, do the parsing
 					else {
-						std::int32_t targetId = getTargetId(entry["target"].as<std::string>());
 						if (this->mapping.find(targetId) != this->mapping.end()) {
-							std::cerr << "Warning: Already existing mapping for source column " << mapping[targetId] << " mapped to ColumnStore column " << targetId << " is overwritten by new default value." << std::endl;
+							this->err << "Warning: Already existing mapping for source column " << mapping[targetId] << " mapped to ColumnStore column " << targetId << " is overwritten by new default value." << std::endl;
 						}
 						if (entry["value"].as<std::string>() == "default") {
 							this->mapping[targetId] = COLUMNSTORE_DEFAULT_VALUE;
-							this->customDefaultValue[targetId] = this->tab.getColumn(targetId).getDefaultValue();
+							this->customDefaultValue[targetId] = this->schema.column(targetId).default_value;
 						}
 						else {
 							this->mapping[targetId] = CUSTOM_DEFAULT_VALUE;
@@ -393,14 +874,14 @@ private:
 					}
 				}
 				else {
-					std::cerr << "Warning: Defined expression " << entry << " is not supported and will be ignored." << std::endl;
+					this->err << "Warning: Defined expression " << entry << " is not supported and will be ignored." << std::endl;
 				}
 			}
 		}
 		catch (std::exception& e) {
-			std::cerr << "Error: Explicit mapping couldn't be generated. " << e.what() << std::endl;
+			this->err << "Error: Explicit mapping couldn't be generated. " << e.what() << std::endl;
 			clean();
- 			std::exit(2);
+			throw SetupError();
 		}
 
 		// check if the mapping is valid and apply missing defaults if default_non_map was chosen
@@ -408,18 +889,58 @@ private:
 			if (this->mapping.find(col) == this->mapping.end()) {
 				if (default_non_mapped) {
 					this->mapping[col] = COLUMNSTORE_DEFAULT_VALUE;
-					this->customDefaultValue[col] = this->tab.getColumn(col).getDefaultValue();
-					std::cout << "Notice: Using default value for ColumnStore column " << col << ": " << this->tab.getColumn(col).getColumnName() << std::endl;
+					this->customDefaultValue[col] = this->schema.column(col).default_value;
+					this->out << "Notice: Using default value for ColumnStore column " << col << ": " << this->schema.column(col).name << std::endl;
 				}
 				else {
-					std::cerr << "Error: No mapping found for ColumnStore column " << col << ": " << this->tab.getColumn(col).getColumnName() << std::endl;
+					this->err << "Error: No mapping found for ColumnStore column " << col << ": " << this->schema.column(col).name << std::endl;
 					clean();
-					std::exit(2);
+					throw SetupError();
 				}
 			}
 		}
 	}
 
+	/**
+	* Adds the predicates of a filter expression of the mapping file to the row filter. throws std::exception if the expression is invalid.
+	*/
+	void addRowFilter(YAML::Node entry, int32_t csv_first_row_number_of_columns) {
+		int32_t csv_column = this->ndjson ? getJsonColumn(entry["filter"].as<std::string>()) : getSourceColumn(entry["filter"].as<std::string>());
+		if (csv_column < 0 || csv_column >= csv_first_row_number_of_columns) {
+			throw std::invalid_argument("Filtered source column " + entry["filter"].as<std::string>() + " is out of bounds.");
+		}
+		bool predicate = false;
+		if (entry["is_null"]) {
+			this->rowFilter.addNullCheck(csv_column, entry["is_null"].as<bool>(), this->nullOption == 1);
+			predicate = true;
+		}
+		if (entry["equals"]) {
+			this->rowFilter.addValues(csv_column, std::vector<std::string>(1, entry["equals"].as<std::string>()));
+			predicate = true;
+		}
+		if (entry["in"]) {
+			this->rowFilter.addValues(csv_column, entry["in"].as<std::vector<std::string>>());
+			predicate = true;
+		}
+		if (entry["min"] || entry["max"]) {
+			std::string min = entry["min"] ? entry["min"].as<std::string>() : "";
+			std::string max = entry["max"] ? entry["max"].as<std::string>() : "";
+			this->rowFilter.addRange(csv_column, entry["min"] ? &min : nullptr, entry["max"] ? &max : nullptr);
+			predicate = true;
+		}
+		if (entry["from"] || entry["to"]) {
+			// the date format defaults to the one of the -df option
+			std::string format = entry["format"] ? entry["format"].as<std::string>() : (this->inputDateFormat != "" ? this->inputDateFormat : "%Y-%m-%d");
+			std::string from = entry["from"] ? entry["from"].as<std::string>() : "";
+			std::string to = entry["to"] ? entry["to"].as<std::string>() : "";
+			this->rowFilter.addDateRange(csv_column, format, entry["from"] ? &from : nullptr, entry["to"] ? &to : nullptr);
+			predicate = true;
+		}
+		if (!predicate) {
+			throw std::invalid_argument("No condition specified for filtered source column " + entry["filter"].as<std::string>() + ".");
+		}
+	}
+
 	void handleOptionalColumnParameter(int32_t source, int32_t target, YAML::Node column) {
 		// if there is already an old custom input date format entry delete it
 		if (this->customInputDateFormat.find(target) != this->customInputDateFormat.end()) {
@@ -427,7 +948,7 @@ private:
 		}
 
 		// set new custom input date format if applicable
-		if (column["format"] && (this->tab.getColumn(target).getType() == mcsapi::DATA_TYPE_DATE || this->tab.getColumn(target).getType() == mcsapi::DATA_TYPE_DATETIME)) {
+		if (column["format"] && (this->schema.column(target).type == mcsapi::DATA_TYPE_DATE || this->schema.column(target).type == mcsapi::DATA_TYPE_DATETIME)) {
 			//remove annotation marks from received custom date format
 			std::string df = column["format"].as<std::string>();
 			if (df[0] == '"' && df[df.size() - 1] == '"') {
@@ -440,214 +961,1006 @@ private:
 	/*
 	* returns the target id of given string's columnstore representation if it can be found. otherwise -1.
 	*/
-	int32_t getTargetId(std::string target) {
-		try {
-			int32_t targetId = std::stoi(target);
-			this->tab.getColumn(targetId);
+	int32_t getTargetId(const std::string& target) {
+		int32_t targetId = parseColumnNumber(target);
+		if (targetId >= 0 && targetId < this->schema.columnCount()) {
 			return targetId;
 		}
-		catch (std::exception&) { }
+		return this->schema.findColumn(target);
+	}
 
-		try {
-			int32_t targetId = this->tab.getColumn(target).getPosition();
-			return targetId;
+	/*
+	* returns the csv column of a source column given by its number or by its name in the header line, or -1 for a negative column number, whose mapping is ignored. throws std::invalid_argument if it is neither.
+	*/
+	int32_t getSourceColumn(const std::string& column) {
+		int32_t csv_column = parseColumnNumber(column);
+		if (csv_column >= 0) {
+			return csv_column;
 		}
-		catch (std::exception&) { }
-
-		return -1;
+		if (column.size() > 1 && column[0] == '-' && parseColumnNumber(column.substr(1)) >= 0) {
+			return -1;
+		}
+		auto it = this->csv_header_columns.find(column);
+		if (it != this->csv_header_columns.end()) {
+			return it->second;
+		}
+		if (this->csv_header_columns.empty()) {
+			throw std::invalid_argument("Source column " + column + " isn't a column number, source columns can only be referred to by name with -header.");
+		}
+		throw std::invalid_argument("Source column " + column + " can't be found in the header line.");
 	}
 
 	/*
-	* splits the csv file stream into a vector of parsed csv fields. returns true if the file stream is still readable, otherwise false.
+	* returns the column number the given string consists of, or -1 if it isn't a column number
 	*/
-	bool getNextCsvFields(std::ifstream& stream, std::vector<std::string>& parsed_csv_fields)
-	{
-		if (stream.eof()) {
-			return false;
+	static int32_t parseColumnNumber(const std::string& value) {
+		if (value.empty() || value.size() > 9) {
+			return -1;
 		}
-		parsed_csv_fields.clear();
-		std::string field;
-		bool withInEnclosed = false;
-		bool lastCharWasEscapeChar = false;
-		char ch;
-		while (stream.get(ch)) {
-			if (withInEnclosed) {
-				if (lastCharWasEscapeChar) {
-					// enclose by character found
-					if (ch == enclose_by_character) {
-						field.push_back(enclose_by_character);
-					}
-					// escape character found
-					else if (ch == escape_character) {
-						field.push_back(escape_character);
-					}
-					// in case enclose by and escape character are the same and no second enclose by char was found we have to end the enclosed by here
-					else if (enclose_by_character == escape_character) {
-						withInEnclosed = false;
-						stream.putback(ch);
-					}
-					// otherwise add escape character and current character to field
-					else {
-						field.push_back(escape_character);
-						field.push_back(ch);
-					}
-					lastCharWasEscapeChar = false;
+		int32_t number = 0;
+		for (char c : value) {
+			if (c < '0' || c > '9') {
+				return -1;
+			}
+			number = number * 10 + (c - '0');
+		}
+		return number;
+	}
+
+	/*
+	* decides once for every columnstore column how its value is derived from the csv rows
+	*/
+	void generateConversionPlan() {
+		for (int32_t col = 0; col < this->cs_table_columns; col++) {
+			ColumnConversion conversion;
+			conversion.csv_column = this->mapping[col];
+			conversion.null_literal = this->nullOption == 1;
+			mcsapi::columnstore_data_types_t type = this->schema.column(col).type;
+			if (conversion.csv_column == CUSTOM_DEFAULT_VALUE || conversion.csv_column == COLUMNSTORE_DEFAULT_VALUE) {
+				conversion.value = this->customDefaultValue[col];
+				if ((conversion.value == "" || (conversion.null_literal && conversion.value == "NULL")) && this->schema.column(col).nullable) {
+					conversion.handler = ColumnConversion::DEFAULT_NULL;
 				}
 				else {
-					// escape character found
-					if (ch == escape_character) {
-						lastCharWasEscapeChar = true;
-					}
-					// enclose by character found
-					else if (ch == enclose_by_character) {
-						withInEnclosed = false;
-					}
-					// otherwise just add the char to the field
-					else {
-						field.push_back(ch);
-					}
+					conversion.handler = ColumnConversion::DEFAULT_VALUE;
 				}
 			}
-			else {
-				// delimiter found
-				if (ch == delimiter) {
-					parsed_csv_fields.push_back(field);
-					field.clear();
-				}
-				// endline found
-				else if (ch == '\n') {
-					// remove Windows line ending
-					if (field.size() && field[field.size() - 1] == '\r') {
-						field = field.substr(0, field.size() - 1);
-					}
-					parsed_csv_fields.push_back(field);
-					break;
-				}
-				// enclose by character found
-				else if (ch == enclose_by_character) {
-					withInEnclosed = true;
+			else if ((this->customInputDateFormat.find(col) != this->customInputDateFormat.end() || this->inputDateFormat != "") && (type == mcsapi::DATA_TYPE_DATE || type == mcsapi::DATA_TYPE_DATETIME)) {
+				conversion.handler = ColumnConversion::CSV_DATETIME;
+				if (this->customInputDateFormat.find(col) != this->customInputDateFormat.end()) {
+					conversion.value = this->customInputDateFormat[col];
 				}
 				else {
-					field.push_back(ch);
+					conversion.value = this->inputDateFormat;
 				}
+				conversion.date_format_compiled = conversion.date_format.compile(conversion.value);
 			}
+			else {
+				conversion.setColumnType(type, this->schema.column(col).precision, this->schema.column(col).scale);
+			}
+			this->conversionPlan.addColumn(conversion);
 		}
-		// submit the last field if the file ended without newline
-		if (stream.eof() && (field.size() > 0  || parsed_csv_fields.size() > 0)) {
-			parsed_csv_fields.push_back(field);
-		}
-		// return false if file ends with an empty line
-		else if(stream.eof()) {
-			return false;
-		}
-
-		return true;
-	}
-
-	/**
-	* Concatenates a vector of strings to a single string
-	*/
-	std::string vectorToString(std::vector <std::string> parsed_csv_fields) {
-		std::string parsed_raw_csv_field_string;
-		for (auto const& s : parsed_csv_fields) {
-			parsed_raw_csv_field_string += s + ",";
-		}
-		if (parsed_raw_csv_field_string.size() > 0) {
-			parsed_raw_csv_field_string = parsed_raw_csv_field_string.substr(0, parsed_raw_csv_field_string.size() - 1);
-		}
-		return parsed_raw_csv_field_string;
 	}
 
 	void clean() {
-		if (this->errFileStream.is_open()) {
-			this->errFileStream.close();
+		delete this->importer;
+		this->importer = nullptr;
+		delete this->stats;
+		this->stats = nullptr;
+		delete this->sink;
+		this->sink = nullptr;
+		if (this->owns_driver) {
+			delete this->driver;
 		}
-		delete this->bulk;
-		delete this->driver;
+		this->driver = nullptr;
 	}
 };
 
-int main(int argc, char* argv[])
-{
-	// Check if the command line arguments are valid
-	if (argc < 4) {
-		std::cerr << "Usage: " << argv[0] << " database table input_file [-m mapping_file] [-c Columnstore.xml] [-d delimiter] [-df date_format] [-n null_option] [-default_non_mapped] [-E enclose_by_character] [-C escape_character] [-header] [-ignore_malformed_csv] [-err_log]" << std::endl;
-		return 1;
+/**
+* Expands the wildcards of the given input file arguments, matches are sorted by name. arguments without matches are kept as they are.
+*/
+std::vector<std::string> expandInputFiles(const std::vector<std::string>& arguments) {
+	std::vector<std::string> input_files;
+	for (auto const& argument : arguments) {
+		if (argument.find_first_of("*?[") == std::string::npos) {
+			input_files.push_back(argument);
+			continue;
+		}
+		std::vector<std::string> matches;
+#ifdef _WIN32
+		std::string directory;
+		size_t separator = argument.find_last_of("\\/:");
+		if (separator != std::string::npos) {
+			directory = argument.substr(0, separator + 1);
+		}
+		struct _finddata_t file_info;
+		intptr_t handle = _findfirst(argument.c_str(), &file_info);
+		if (handle != -1) {
+			do {
+				if (!(file_info.attrib & _A_SUBDIR)) {
+					matches.push_back(directory + file_info.name);
+				}
+			} while (_findnext(handle, &file_info) == 0);
+			_findclose(handle);
+		}
+		std::sort(matches.begin(), matches.end());
+#else
+		glob_t glob_result;
+		if (glob(argument.c_str(), 0, nullptr, &glob_result) == 0) {
+			for (size_t i = 0; i < glob_result.gl_pathc; i++) {
+				matches.push_back(glob_result.gl_pathv[i]);
+			}
+		}
+		globfree(&glob_result);
+#endif
+		if (matches.empty()) {
+			input_files.push_back(argument);
+		}
+		input_files.insert(input_files.end(), matches.begin(), matches.end());
 	}
+	return input_files;
+}
 
-	// Parse the optional command line arguments
-	InputParser input(argc, argv);
-	std::string mappingFile;
-	std::string columnStoreXML;
-	std::string inputDateFormat;
-	std::int32_t nullOption = 0;
-	bool default_non_mapped = false;
-	bool ignore_malformed_csv = false;
-	bool header = false;
-	bool error_log = false;
-	char delimiter = ',';
-	char escape_character = '"';
-	char enclose_by_character = '"';
+/**
+* Parses the options of an import from its command line arguments. returns 0, or the exit code after the reason was written to err.
+*/
+int parseImportOptions(const InputParser& input, ImportOptions& options, std::ostream& err) {
 	if (input.cmdOptionExists("-m")) {
-		mappingFile = input.getCmdOption("-m");
+		options.mapping_file = input.getCmdOption("-m");
 	}
 	if (input.cmdOptionExists("-c")) {
-		columnStoreXML = input.getCmdOption("-c");
+		options.columnStoreXML = input.getCmdOption("-c");
 	}
 	if (input.cmdOptionExists("-d")) {
 		std::string delimiterString = input.getCmdOption("-d");
 		if (delimiterString.length() != 1) {
-			std::cerr << "Error: Delimiter needs to be one character. Current length: " << delimiterString.length() << std::endl;
+			err << "Error: Delimiter needs to be one character. Current length: " << delimiterString.length() << std::endl;
 			return 2;
 		}
-		delimiter = delimiterString[0];
+		options.delimiter = delimiterString[0];
 	}
 	if (input.cmdOptionExists("-n")) {
 		try {
-			nullOption = std::stoi(input.getCmdOption("-n"));
-			if (nullOption < 0 || nullOption > 1) {
-				std::cerr << "Error: The given null option parameter is out of range. Currently only values 0 [NULL string as data] and 1 [NULL string as NULL value] are supported." << std::endl;
+			options.nullOption = std::stoi(input.getCmdOption("-n"));
+			if (options.nullOption < 0 || options.nullOption > 1) {
+				err << "Error: The given null option parameter is out of range. Currently only values 0 [NULL string as data] and 1 [NULL string as NULL value] are supported." << std::endl;
 				return 2;
 			}
 		}
 		catch (std::exception&) {
-			std::cerr << "Error: Couldn't parse null option parameter to an integer" << std::endl;
+			err << "Error: Couldn't parse null option parameter to an integer" << std::endl;
 			return 2;
 		}
 	}
 	if (input.cmdOptionExists("-C")) {
 		std::string escapeString = input.getCmdOption("-C");
 		if (escapeString.length() != 1) {
-			std::cerr << "Error: Escape character needs to be one character. Current length: " << escapeString.length() << std::endl;
+			err << "Error: Escape character needs to be one character. Current length: " << escapeString.length() << std::endl;
 			return 2;
 		}
-		escape_character = escapeString[0];
+		options.escape_character = escapeString[0];
 	}
 	if (input.cmdOptionExists("-E")) {
 		std::string encloseByString = input.getCmdOption("-E");
 		if (encloseByString.length() != 1) {
-			std::cerr << "Error: Enclose by character needs to be one character. Current length: " << encloseByString.length() << std::endl;
+			err << "Error: Enclose by character needs to be one character. Current length: " << encloseByString.length() << std::endl;
 			return 2;
 		}
-		enclose_by_character = encloseByString[0];
+		options.enclose_by_character = encloseByString[0];
 	}
 	if (input.cmdOptionExists("-df")) {
-		inputDateFormat = input.getCmdOption("-df");
+		options.inputDateFormat = input.getCmdOption("-df");
 	}
 	if (input.cmdOptionExists("-default_non_mapped")) {
-		default_non_mapped = true;
+		options.default_non_mapped = true;
 	}
 	if (input.cmdOptionExists("-header")) {
-		header = true;
+		options.header = true;
 	}
 	if (input.cmdOptionExists("-ignore_malformed_csv")) {
-		ignore_malformed_csv = true;
+		options.ignore_malformed_csv = true;
 	}
 	if (input.cmdOptionExists("-err_log")) {
-		error_log = true;
+		options.error_log = true;
+	}
+	if (input.cmdOptionExists("-j")) {
+		try {
+			std::int32_t j = std::stoi(input.getCmdOption("-j"));
+			if (j < 1) {
+				err << "Error: The given number of threads needs to be at least 1." << std::endl;
+				return 2;
+			}
+			options.threads = (unsigned) j;
+		}
+		catch (std::exception&) {
+			err << "Error: Couldn't parse the number of threads parameter to an integer" << std::endl;
+			return 2;
+		}
+	}
+	if (input.cmdOptionExists("-commit_rows")) {
+		try {
+			std::int64_t rows = std::stoll(input.getCmdOption("-commit_rows"));
+			if (rows < 1) {
+				err << "Error: The given number of rows between commits needs to be at least 1." << std::endl;
+				return 2;
+			}
+			options.commit_rows = (std::uint64_t) rows;
+		}
+		catch (std::exception&) {
+			err << "Error: Couldn't parse the number of rows between commits parameter to an integer" << std::endl;
+			return 2;
+		}
+	}
+	if (input.cmdOptionExists("-commit_bytes")) {
+		try {
+			std::int64_t bytes = std::stoll(input.getCmdOption("-commit_bytes"));
+			if (bytes < 1) {
+				err << "Error: The given number of bytes between commits needs to be at least 1." << std::endl;
+				return 2;
+			}
+			options.commit_bytes = (std::uint64_t) bytes;
+		}
+		catch (std::exception&) {
+			err << "Error: Couldn't parse the number of bytes between commits parameter to an integer" << std::endl;
+			return 2;
+		}
+	}
+	if (input.cmdOptionExists("-follow")) {
+		options.follow = true;
+	}
+	if (input.cmdOptionExists("-commit_ms")) {
+		try {
+			std::int64_t ms = std::stoll(input.getCmdOption("-commit_ms"));
+			if (ms < 1) {
+				err << "Error: The given commit latency needs to be at least 1 millisecond." << std::endl;
+				return 2;
+			}
+			options.commit_ms = (std::uint64_t) ms;
+		}
+		catch (std::exception&) {
+			err << "Error: Couldn't parse the commit latency parameter to an integer" << std::endl;
+			return 2;
+		}
+	}
+	if (input.cmdOptionExists("-follow_idle")) {
+		try {
+			options.follow_idle = std::stod(input.getCmdOption("-follow_idle"));
+			if (!(options.follow_idle > 0)) {
+				err << "Error: The given idle time needs to be greater than 0 seconds." << std::endl;
+				return 2;
+			}
+		}
+		catch (std::exception&) {
+			err << "Error: Couldn't parse the idle time parameter to a number" << std::endl;
+			return 2;
+		}
+	}
+	if (!options.follow && (input.cmdOptionExists("-commit_ms") || input.cmdOptionExists("-follow_idle"))) {
+		err << "Error: -commit_ms and -follow_idle only apply to -follow" << std::endl;
+		return 2;
+	}
+	if (input.cmdOptionExists("-checkpoint")) {
+		options.checkpoint_file = input.getCmdOption("-checkpoint");
+	}
+	if (input.cmdOptionExists("-resume")) {
+		options.resume = true;
+	}
+	if (input.cmdOptionExists("-progress")) {
+		try {
+			options.progress_interval = std::stod(input.getCmdOption("-progress"));
+			if (!(options.progress_interval > 0)) {
+				err << "Error: The given progress interval needs to be greater than 0 seconds." << std::endl;
+				return 2;
+			}
+		}
+		catch (std::exception&) {
+			err << "Error: Couldn't parse the progress interval parameter to a number" << std::endl;
+			return 2;
+		}
+	}
+	if (input.cmdOptionExists("-stats_json")) {
+		options.stats_json_file = input.getCmdOption("-stats_json");
+	}
+	if (input.cmdOptionExists("-catalog_cache")) {
+		options.catalog_cache_file = input.getCmdOption("-catalog_cache");
+	}
+	if (input.cmdOptionExists("-catalog_cache_ttl")) {
+		try {
+			options.catalog_cache_ttl = std::stod(input.getCmdOption("-catalog_cache_ttl"));
+			if (!(options.catalog_cache_ttl >= 0)) {
+				err << "Error: The given catalog cache time to live can't be negative." << std::endl;
+				return 2;
+			}
+		}
+		catch (std::exception&) {
+			err << "Error: Couldn't parse the catalog cache time to live parameter to a number" << std::endl;
+			return 2;
+		}
+	}
+	if (input.cmdOptionExists("-max_errors")) {
+		try {
+			std::int64_t errors = std::stoll(input.getCmdOption("-max_errors"));
+			if (errors < 0) {
+				err << "Error: The given maximum number of errors can't be negative." << std::endl;
+				return 2;
+			}
+			options.max_errors = (std::uint64_t) errors;
+		}
+		catch (std::exception&) {
+			err << "Error: Couldn't parse the maximum number of errors parameter to an integer" << std::endl;
+			return 2;
+		}
+	}
+	if (input.cmdOptionExists("-max_error_ratio")) {
+		try {
+			options.max_error_ratio = std::stod(input.getCmdOption("-max_error_ratio"));
+			if (!(options.max_error_ratio >= 0)) {
+				err << "Error: The given maximum error ratio can't be negative." << std::endl;
+				return 2;
+			}
+		}
+		catch (std::exception&) {
+			err << "Error: Couldn't parse the maximum error ratio parameter to a number" << std::endl;
+			return 2;
+		}
+	}
+	if (input.cmdOptionExists("-validate_only")) {
+		options.validate_only = true;
+		if (options.commit_rows > 0 || options.commit_bytes > 0 || options.resume) {
+			err << "Error: -validate_only doesn't write any rows and can't be combined with -commit_rows, -commit_bytes or -resume" << std::endl;
+			return 2;
+		}
+	}
+	if (input.cmdOptionExists("-ndjson")) {
+		options.ndjson = true;
+		if (options.header) {
+			err << "Error: JSON Lines input has no header, -ndjson can't be combined with -header" << std::endl;
+			return 2;
+		}
+	}
+	if (input.cmdOptionExists("-sort_by")) {
+		std::string columns = input.getCmdOption("-sort_by");
+		for (size_t start = 0; start <= columns.size();) {
+			size_t end = std::min(columns.find(',', start), columns.size());
+			options.sort_by.push_back(columns.substr(start, end - start));
+			if (options.sort_by.back() == "") {
+				err << "Error: -sort_by needs a comma separated list of column names" << std::endl;
+				return 2;
+			}
+			start = end + 1;
+		}
+		if (options.commit_rows > 0 || options.commit_bytes > 0 || options.checkpoint_file != "" || options.resume) {
+			err << "Error: -sort_by writes the rows after all of them were read and can't be combined with -commit_rows, -commit_bytes, -checkpoint or -resume" << std::endl;
+			return 2;
+		}
+	}
+	if (input.cmdOptionExists("-sort_memory")) {
+		try {
+			std::int64_t megabytes = std::stoll(input.getCmdOption("-sort_memory"));
+			if (megabytes < 1) {
+				err << "Error: The given sort memory needs to be at least 1 megabyte." << std::endl;
+				return 2;
+			}
+			options.sort_memory = (std::uint64_t) megabytes * 1024 * 1024;
+		}
+		catch (std::exception&) {
+			err << "Error: Couldn't parse the sort memory parameter to an integer" << std::endl;
+			return 2;
+		}
+	}
+	if (input.cmdOptionExists("-sort_tmpdir")) {
+		options.sort_tmpdir = input.getCmdOption("-sort_tmpdir");
+	}
+	if (input.cmdOptionExists("-conversion_cache")) {
+		try {
+			std::int64_t entries = std::stoll(input.getCmdOption("-conversion_cache"));
+			if (entries < 1) {
+				err << "Error: The given conversion cache size needs to be at least 1 value." << std::endl;
+				return 2;
+			}
+			options.conversion_cache = (std::uint64_t) entries;
+		}
+		catch (std::exception&) {
+			err << "Error: Couldn't parse the conversion cache parameter to an integer" << std::endl;
+			return 2;
+		}
+	}
+	if (options.follow && (options.threads > 0 || options.validate_only || !options.sort_by.empty())) {
+		err << "Error: -follow reads and commits the rows as they are appended and can't be combined with -j, -validate_only or -sort_by" << std::endl;
+		return 2;
+	}
+	return 0;
+}
+
+/**
+* Connects to ColumnStore with the given Columnstore.xml, or the default one if empty, and reads the system catalog. returns nullptr after the reason was written to std::cerr.
+*/
+mcsapi::ColumnStoreDriver* connectDriver(const std::string& columnStoreXML, mcsapi::ColumnStoreSystemCatalog*& catalog) {
+	mcsapi::ColumnStoreDriver* driver = nullptr;
+	try {
+		if (columnStoreXML == "") {
+			driver = new mcsapi::ColumnStoreDriver();
+		}
+		else {
+			driver = new mcsapi::ColumnStoreDriver(columnStoreXML);
+		}
+		catalog = &driver->getSystemCatalog();
+	}
+	catch (mcsapi::ColumnStoreError &e) {
+		std::cerr << "Error during mcsapi initialization: " << e.what() << std::endl;
+		delete driver;
+		return nullptr;
+	}
+	return driver;
+}
+
+/**
+* An import of a manifest and its outcome
+*/
+struct ManifestJob {
+	ImportOptions options;
+	int32_t exit_code = 0;
+	RowSinkSummary summary;
+	double elapsed_time = 0;
+};
+
+/**
+* Reads the imports listed in the manifest file. returns 0, or the exit code after the reason was written to std::cerr.
+*/
+int readManifest(const std::string& manifest_file, std::vector<ManifestJob>& jobs) {
+	YAML::Node yaml;
+	try {
+		yaml = YAML::LoadFile(manifest_file);
+	}
+	catch (YAML::BadFile&) {
+		std::cerr << "Error: Can't open manifest file " << manifest_file << std::endl;
+		return 2;
+	}
+	catch (YAML::ParserException& e) {
+		std::cerr << "Error: Manifest file " << manifest_file << " couldn't be parsed." << std::endl << e.what() << std::endl;
+		return 2;
+	}
+	if (!yaml.IsSequence() || yaml.size() == 0) {
+		std::cerr << "Error: Manifest file " << manifest_file << " needs to be a list of imports" << std::endl;
+		return 2;
+	}
+	jobs.resize(yaml.size());
+	for (std::size_t i = 0; i < yaml.size(); i++) {
+		YAML::Node entry = yaml[i];
+		ImportOptions& options = jobs[i].options;
+		try {
+			if (!entry["database"] || !entry["table"] || !entry["input"]) {
+				std::cerr << "Error: Manifest entry " << i + 1 << " needs a database, a table and an input" << std::endl;
+				return 2;
+			}
+			options.database = entry["database"].as<std::string>();
+			options.table = entry["table"].as<std::string>();
+			// the options are given like on the command line, either as a list or in one string
+			std::vector<std::string> tokens;
+			if (entry["options"] && entry["options"].IsSequence()) {
+				tokens = entry["options"].as<std::vector<std::string>>();
+			}
+			else if (entry["options"] && !entry["options"].IsNull()) {
+				std::istringstream option_string(entry["options"].as<std::string>());
+				std::string token;
+				while (option_string >> token) {
+					tokens.push_back(token);
+				}
+			}
+			InputParser input(tokens);
+			std::ostringstream err;
+			if (parseImportOptions(input, options, err) != 0) {
+				std::cerr << "Error in manifest entry " << i + 1 << " for " << options.database << "." << options.table << ": " << err.str();
+				return 2;
+			}
+			if (input.cmdOptionExists("-c") || input.cmdOptionExists("-progress")) {
+				std::cerr << "Error: Manifest entry " << i + 1 << " can't set -c or -progress, the imports share the connection and their output" << std::endl;
+				return 2;
+			}
+			if (options.follow) {
+				std::cerr << "Error: Manifest entry " << i + 1 << " can't use -follow, the imports of a manifest end with their input" << std::endl;
+				return 2;
+			}
+			// a new bulk insert after a periodic commit would be created on the shared driver while other imports use it
+			if (options.commit_rows > 0 || options.commit_bytes > 0 || options.checkpoint_file != "" || options.resume) {
+				std::cerr << "Error: Manifest entry " << i + 1 << " can't set -commit_rows, -commit_bytes, -checkpoint or -resume, each import is committed as a whole" << std::endl;
+				return 2;
+			}
+			if (entry["mapping"]) {
+				options.mapping_file = entry["mapping"].as<std::string>();
+			}
+			std::vector<std::string> inputs;
+			if (entry["input"].IsSequence()) {
+				inputs = entry["input"].as<std::vector<std::string>>();
+			}
+			else {
+				inputs.push_back(entry["input"].as<std::string>());
+			}
+			options.input_files = expandInputFiles(inputs);
+			if (std::find(options.input_files.begin(), options.input_files.end(), "-") != options.input_files.end()) {
+				std::cerr << "Error: Manifest entry " << i + 1 << " can't import stdin" << std::endl;
+				return 2;
+			}
+			if (options.input_files.size() > 1 && options.threads == 0) {
+				options.threads = std::max(1u, std::thread::hardware_concurrency());
+			}
+		}
+		catch (YAML::Exception& e) {
+			std::cerr << "Error: Manifest entry " << i + 1 << " couldn't be parsed. " << e.what() << std::endl;
+			return 2;
+		}
+		// a table can only be written by one bulk insert at a time
+		for (std::size_t j = 0; j < i; j++) {
+			if (jobs[j].options.database == options.database && jobs[j].options.table == options.table) {
+				std::cerr << "Error: Manifest entries " << j + 1 << " and " << i + 1 << " both import into " << options.database << "." << options.table << ", the input files of a table need to be listed in one entry" << std::endl;
+				return 2;
+			}
+		}
+	}
+	return 0;
+}
+
+/**
+* Runs the imports of a manifest concurrently with one shared driver and catalog, and prints the summary of each table and of the whole job
+*/
+int runManifest(const InputParser& input) {
+	std::string manifest_file = input.getCmdOption("-manifest");
+	unsigned max_parallel = std::max(1u, std::thread::hardware_concurrency());
+	if (input.cmdOptionExists("-max_parallel")) {
+		try {
+			std::int32_t parallel = std::stoi(input.getCmdOption("-max_parallel"));
+			if (parallel < 1) {
+				std::cerr << "Error: The given number of parallel imports needs to be at least 1." << std::endl;
+				return 2;
+			}
+			max_parallel = (unsigned) parallel;
+		}
+		catch (std::exception&) {
+			std::cerr << "Error: Couldn't parse the number of parallel imports parameter to an integer" << std::endl;
+			return 2;
+		}
+	}
+	std::vector<ManifestJob> jobs;
+	int32_t rtn = readManifest(manifest_file, jobs);
+	if (rtn != 0) {
+		return rtn;
+	}
+
+	// connect and read the system catalog once for all imports
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	mcsapi::ColumnStoreSystemCatalog* catalog = nullptr;
+	mcsapi::ColumnStoreDriver* driver = connectDriver(input.getCmdOption("-c"), catalog);
+	if (driver == nullptr) {
+		return 2;
+	}
+
+	// each import writes its output into buffers that are printed as a whole once it finished
+	std::mutex mutex;
+	std::mutex setup_mutex;
+	size_t next_job = 0;
+	auto runJobs = [&]() {
+		for (;;) {
+			size_t i;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (next_job == jobs.size()) {
+					return;
+				}
+				i = next_job++;
+			}
+			ManifestJob& job = jobs[i];
+			std::ostringstream out;
+			std::ostringstream err;
+			std::chrono::steady_clock::time_point job_start = std::chrono::steady_clock::now();
+			try {
+				std::unique_ptr<MCSRemoteImport> mcsimport;
+				{
+					// the catalog is copied and the bulk insert is created by one import at a time
+					std::lock_guard<std::mutex> lock(setup_mutex);
+					mcsimport.reset(new MCSRemoteImport(job.options, out, err, driver, catalog));
+				}
+				job.exit_code = mcsimport->import();
+				job.summary = mcsimport->summary();
+			}
+			catch (SetupError&) {
+				job.exit_code = 2;
+			}
+			catch (std::exception& e) {
+				err << "Error: " << e.what() << std::endl;
+				job.exit_code = 2;
+			}
+			job.elapsed_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - job_start).count();
+			std::lock_guard<std::mutex> lock(mutex);
+			std::cout << "Import into " << job.options.database << "." << job.options.table << " (manifest entry " << i + 1 << "):" << std::endl << out.str() << std::flush;
+			std::cerr << err.str() << std::flush;
+		}
+	};
+	std::vector<std::thread> workers;
+	for (size_t w = 0; w < std::min<size_t>(max_parallel, jobs.size()); w++) {
+		workers.push_back(std::thread(runJobs));
+	}
+	for (auto& w : workers) {
+		w.join();
+	}
+	delete driver;
+
+	RowSinkSummary total;
+	size_t imported = 0;
+	std::cout << "Manifest summary:" << std::endl;
+	for (auto const& job : jobs) {
+		std::cout << "  " << job.options.database << "." << job.options.table << ": ";
+		if (job.exit_code == 0) {
+			std::cout << "imported";
+			imported++;
+		}
+		else {
+			std::cout << "failed with exit code " << job.exit_code;
+		}
+		std::cout << ", rows inserted: " << job.summary.rows_inserted << ", truncation count: " << job.summary.truncation_count << ", saturated count: " << job.summary.saturated_count << ", invalid count: " << job.summary.invalid_count << ", time: " << job.elapsed_time << "s" << std::endl;
+		total.add(job.summary);
+		rtn = std::max(rtn, job.exit_code);
+	}
+	std::cout << "Tables imported: " << imported << " of " << jobs.size() << std::endl;
+	std::cout << "Rows inserted: " << total.rows_inserted << std::endl;
+	std::cout << "Truncation count: " << total.truncation_count << std::endl;
+	std::cout << "Saturated count: " << total.saturated_count << std::endl;
+	std::cout << "Invalid count: " << total.invalid_count << std::endl;
+	std::cout << "Execution time: " << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << "s" << std::endl;
+	return rtn;
+}
+
+/**
+* The counters of a spool import, written to the stats json file after every batch
+*/
+struct SpoolStats {
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::uint64_t batches = 0;
+	std::uint64_t files_imported = 0;
+	std::uint64_t files_failed = 0;
+	std::uint64_t files_over_latency_target = 0;
+	RowSinkSummary summary;
+	double last_latency = 0;
+	double max_latency = 0;
+	double total_latency = 0;
+};
+
+/**
+* Writes the counters of a spool import to the stats json file, through a temporary file so that a scraper never reads a partial file
+*/
+void writeSpoolStats(const std::string& stats_json_file, const SpoolDirectory& spool, const ImportOptions& options, double latency_target, const SpoolStats& stats) {
+	double uptime = std::chrono::duration<double>(std::chrono::steady_clock::now() - stats.start).count();
+	std::uint64_t files = stats.files_imported + stats.files_failed;
+	std::string tmpFile = stats_json_file + ".tmp";
+	std::ofstream json(tmpFile, std::ios::trunc);
+	json << "{" << std::endl;
+	json << "  \"spool_directory\": " << ImportStats::jsonString(spool.path()) << "," << std::endl;
+	json << "  \"database\": " << ImportStats::jsonString(options.database) << "," << std::endl;
+	json << "  \"table\": " << ImportStats::jsonString(options.table) << "," << std::endl;
+	json << "  \"uptime\": " << uptime << "," << std::endl;
+	json << "  \"batches\": " << stats.batches << "," << std::endl;
+	json << "  \"files_imported\": " << stats.files_imported << "," << std::endl;
+	json << "  \"files_failed\": " << stats.files_failed << "," << std::endl;
+	json << "  \"rows_inserted\": " << stats.summary.rows_inserted << "," << std::endl;
+	json << "  \"truncation_count\": " << stats.summary.truncation_count << "," << std::endl;
+	json << "  \"saturated_count\": " << stats.summary.saturated_count << "," << std::endl;
+	json << "  \"invalid_count\": " << stats.summary.invalid_count << "," << std::endl;
+	json << "  \"files_per_second\": " << (uptime > 0 ? files / uptime : 0) << "," << std::endl;
+	json << "  \"rows_per_second\": " << (uptime > 0 ? stats.summary.rows_inserted / uptime : 0) << "," << std::endl;
+	json << "  \"latency_target\": " << latency_target << "," << std::endl;
+	json << "  \"files_over_latency_target\": " << stats.files_over_latency_target << "," << std::endl;
+	json << "  \"last_latency\": " << stats.last_latency << "," << std::endl;
+	json << "  \"max_latency\": " << stats.max_latency << "," << std::endl;
+	json << "  \"average_latency\": " << (files > 0 ? stats.total_latency / files : 0) << std::endl;
+	json << "}" << std::endl;
+	json.close();
+	if (!json) {
+		std::cerr << "Error: Can't write to stats file: " << tmpFile << std::endl;
+		return;
+	}
+#ifdef _WIN32
+	std::remove(stats_json_file.c_str());
+#endif
+	if (std::rename(tmpFile.c_str(), stats_json_file.c_str()) != 0) {
+		std::cerr << "Error: Can't write to stats file: " << stats_json_file << std::endl;
+	}
+}
+
+/**
+* Imports the files dropped into a spool directory until SIGINT or SIGTERM is received, with one connection and system catalog for all imports. Files that are ready together are imported in batches of up to -spool_batch files and one commit, which wait up to -spool_linger seconds for more files. Imported files are moved into the done subdirectory, files that fail are imported one by one and moved into the failed subdirectory if they fail again.
+*/
+int runSpool(const InputParser& input, int argc, char* argv[]) {
+	ImportOptions options;
+	int32_t rtn = parseImportOptions(input, options, std::cerr);
+	if (rtn != 0) {
+		return rtn;
+	}
+	if (argc < 3 || input.getPositionalArguments(0).size() != 2) {
+		std::cerr << "Error: -spool needs a database and a table, and takes its input files from the spool directory" << std::endl;
+		return 2;
+	}
+	options.database = argv[1];
+	options.table = argv[2];
+	if (options.resume || options.checkpoint_file != "" || options.commit_rows > 0 || options.commit_bytes > 0 || options.error_log || options.progress_interval > 0 || options.follow) {
+		std::cerr << "Error: -spool commits each batch of files as a whole and can't be combined with -commit_rows, -commit_bytes, -checkpoint, -resume, -err_log, -progress or -follow" << std::endl;
+		return 2;
+	}
+	size_t batch_files = 1;
+	double linger = 0;
+	double latency_target = 0;
+	try {
+		if (input.cmdOptionExists("-spool_batch")) {
+			std::int32_t files = std::stoi(input.getCmdOption("-spool_batch"));
+			if (files < 1) {
+				std::cerr << "Error: The given number of files per batch needs to be at least 1." << std::endl;
+				return 2;
+			}
+			batch_files = (size_t) files;
+		}
+		if (input.cmdOptionExists("-spool_linger")) {
+			linger = std::stod(input.getCmdOption("-spool_linger"));
+			if (!(linger >= 0)) {
+				std::cerr << "Error: The given linger time can't be negative." << std::endl;
+				return 2;
+			}
+		}
+		if (input.cmdOptionExists("-spool_latency")) {
+			latency_target = std::stod(input.getCmdOption("-spool_latency"));
+			if (!(latency_target > 0)) {
+				std::cerr << "Error: The given latency target needs to be greater than 0 seconds." << std::endl;
+				return 2;
+			}
+		}
+	}
+	catch (std::exception&) {
+		std::cerr << "Error: Couldn't parse the -spool_batch, -spool_linger or -spool_latency parameter to a number" << std::endl;
+		return 2;
+	}
+	// the stats file holds the counters of the spool import instead of those of each batch
+	std::string stats_json_file = options.stats_json_file;
+	options.stats_json_file = "";
+
+	SpoolDirectory spool(input.getCmdOption("-spool"));
+	try {
+		spool.open();
+	}
+	catch (std::exception& e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return 2;
+	}
+	mcsapi::ColumnStoreSystemCatalog* catalog = nullptr;
+	mcsapi::ColumnStoreDriver* driver = connectDriver(options.columnStoreXML, catalog);
+	if (driver == nullptr) {
+		return 2;
+	}
+	std::signal(SIGINT, requestStop);
+	std::signal(SIGTERM, requestStop);
+	std::cout << "Watching spool directory " << spool.path() << " for imports into " << options.database << "." << options.table << std::endl;
+
+	typedef std::chrono::steady_clock Clock;
+	struct SpoolFile {
+		std::string path;
+		Clock::time_point ready;
+	};
+	SpoolStats stats;
+	std::deque<SpoolFile> pending;
+
+	// connects again to read the system catalog anew, after a table might have been altered. keeps the old connection if it fails.
+	auto refreshCatalog = [&]() {
+		mcsapi::ColumnStoreSystemCatalog* fresh_catalog = nullptr;
+		mcsapi::ColumnStoreDriver* fresh_driver = connectDriver(options.columnStoreXML, fresh_catalog);
+		if (fresh_driver == nullptr) {
+			return false;
+		}
+		delete driver;
+		driver = fresh_driver;
+		catalog = fresh_catalog;
+		return true;
+	};
+	// imports the given files with one commit, returns the exit code and writes the output of a failed import to std::cerr. mcsapi_failed tells if the import failed in mcsapi rather than because of the files.
+	auto importFiles = [&](const std::vector<std::string>& files, RowSinkSummary& summary, bool& mcsapi_failed) {
+		ImportOptions batch_options = options;
+		batch_options.input_files = files;
+		if (files.size() > 1 && batch_options.threads == 0) {
+			batch_options.threads = std::max(1u, std::thread::hardware_concurrency());
+		}
+		std::ostringstream out;
+		std::ostringstream err;
+		int32_t code;
+		mcsapi_failed = false;
+		try {
+			std::unique_ptr<MCSRemoteImport> mcsimport;
+			try {
+				mcsimport.reset(new MCSRemoteImport(batch_options, out, err, driver, catalog));
+			}
+			catch (OutdatedCatalogError&) {
+				// the table was altered, the batch is imported with the catalog read again
+				if (!refreshCatalog()) {
+					throw;
+				}
+				std::cout << "The system catalog entry of " << options.database << "." << options.table << " changed, the system catalog was read again" << std::endl;
+				err.str("");
+				mcsimport.reset(new MCSRemoteImport(batch_options, out, err, driver, catalog));
+			}
+			code = mcsimport->import();
+			summary = mcsimport->summary();
+			mcsapi_failed = mcsimport->failedInMcsapi();
+		}
+		catch (OutdatedCatalogError&) {
+			code = 2;
+			mcsapi_failed = true;
+		}
+		catch (McsapiError&) {
+			code = 2;
+			mcsapi_failed = true;
+		}
+		catch (SetupError&) {
+			code = 2;
+		}
+		catch (std::exception& e) {
+			err << "Error: " << e.what() << std::endl;
+			code = 2;
+		}
+		if (code != 0) {
+			std::cerr << err.str() << std::flush;
+		}
+		return code;
+	};
+	// moves imported or failed files and accounts their latency from being ready to being moved
+	auto finish = [&](const std::vector<SpoolFile>& files, bool imported) {
+		Clock::time_point now = Clock::now();
+		for (auto const& f : files) {
+			if (!(imported ? spool.moveToDone(f.path) : spool.moveToFailed(f.path))) {
+				std::cerr << "Error: Can't move " << f.path << " into the " << (imported ? "done" : "failed") << " directory" << std::endl;
+			}
+			double latency = std::chrono::duration<double>(now - f.ready).count();
+			(imported ? stats.files_imported : stats.files_failed)++;
+			stats.last_latency = latency;
+			stats.max_latency = std::max(stats.max_latency, latency);
+			stats.total_latency += latency;
+			if (latency_target > 0 && latency > latency_target) {
+				stats.files_over_latency_target++;
+			}
+		}
+	};
+
+	while (!stopping) {
+		// wait for new files, or until the oldest pending file lingered long enough
+		double timeout = 1;
+		if (pending.size() >= batch_files) {
+			timeout = 0;
+		}
+		else if (!pending.empty()) {
+			timeout = std::max(0.0, linger - std::chrono::duration<double>(Clock::now() - pending.front().ready).count());
+		}
+		std::vector<std::string> ready;
+		try {
+			ready = spool.wait(timeout);
+		}
+		catch (std::exception& e) {
+			std::cerr << "Error: " << e.what() << std::endl;
+			rtn = 2;
+			break;
+		}
+		Clock::time_point now = Clock::now();
+		for (auto const& path : ready) {
+			pending.push_back(SpoolFile{ path, now });
+		}
+		if (pending.empty() || (pending.size() < batch_files && std::chrono::duration<double>(now - pending.front().ready).count() < linger)) {
+			continue;
+		}
+
+		std::vector<SpoolFile> batch;
+		std::vector<std::string> paths;
+		while (!pending.empty() && batch.size() < batch_files) {
+			batch.push_back(pending.front());
+			paths.push_back(pending.front().path);
+			pending.pop_front();
+		}
+		stats.batches++;
+		RowSinkSummary summary;
+		bool mcsapi_failed = false;
+		if (importFiles(paths, summary, mcsapi_failed) == 0) {
+			finish(batch, true);
+			stats.summary.add(summary);
+			std::cout << "Imported " << paths.size() << (paths.size() == 1 ? " file" : " files") << ", rows inserted: " << summary.rows_inserted << ", truncation count: " << summary.truncation_count << ", saturated count: " << summary.saturated_count << ", invalid count: " << summary.invalid_count << ", latency: " << stats.last_latency << "s" << std::endl;
+		}
+		else {
+			// a failure in mcsapi might be caused by an altered table or a lost connection, which the following imports recover from once the catalog was read again. a failure of the data leaves the catalog as it is.
+			if (mcsapi_failed) {
+				refreshCatalog();
+				mcsapi_failed = false;
+			}
+			// the batch was rolled back, so that only the files that fail on their own are set aside
+			if (batch.size() > 1) {
+				std::cerr << "Import of a batch of " << batch.size() << " files failed, its files are imported one by one" << std::endl;
+			}
+			for (auto const& f : batch) {
+				RowSinkSummary file_summary;
+				bool imported = batch.size() > 1 && importFiles(std::vector<std::string>(1, f.path), file_summary, mcsapi_failed) == 0;
+				finish(std::vector<SpoolFile>(1, f), imported);
+				if (imported) {
+					stats.summary.add(file_summary);
+					std::cout << "Imported " << f.path << ", rows inserted: " << file_summary.rows_inserted << ", latency: " << stats.last_latency << "s" << std::endl;
+				}
+				else {
+					std::cerr << "Import of " << f.path << " failed, it was moved into the failed directory" << std::endl;
+					if (mcsapi_failed) {
+						refreshCatalog();
+					}
+				}
+			}
+		}
+		if (latency_target > 0 && stats.last_latency > latency_target) {
+			std::cerr << "Warning: The latency of " << stats.last_latency << "s exceeds the target of " << latency_target << "s" << std::endl;
+		}
+		if (stats_json_file != "") {
+			writeSpoolStats(stats_json_file, spool, options, latency_target, stats);
+		}
+	}
+	delete driver;
+
+	std::cout << "Spool summary:" << std::endl;
+	std::cout << "Files imported: " << stats.files_imported << std::endl;
+	std::cout << "Files failed: " << stats.files_failed << std::endl;
+	std::cout << "Rows inserted: " << stats.summary.rows_inserted << std::endl;
+	std::cout << "Truncation count: " << stats.summary.truncation_count << std::endl;
+	std::cout << "Saturated count: " << stats.summary.saturated_count << std::endl;
+	std::cout << "Invalid count: " << stats.summary.invalid_count << std::endl;
+	if (latency_target > 0) {
+		std::cout << "Files over the latency target: " << stats.files_over_latency_target << std::endl;
 	}
-	MCSRemoteImport* mcsimport = new MCSRemoteImport(argv[3], argv[1], argv[2], mappingFile, columnStoreXML, delimiter, inputDateFormat, default_non_mapped, escape_character, enclose_by_character, header, error_log, nullOption, ignore_malformed_csv);
-	int32_t rtn = mcsimport->import();
 	return rtn;
 }
 
+int main(int argc, char* argv[])
+{
+	InputParser input(argc, argv);
+	if (input.cmdOptionExists("-manifest")) {
+		return runManifest(input);
+	}
+	if (input.cmdOptionExists("-spool")) {
+		return runSpool(input, argc, argv);
+	}
+
+	// Check if the command line arguments are valid
+	if (argc < 4) {
+		std::cerr << "Usage: " << argv[0] << " database table input_file [input_file ...] [-m mapping_file] [-c Columnstore.xml] [-d delimiter] [-df date_format] [-n null_option] [-default_non_mapped] [-E enclose_by_character] [-C escape_character] [-header] [-ignore_malformed_csv] [-err_log] [-j threads] [-commit_rows rows] [-commit_bytes bytes] [-checkpoint checkpoint_file] [-resume] [-follow] [-commit_ms milliseconds] [-follow_idle seconds] [-progress seconds] [-stats_json stats_file] [-validate_only] [-max_errors errors] [-max_error_ratio ratio] [-ndjson] [-catalog_cache cache_file] [-catalog_cache_ttl seconds] [-sort_by column[,column ...]] [-sort_memory megabytes] [-sort_tmpdir directory] [-conversion_cache values]" << std::endl;
+		std::cerr << "       " << argv[0] << " -manifest manifest_file [-c Columnstore.xml] [-max_parallel imports]" << std::endl;
+		std::cerr << "       " << argv[0] << " database table -spool spool_directory [-spool_batch files] [-spool_linger seconds] [-spool_latency seconds] [import options]" << std::endl;
+		return 1;
+	}
+
+	// Parse the optional command line arguments
+	ImportOptions options;
+	int32_t rtn = parseImportOptions(input, options, std::cerr);
+	if (rtn != 0) {
+		return rtn;
+	}
+	options.database = argv[1];
+	options.table = argv[2];
+	options.input_files = expandInputFiles(input.getPositionalArguments(2));
+	if (options.input_files.empty()) {
+		std::cerr << "Error: No input file was given" << std::endl;
+		return 2;
+	}
+	if (options.follow) {
+		if (options.input_files.size() > 1 || options.input_files[0] == "-") {
+			std::cerr << "Error: -follow needs a single input file, stdin and several files can't be followed" << std::endl;
+			return 2;
+		}
+		// the import ends with a last commit
+		std::signal(SIGINT, requestStop);
+		std::signal(SIGTERM, requestStop);
+	}
+	if (options.input_files.size() > 1 && options.threads == 0) {
+		// several input files are always read and parsed concurrently
+		options.threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	try {
+		MCSRemoteImport mcsimport(options);
+		return mcsimport.import();
+	}
+	catch (SetupError&) {
+		return 2;
+	}
+}
@@ -0,0 +1,29 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#include "probes.h"
+
+#ifdef HAVE_USDT
+
+// the semaphores are incremented by tracers attaching to the probes, in the section they look for them
+extern "C" {
+volatile unsigned short mcsimport_row_parsed_semaphore __attribute__((unused, section(".probes"))) = 0;
+volatile unsigned short mcsimport_malformed_line_semaphore __attribute__((unused, section(".probes"))) = 0;
+volatile unsigned short mcsimport_convert_status_semaphore __attribute__((unused, section(".probes"))) = 0;
+volatile unsigned short mcsimport_write_row_semaphore __attribute__((unused, section(".probes"))) = 0;
+volatile unsigned short mcsimport_commit_start_semaphore __attribute__((unused, section(".probes"))) = 0;
+volatile unsigned short mcsimport_commit_end_semaphore __attribute__((unused, section(".probes"))) = 0;
+}
+
+#endif
@@ -0,0 +1,72 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#pragma once
+
+/*
+* Static tracepoints (USDT) of the import loop, for SystemTap, bpftrace and perf.
+* They are compiled in with the cmake option USDT_PROBES if sys/sdt.h is available,
+* and otherwise expand to nothing. A probe nobody is attached to is a nop, and the
+* arguments that are costly to track, like the byte offset of each row, are only
+* tracked while a semaphore states that a tracer is attached to some probe.
+*
+* provider mcsimport:
+*   row_parsed(row, offset, field_count)          a csv row or json line was tokenized
+*   malformed_line(row, offset, field_count)      a row has the wrong number of fields
+*   convert_status(row, offset, column, status)   setColumn() reported a status other than CONVERT_STATUS_NONE
+*   write_row(row, offset, column_count)          the row was handed over to writeRow()
+*   commit_start(row, offset)                     a commit starts after row ended at offset
+*   commit_end(row, offset, rows_inserted)        the commit ended with rows_inserted rows
+*
+* row counts the rows of all input files from 1, offset is the byte offset of the
+* row in its input file. With -sort_by rows are written in sorted order, and write_row
+* and convert_status report their position in that order and the offset 0.
+*/
+
+#ifdef HAVE_USDT
+
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+extern "C" {
+extern volatile unsigned short mcsimport_row_parsed_semaphore;
+extern volatile unsigned short mcsimport_malformed_line_semaphore;
+extern volatile unsigned short mcsimport_convert_status_semaphore;
+extern volatile unsigned short mcsimport_write_row_semaphore;
+extern volatile unsigned short mcsimport_commit_start_semaphore;
+extern volatile unsigned short mcsimport_commit_end_semaphore;
+}
+
+#define MCSIMPORT_PROBE2(name, a1, a2) STAP_PROBE2(mcsimport, name, a1, a2)
+#define MCSIMPORT_PROBE3(name, a1, a2, a3) STAP_PROBE3(mcsimport, name, a1, a2, a3)
+#define MCSIMPORT_PROBE4(name, a1, a2, a3, a4) STAP_PROBE4(mcsimport, name, a1, a2, a3, a4)
+
+/*
+* returns true while a tracer is attached to any probe whose arguments need the row offsets
+*/
+inline bool mcsimportProbesEnabled() {
+	return __builtin_expect((mcsimport_row_parsed_semaphore | mcsimport_malformed_line_semaphore | mcsimport_convert_status_semaphore | mcsimport_write_row_semaphore | mcsimport_commit_start_semaphore | mcsimport_commit_end_semaphore) != 0, 0);
+}
+
+#else
+
+#define MCSIMPORT_PROBE2(name, a1, a2) do {} while (0)
+#define MCSIMPORT_PROBE3(name, a1, a2, a3) do {} while (0)
+#define MCSIMPORT_PROBE4(name, a1, a2, a3, a4) do {} while (0)
+
+inline bool mcsimportProbesEnabled() {
+	return false;
+}
+
+#endif
@@ -0,0 +1,416 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+#include "row_conversion.h"
+
+#include <cctype>
+
+// integers with up to this number of digits can't overflow the 64 bit accumulator
+static const size_t MAX_INT64_DIGITS = 18;
+static const size_t MAX_UINT64_DIGITS = 19;
+// doubles with up to 15 significant digits divided by an exact power of ten are correctly rounded
+static const size_t MAX_DOUBLE_DIGITS = 15;
+static const size_t MAX_DOUBLE_SCALE = 22;
+static const double POWERS_OF_TEN[MAX_DOUBLE_SCALE + 1] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+static bool isDigit(char c) {
+	return c >= '0' && c <= '9';
+}
+
+/*
+* parses an optional minus sign followed by up to max_digits digits, nothing else is accepted
+*/
+static bool parseInteger(const char* data, size_t length, size_t max_digits, bool& negative, std::uint64_t& magnitude) {
+	const char* end = data + length;
+	negative = data < end && *data == '-';
+	if (negative) {
+		data++;
+	}
+	if (data == end || (size_t)(end - data) > max_digits) {
+		return false;
+	}
+	magnitude = 0;
+	for (; data < end; data++) {
+		if (!isDigit(*data)) {
+			return false;
+		}
+		magnitude = magnitude * 10 + (std::uint64_t)(*data - '0');
+	}
+	return true;
+}
+
+/*
+* parses a decimal of the form -123.45 that fits the column's precision and scale into its unscaled number and scale
+*/
+static bool parseDecimal(const char* data, size_t length, const ColumnConversion& conversion, std::int64_t& number, std::uint32_t& scale) {
+	const char* end = data + length;
+	bool negative = data < end && *data == '-';
+	if (negative) {
+		if (!conversion.allow_negative) {
+			return false;
+		}
+		data++;
+	}
+	std::uint64_t magnitude = 0;
+	size_t integer_digits = 0;
+	for (; data < end && isDigit(*data); data++, integer_digits++) {
+		magnitude = magnitude * 10 + (std::uint64_t)(*data - '0');
+	}
+	scale = 0;
+	if (data < end && *data == '.') {
+		for (data++; data < end && isDigit(*data); data++, scale++) {
+			magnitude = magnitude * 10 + (std::uint64_t)(*data - '0');
+		}
+		if (scale == 0) {
+			return false;
+		}
+	}
+	if (data != end || integer_digits == 0 || integer_digits + scale > MAX_INT64_DIGITS || scale > conversion.scale || integer_digits > conversion.precision - conversion.scale) {
+		return false;
+	}
+	number = negative ? -(std::int64_t) magnitude : (std::int64_t) magnitude;
+	return true;
+}
+
+/*
+* parses a decimal of the form -123.45 into a double if it can be converted exactly rounded without strtod
+*/
+static bool parseDouble(const char* data, size_t length, bool allow_negative, double& value) {
+	const char* end = data + length;
+	bool negative = data < end && *data == '-';
+	if (negative) {
+		if (!allow_negative) {
+			return false;
+		}
+		data++;
+	}
+	std::uint64_t mantissa = 0;
+	size_t integer_digits = 0;
+	size_t scale = 0;
+	size_t significant_digits = 0;
+	for (; data < end && isDigit(*data); data++, integer_digits++) {
+		mantissa = mantissa * 10 + (std::uint64_t)(*data - '0');
+		if (mantissa > 0) {
+			significant_digits++;
+		}
+	}
+	if (data < end && *data == '.') {
+		for (data++; data < end && isDigit(*data); data++, scale++) {
+			mantissa = mantissa * 10 + (std::uint64_t)(*data - '0');
+			if (mantissa > 0) {
+				significant_digits++;
+			}
+			if (significant_digits > MAX_DOUBLE_DIGITS) {
+				return false;
+			}
+		}
+		if (scale == 0) {
+			return false;
+		}
+	}
+	if (data != end || integer_digits == 0 || significant_digits > MAX_DOUBLE_DIGITS || scale > MAX_DOUBLE_SCALE) {
+		return false;
+	}
+	value = (double) mantissa / POWERS_OF_TEN[scale];
+	if (negative) {
+		value = -value;
+	}
+	return true;
+}
+
+static std::uint32_t daysInMonth(std::uint32_t year, std::uint32_t month) {
+	static const std::uint32_t DAYS[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+	if (month == 2 && ((year % 4 == 0 && year % 100 != 0) || year % 400 == 0)) {
+		return 29;
+	}
+	return DAYS[month - 1];
+}
+
+void DateFormat::add(Element element, char literal) {
+	Step step;
+	step.element = element;
+	step.literal = literal;
+	this->steps.push_back(step);
+}
+
+bool DateFormat::compile(const std::string& format) {
+	this->steps.clear();
+	for (size_t i = 0; i < format.size(); i++) {
+		char c = format[i];
+		if (std::isspace((unsigned char) c)) {
+			add(WHITESPACE);
+		}
+		else if (c != '%') {
+			add(LITERAL, c);
+		}
+		else if (++i < format.size()) {
+			switch (format[i]) {
+			case 'Y': add(YEAR); break;
+			case 'm': add(MONTH); break;
+			case 'd': add(DAY); break;
+			case 'H': add(HOUR); break;
+			case 'M': add(MINUTE); break;
+			case 'S': add(SECOND); break;
+			case 'F': add(YEAR); add(LITERAL, '-'); add(MONTH); add(LITERAL, '-'); add(DAY); break;
+			case 'T': add(HOUR); add(LITERAL, ':'); add(MINUTE); add(LITERAL, ':'); add(SECOND); break;
+			case '%': add(LITERAL, '%'); break;
+			default: return false;
+			}
+		}
+		else {
+			return false;
+		}
+	}
+	// without a year, month and day strptime would leave parts of the date zeroed
+	bool year = false, month = false, day = false;
+	for (auto const& step : this->steps) {
+		year = year || step.element == YEAR;
+		month = month || step.element == MONTH;
+		day = day || step.element == DAY;
+	}
+	return year && month && day;
+}
+
+bool DateFormat::parse(const char* data, size_t length, DateTimeFields& fields) const {
+	const char* end = data + length;
+	std::uint32_t year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+	for (auto const& step : this->steps) {
+		if (step.element == LITERAL) {
+			if (data == end || *data != step.literal) {
+				return false;
+			}
+			data++;
+			continue;
+		}
+		if (step.element == WHITESPACE) {
+			while (data < end && std::isspace((unsigned char) *data)) {
+				data++;
+			}
+			continue;
+		}
+		// numbers are read greedily up to their maximum number of digits like strptime does
+		size_t max_digits = step.element == YEAR ? 4 : 2;
+		std::uint32_t number = 0;
+		size_t digits = 0;
+		for (; data < end && digits < max_digits && isDigit(*data); data++, digits++) {
+			number = number * 10 + (std::uint32_t)(*data - '0');
+		}
+		if (digits == 0) {
+			return false;
+		}
+		switch (step.element) {
+		case YEAR: year = number; break;
+		case MONTH: month = number; break;
+		case DAY: day = number; break;
+		case HOUR: hour = number; break;
+		case MINUTE: minute = number; break;
+		default: second = number; break;
+		}
+	}
+	if (data != end || year < 1000 || month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month) || hour > 23 || minute > 59 || second > 59) {
+		return false;
+	}
+	fields.year = (std::uint16_t) year;
+	fields.month = (std::uint8_t) month;
+	fields.day = (std::uint8_t) day;
+	fields.hour = (std::uint8_t) hour;
+	fields.minute = (std::uint8_t) minute;
+	fields.second = (std::uint8_t) second;
+	return true;
+}
+
+void ColumnConversion::setColumnType(mcsapi::columnstore_data_types_t type, std::uint32_t type_precision, std::uint32_t type_scale) {
+	this->precision = type_precision;
+	this->scale = type_scale;
+	this->allow_negative = true;
+	// the lowest values of signed and the highest values of unsigned columns are reserved as NULL markers
+	switch (type) {
+	case mcsapi::DATA_TYPE_TINYINT:
+		this->handler = CSV_INTEGER;
+		this->min_value = INT8_MIN + 2;
+		this->max_value = INT8_MAX;
+		break;
+	case mcsapi::DATA_TYPE_SMALLINT:
+		this->handler = CSV_INTEGER;
+		this->min_value = INT16_MIN + 2;
+		this->max_value = INT16_MAX;
+		break;
+	case mcsapi::DATA_TYPE_MEDINT:
+		this->handler = CSV_INTEGER;
+		this->min_value = -8388608 + 2;
+		this->max_value = 8388607;
+		break;
+	case mcsapi::DATA_TYPE_INT:
+		this->handler = CSV_INTEGER;
+		this->min_value = INT32_MIN + 2;
+		this->max_value = INT32_MAX;
+		break;
+	case mcsapi::DATA_TYPE_BIGINT:
+		this->handler = CSV_INTEGER;
+		this->min_value = INT64_MIN + 2;
+		this->max_value = INT64_MAX;
+		break;
+	case mcsapi::DATA_TYPE_UTINYINT:
+		this->handler = CSV_UNSIGNED;
+		this->max_value = UINT8_MAX - 2;
+		break;
+	case mcsapi::DATA_TYPE_USMALLINT:
+		this->handler = CSV_UNSIGNED;
+		this->max_value = UINT16_MAX - 2;
+		break;
+	case mcsapi::DATA_TYPE_UMEDINT:
+		this->handler = CSV_UNSIGNED;
+		this->max_value = 16777215 - 2;
+		break;
+	case mcsapi::DATA_TYPE_UINT:
+		this->handler = CSV_UNSIGNED;
+		this->max_value = UINT32_MAX - 2;
+		break;
+	case mcsapi::DATA_TYPE_UBIGINT:
+		this->handler = CSV_UNSIGNED;
+		this->max_value = UINT64_MAX - 2;
+		break;
+	case mcsapi::DATA_TYPE_DECIMAL:
+		this->handler = type_scale <= type_precision ? CSV_DECIMAL : CSV_NUMERIC;
+		break;
+	case mcsapi::DATA_TYPE_UDECIMAL:
+		this->handler = type_scale <= type_precision ? CSV_DECIMAL : CSV_NUMERIC;
+		this->allow_negative = false;
+		break;
+	case mcsapi::DATA_TYPE_DOUBLE:
+		this->handler = CSV_DOUBLE;
+		break;
+	case mcsapi::DATA_TYPE_UDOUBLE:
+		this->handler = CSV_DOUBLE;
+		this->allow_negative = false;
+		break;
+	default:
+		this->handler = ConversionPlan::isNumericType(type) ? CSV_NUMERIC : CSV_STRING;
+	}
+}
+
+void ConversionPlan::addColumn(const ColumnConversion& conversion) {
+	this->columns.push_back(conversion);
+}
+
+void ConversionPlan::convertRow(const CsvField* parsed_csv_fields, ConvertedValue* values) const {
+	const ColumnConversion* conversion = this->columns.data();
+	for (size_t col = 0; col < this->columns.size(); col++, conversion++) {
+		ConvertedValue& v = values[col];
+		if (conversion->handler == ColumnConversion::DEFAULT_NULL) {
+			v.type = ConvertedValue::VALUE_NULL;
+			continue;
+		}
+		if (conversion->handler == ColumnConversion::DEFAULT_VALUE) {
+			v.type = ConvertedValue::VALUE_STRING;
+			v.text = CsvField{ conversion->value.data(), conversion->value.size() };
+			continue;
+		}
+		const CsvField& field = parsed_csv_fields[conversion->csv_column];
+		// empty values are injected as NULL
+		if (field.empty() || (conversion->null_literal && field == "NULL")) {
+			v.type = ConvertedValue::VALUE_NULL;
+			continue;
+		}
+		v.type = ConvertedValue::VALUE_STRING;
+		v.text = field;
+		switch (conversion->handler) {
+		case ColumnConversion::CSV_DATETIME:
+			if (conversion->date_format_compiled && conversion->date_format.parse(field.data, field.length, v.datetime)) {
+				v.type = ConvertedValue::VALUE_DATETIME_FIELDS;
+			}
+			else {
+				v.type = ConvertedValue::VALUE_DATETIME;
+				v.format = &conversion->value;
+			}
+			break;
+		case ColumnConversion::CSV_NUMERIC:
+			if (field == "true") {
+				v.type = ConvertedValue::VALUE_TRUE;
+			}
+			break;
+		case ColumnConversion::CSV_INTEGER: {
+			bool negative;
+			std::uint64_t magnitude;
+			if (field == "true") {
+				v.type = ConvertedValue::VALUE_TRUE;
+			}
+			else if (parseInteger(field.data, field.length, MAX_INT64_DIGITS, negative, magnitude) && (negative ? -(std::int64_t) magnitude >= conversion->min_value : magnitude <= conversion->max_value)) {
+				v.type = ConvertedValue::VALUE_INT;
+				v.int_value = negative ? -(std::int64_t) magnitude : (std::int64_t) magnitude;
+			}
+			break;
+		}
+		case ColumnConversion::CSV_UNSIGNED: {
+			bool negative;
+			std::uint64_t magnitude;
+			if (field == "true") {
+				v.type = ConvertedValue::VALUE_TRUE;
+			}
+			else if (parseInteger(field.data, field.length, MAX_UINT64_DIGITS, negative, magnitude) && !negative && magnitude <= conversion->max_value) {
+				v.type = ConvertedValue::VALUE_UINT;
+				v.uint_value = magnitude;
+			}
+			break;
+		}
+		case ColumnConversion::CSV_DECIMAL: {
+			std::int64_t number;
+			std::uint32_t scale;
+			if (field == "true") {
+				v.type = ConvertedValue::VALUE_TRUE;
+			}
+			else if (parseDecimal(field.data, field.length, *conversion, number, scale)) {
+				v.type = ConvertedValue::VALUE_DECIMAL;
+				v.int_value = number;
+				v.scale = (std::uint8_t) scale;
+			}
+			break;
+		}
+		case ColumnConversion::CSV_DOUBLE:
+			if (field == "true") {
+				v.type = ConvertedValue::VALUE_TRUE;
+			}
+			else if (parseDouble(field.data, field.length, conversion->allow_negative, v.double_value)) {
+				v.type = ConvertedValue::VALUE_DOUBLE;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+bool ConversionPlan::isNumericType(mcsapi::columnstore_data_types_t type) {
+	switch (type) {
+	case mcsapi::DATA_TYPE_BIGINT:
+	case mcsapi::DATA_TYPE_BIT:
+	case mcsapi::DATA_TYPE_DECIMAL:
+	case mcsapi::DATA_TYPE_DOUBLE:
+	case mcsapi::DATA_TYPE_FLOAT:
+	case mcsapi::DATA_TYPE_INT:
+	case mcsapi::DATA_TYPE_MEDINT:
+	case mcsapi::DATA_TYPE_SMALLINT:
+	case mcsapi::DATA_TYPE_TINYINT:
+	case mcsapi::DATA_TYPE_UBIGINT:
+	case mcsapi::DATA_TYPE_UDECIMAL:
+	case mcsapi::DATA_TYPE_UDOUBLE:
+	case mcsapi::DATA_TYPE_UFLOAT:
+	case mcsapi::DATA_TYPE_UINT:
+	case mcsapi::DATA_TYPE_UMEDINT:
+	case mcsapi::DATA_TYPE_USMALLINT:
+	case mcsapi::DATA_TYPE_UTINYINT:
+		return true;
+	default:
+		return false;
+	}
+}
@@ -0,0 +1,151 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <libmcsapi/mcsapi.h>
+#include "csv_reader.h"
+
+/**
+* A date and time as parsed by a DateFormat, in the fields of std::tm.
+*/
+struct DateTimeFields {
+	std::uint16_t year;
+	std::uint8_t month;
+	std::uint8_t day;
+	std::uint8_t hour;
+	std::uint8_t minute;
+	std::uint8_t second;
+};
+
+/**
+* The value of a target column prepared from a csv row, ready to be handed over to mcsapi.
+*/
+struct ConvertedValue {
+	enum Type {
+		VALUE_NULL,            // setNull()
+		VALUE_STRING,          // setColumn() with text as string
+		VALUE_DATETIME,        // setColumn() with a ColumnStoreDateTime parsed from text using format
+		VALUE_TRUE,            // setColumn() with 1 for the literal "true" in numeric columns
+		VALUE_INT,             // setColumn() with int_value
+		VALUE_UINT,            // setColumn() with uint_value
+		VALUE_DECIMAL,         // setColumn() with a ColumnStoreDecimal of int_value and scale
+		VALUE_DOUBLE,          // setColumn() with double_value
+		VALUE_DATETIME_FIELDS  // setColumn() with a ColumnStoreDateTime of datetime
+	};
+
+	Type type;
+	CsvField text;
+	const std::string* format;
+	union {
+		std::int64_t int_value;
+		std::uint64_t uint_value;
+		double double_value;
+		DateTimeFields datetime;
+	};
+	std::uint8_t scale;
+};
+
+/**
+* A strptime date format compiled once, that parses the common numeric date and time
+* fields without allocating. Only formats made of %Y, %m, %d, %H, %M, %S, %F, %T, %%
+* and literal characters can be compiled, and only input that strptime would parse
+* into a valid date with the same fields is accepted. Everything else is left to mcsapi.
+*/
+class DateFormat {
+public:
+	/*
+	* compiles the given strptime format, returns false if it contains anything that can't be parsed natively
+	*/
+	bool compile(const std::string& format);
+
+	/*
+	* parses the given value, returns false if it doesn't strictly match the format or isn't a valid date
+	*/
+	bool parse(const char* data, size_t length, DateTimeFields& fields) const;
+
+private:
+	enum Element { LITERAL, WHITESPACE, YEAR, MONTH, DAY, HOUR, MINUTE, SECOND };
+	struct Step {
+		Element element;
+		char literal;
+	};
+	std::vector<Step> steps;
+
+	void add(Element element, char literal = 0);
+};
+
+/**
+* How the value of one target column is derived from a csv row. Decided once from the
+* column's type, nullability, mapping, default value, date format and the null option.
+*/
+struct ColumnConversion {
+	enum Handler {
+		DEFAULT_NULL,  // the default value is injected as NULL
+		DEFAULT_VALUE, // the default value is injected as string
+		CSV_STRING,    // the csv field is injected as string
+		CSV_DATETIME,  // the csv field is parsed using the date format
+		CSV_NUMERIC,   // the csv field is injected as string, the literal "true" as 1
+		CSV_INTEGER,   // like CSV_NUMERIC, but integers between min_value and max_value are injected as int64
+		CSV_UNSIGNED,  // like CSV_NUMERIC, but integers up to max_value are injected as uint64
+		CSV_DECIMAL,   // like CSV_NUMERIC, but decimals fitting precision and scale are injected as ColumnStoreDecimal
+		CSV_DOUBLE     // like CSV_NUMERIC, but decimals that can be converted exactly are injected as double
+	};
+
+	Handler handler = CSV_STRING;
+	std::int32_t csv_column = -1; // the mapped csv column, or the mapping's default value marker
+	bool null_literal = false; // the csv value "NULL" is injected as NULL
+	std::string value; // the default value or the date format
+	bool date_format_compiled = false; // if date_format can parse value natively
+	DateFormat date_format;
+	bool allow_negative = true;
+	std::int64_t min_value = 0;
+	std::uint64_t max_value = 0;
+	std::uint32_t precision = 0;
+	std::uint32_t scale = 0;
+
+	/*
+	* chooses the handler for a csv column of the given type. values outside of the native ranges and of the column's reserved NULL markers are left to mcsapi, so that it reports their conversion status.
+	*/
+	void setColumnType(mcsapi::columnstore_data_types_t type, std::uint32_t type_precision, std::uint32_t type_scale);
+};
+
+/**
+* The conversions of all target columns of a table, applied to each csv row.
+*/
+class ConversionPlan {
+public:
+	/*
+	* appends the conversion of the next target column
+	*/
+	void addColumn(const ColumnConversion& conversion);
+
+	size_t columnCount() const { return this->columns.size(); }
+	const ColumnConversion& column(size_t col) const { return this->columns[col]; }
+
+	/*
+	* prepares the value of every target column from a well formed csv row. only reads the plan, so it can run on several threads.
+	*/
+	void convertRow(const CsvField* parsed_csv_fields, ConvertedValue* values) const;
+
+	/*
+	* returns true if the given columnstore data type is numeric
+	*/
+	static bool isNumericType(mcsapi::columnstore_data_types_t type);
+
+private:
+	std::vector<ColumnConversion> columns;
+};
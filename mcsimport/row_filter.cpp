@@ -0,0 +1,153 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#include "row_filter.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+/*
+* orders a value of a field against a filter value like std::string::compare
+*/
+static int compareField(const std::string& value, const char* data, size_t length) {
+	int c = std::memcmp(value.data(), data, std::min(value.size(), length));
+	if (c != 0) {
+		return c;
+	}
+	return value.size() < length ? -1 : (value.size() > length ? 1 : 0);
+}
+
+void RowFilter::addNullCheck(std::int32_t csv_column, bool is_null, bool null_literal) {
+	Predicate predicate;
+	predicate.kind = is_null ? IS_NULL : NOT_NULL;
+	predicate.csv_column = csv_column;
+	predicate.null_literal = null_literal;
+	add(predicate);
+}
+
+void RowFilter::addValues(std::int32_t csv_column, const std::vector<std::string>& values) {
+	Predicate predicate;
+	predicate.kind = values.size() == 1 ? EQUALS : IN_LIST;
+	predicate.csv_column = csv_column;
+	predicate.values = values;
+	std::sort(predicate.values.begin(), predicate.values.end());
+	add(predicate);
+}
+
+void RowFilter::addRange(std::int32_t csv_column, const std::string* min, const std::string* max) {
+	Predicate predicate;
+	predicate.kind = NUMBER_RANGE;
+	predicate.csv_column = csv_column;
+	if (min != nullptr) {
+		if (!parseNumber(min->data(), min->size(), predicate.min_number)) {
+			throw std::invalid_argument("The filter minimum " + *min + " isn't a number.");
+		}
+		predicate.has_min = true;
+	}
+	if (max != nullptr) {
+		if (!parseNumber(max->data(), max->size(), predicate.max_number)) {
+			throw std::invalid_argument("The filter maximum " + *max + " isn't a number.");
+		}
+		predicate.has_max = true;
+	}
+	add(predicate);
+}
+
+void RowFilter::addDateRange(std::int32_t csv_column, const std::string& format, const std::string* from, const std::string* to) {
+	Predicate predicate;
+	predicate.kind = DATE_RANGE;
+	predicate.csv_column = csv_column;
+	if (!predicate.date_format.compile(format)) {
+		throw std::invalid_argument("The date format " + format + " can't be used to filter, only %Y, %m, %d, %H, %M, %S, %F and %T are supported.");
+	}
+	DateTimeFields fields;
+	if (from != nullptr) {
+		if (!predicate.date_format.parse(from->data(), from->size(), fields)) {
+			throw std::invalid_argument("The filter date " + *from + " doesn't match the date format " + format + ".");
+		}
+		predicate.min_date = dateKey(fields);
+		predicate.has_min = true;
+	}
+	if (to != nullptr) {
+		if (!predicate.date_format.parse(to->data(), to->size(), fields)) {
+			throw std::invalid_argument("The filter date " + *to + " doesn't match the date format " + format + ".");
+		}
+		predicate.max_date = dateKey(fields);
+		predicate.has_max = true;
+	}
+	add(predicate);
+}
+
+void RowFilter::markColumns(std::vector<char>& columns) const {
+	for (auto const& p : this->predicates) {
+		if ((size_t) p.csv_column < columns.size()) {
+			columns[p.csv_column] = 1;
+		}
+	}
+}
+
+void RowFilter::add(const Predicate& predicate) {
+	auto position = std::upper_bound(this->predicates.begin(), this->predicates.end(), predicate, [](const Predicate& a, const Predicate& b) { return a.kind < b.kind; });
+	this->predicates.insert(position, predicate);
+}
+
+bool RowFilter::Predicate::matches(const CsvField& field) const {
+	switch (this->kind) {
+	case IS_NULL:
+		return field.length == 0 || (this->null_literal && field.length == 4 && std::memcmp(field.data, "NULL", 4) == 0);
+	case NOT_NULL:
+		return field.length != 0 && !(this->null_literal && field.length == 4 && std::memcmp(field.data, "NULL", 4) == 0);
+	case EQUALS:
+		return compareField(this->values[0], field.data, field.length) == 0;
+	case IN_LIST: {
+		auto it = std::lower_bound(this->values.begin(), this->values.end(), field, [](const std::string& value, const CsvField& f) { return compareField(value, f.data, f.length) < 0; });
+		return it != this->values.end() && compareField(*it, field.data, field.length) == 0;
+	}
+	case NUMBER_RANGE: {
+		long double number;
+		if (!RowFilter::parseNumber(field.data, field.length, number)) {
+			return false;
+		}
+		return (!this->has_min || number >= this->min_number) && (!this->has_max || number <= this->max_number);
+	}
+	case DATE_RANGE: {
+		DateTimeFields fields;
+		if (!this->date_format.parse(field.data, field.length, fields)) {
+			return false;
+		}
+		std::uint64_t date = RowFilter::dateKey(fields);
+		return (!this->has_min || date >= this->min_date) && (!this->has_max || date <= this->max_date);
+	}
+	}
+	return false;
+}
+
+bool RowFilter::parseNumber(const char* data, size_t length, long double& number) {
+	// the field isn't null terminated, numbers are short enough to be copied
+	char buffer[64];
+	if (length == 0 || length >= sizeof(buffer)) {
+		return false;
+	}
+	std::memcpy(buffer, data, length);
+	buffer[length] = '\0';
+	char* end;
+	number = std::strtold(buffer, &end);
+	return end == buffer + length;
+}
+
+std::uint64_t RowFilter::dateKey(const DateTimeFields& fields) {
+	return ((((((std::uint64_t) fields.year * 100 + fields.month) * 100 + fields.day) * 100 + fields.hour) * 100 + fields.minute) * 100) + fields.second;
+}
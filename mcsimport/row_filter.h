@@ -0,0 +1,99 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "csv_reader.h"
+#include "row_conversion.h"
+
+/**
+* Decides which csv rows are imported, by predicates on their csv columns that
+* all have to match. The predicates are compiled once, and evaluated on the raw
+* fields of each well formed row without allocating, cheapest first:
+* - null checks, a field is NULL if it is empty or the literal "NULL" with null_literal
+* - equality with one of a list of values
+* - numeric ranges, fields that aren't numbers don't match
+* - date ranges of fields parsed with a date format, fields that aren't valid dates don't match
+* Range bounds are inclusive and either of them may be left out.
+*/
+class RowFilter {
+public:
+	/*
+	* matches rows whose field is NULL, or isn't NULL if is_null is false
+	*/
+	void addNullCheck(std::int32_t csv_column, bool is_null, bool null_literal);
+
+	/*
+	* matches rows whose field equals one of the given values
+	*/
+	void addValues(std::int32_t csv_column, const std::vector<std::string>& values);
+
+	/*
+	* matches rows whose field is a number between min and max. throws std::invalid_argument if a given bound isn't a number.
+	*/
+	void addRange(std::int32_t csv_column, const std::string* min, const std::string* max);
+
+	/*
+	* matches rows whose field is a date of the given strptime format between from and to. throws std::invalid_argument if the format can't be compiled by DateFormat or a given bound doesn't match it.
+	*/
+	void addDateRange(std::int32_t csv_column, const std::string& format, const std::string* from, const std::string* to);
+
+	bool empty() const { return this->predicates.empty(); }
+
+	/*
+	* sets the csv columns the predicates read in the given mask, that has an entry per csv column
+	*/
+	void markColumns(std::vector<char>& columns) const;
+
+	/*
+	* returns true if the given well formed csv row passes all predicates. only reads the filter, so it can run on several threads.
+	*/
+	bool matches(const CsvField* parsed_csv_fields) const {
+		for (auto const& p : this->predicates) {
+			if (!p.matches(parsed_csv_fields[p.csv_column])) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+private:
+	// ordered by the cost of their evaluation
+	enum Kind { IS_NULL, NOT_NULL, EQUALS, IN_LIST, NUMBER_RANGE, DATE_RANGE };
+
+	struct Predicate {
+		Kind kind;
+		std::int32_t csv_column;
+		bool null_literal = false;
+		std::vector<std::string> values; // sorted for the binary search of IN_LIST
+		bool has_min = false;
+		bool has_max = false;
+		long double min_number = 0;
+		long double max_number = 0;
+		DateFormat date_format;
+		std::uint64_t min_date = 0;
+		std::uint64_t max_date = 0;
+
+		bool matches(const CsvField& field) const;
+	};
+
+	std::vector<Predicate> predicates;
+
+	void add(const Predicate& predicate);
+	static bool parseNumber(const char* data, size_t length, long double& number);
+	static std::uint64_t dateKey(const DateTimeFields& fields);
+};
@@ -0,0 +1,105 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+#include "row_sink.h"
+
+#include <cstdio>
+
+void RowSinkSummary::add(const RowSinkSummary& summary) {
+	this->execution_time += summary.execution_time;
+	this->rows_inserted += summary.rows_inserted;
+	this->truncation_count += summary.truncation_count;
+	this->saturated_count += summary.saturated_count;
+	this->invalid_count += summary.invalid_count;
+}
+
+NullRowSink::NullRowSink(size_t columns) : columns(columns) {
+}
+
+void NullRowSink::writeRow(const ConvertedValue* /*values*/, mcsapi::columnstore_data_convert_status_t* statuses) {
+	for (size_t col = 0; col < this->columns; col++) {
+		statuses[col] = mcsapi::CONVERT_STATUS_NONE;
+	}
+	this->rows++;
+}
+
+RowSinkSummary NullRowSink::commit() {
+	RowSinkSummary summary;
+	summary.rows_inserted = this->rows;
+	this->rows = 0;
+	return summary;
+}
+
+void NullRowSink::rollback() {
+	this->rows = 0;
+}
+
+MemoryRowSink::MemoryRowSink(size_t columns) : columns(columns) {
+}
+
+void MemoryRowSink::writeRow(const ConvertedValue* values, mcsapi::columnstore_data_convert_status_t* statuses) {
+	std::vector<std::string> row;
+	row.reserve(this->columns);
+	for (size_t col = 0; col < this->columns; col++) {
+		row.push_back(toString(values[col]));
+		statuses[col] = mcsapi::CONVERT_STATUS_NONE;
+	}
+	this->written.push_back(std::move(row));
+}
+
+RowSinkSummary MemoryRowSink::commit() {
+	RowSinkSummary summary;
+	summary.rows_inserted = this->written.size();
+	for (auto& row : this->written) {
+		this->committed.push_back(std::move(row));
+	}
+	this->written.clear();
+	return summary;
+}
+
+void MemoryRowSink::rollback() {
+	this->written.clear();
+}
+
+std::string MemoryRowSink::toString(const ConvertedValue& value) {
+	char buffer[32];
+	switch (value.type) {
+	case ConvertedValue::VALUE_NULL:
+		return "\\N";
+	case ConvertedValue::VALUE_TRUE:
+		return "1";
+	case ConvertedValue::VALUE_INT:
+		return std::to_string(value.int_value);
+	case ConvertedValue::VALUE_UINT:
+		return std::to_string(value.uint_value);
+	case ConvertedValue::VALUE_DECIMAL: {
+		// insert the decimal point scale digits from the right
+		std::string digits = std::to_string(value.int_value < 0 ? -(std::uint64_t) value.int_value : (std::uint64_t) value.int_value);
+		if (value.scale > 0) {
+			if (digits.size() <= value.scale) {
+				digits.insert(0, value.scale - digits.size() + 1, '0');
+			}
+			digits.insert(digits.size() - value.scale, 1, '.');
+		}
+		return value.int_value < 0 ? "-" + digits : digits;
+	}
+	case ConvertedValue::VALUE_DOUBLE:
+		std::snprintf(buffer, sizeof(buffer), "%.17g", value.double_value);
+		return buffer;
+	case ConvertedValue::VALUE_DATETIME_FIELDS:
+		std::snprintf(buffer, sizeof(buffer), "%04u-%02u-%02u %02u:%02u:%02u", value.datetime.year, value.datetime.month, value.datetime.day, value.datetime.hour, value.datetime.minute, value.datetime.second);
+		return buffer;
+	default:
+		return value.text.str();
+	}
+}
@@ -0,0 +1,97 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <libmcsapi/mcsapi.h>
+#include "row_conversion.h"
+
+/**
+* The counts of committed rows and of the values that couldn't be converted exactly.
+*/
+struct RowSinkSummary {
+	double execution_time = 0;
+	std::uint64_t rows_inserted = 0;
+	std::uint64_t truncation_count = 0;
+	std::uint64_t saturated_count = 0;
+	std::uint64_t invalid_count = 0;
+
+	void add(const RowSinkSummary& summary);
+};
+
+/**
+* The destination of the prepared rows of an import, e.g. a ColumnStore table.
+*/
+class RowSink {
+public:
+	virtual ~RowSink() {}
+
+	/*
+	* injects one row of prepared values, one per target column, and stores the conversion status of each value in statuses
+	*/
+	virtual void writeRow(const ConvertedValue* values, mcsapi::columnstore_data_convert_status_t* statuses) = 0;
+
+	/*
+	* commits the rows written since the last commit and returns their summary. rows written afterwards are part of a new transaction.
+	*/
+	virtual RowSinkSummary commit() = 0;
+
+	/*
+	* discards the rows written since the last commit
+	*/
+	virtual void rollback() = 0;
+};
+
+/**
+* Discards all rows and only counts them, to measure the import without a database.
+*/
+class NullRowSink : public RowSink {
+public:
+	explicit NullRowSink(size_t columns);
+	void writeRow(const ConvertedValue* values, mcsapi::columnstore_data_convert_status_t* statuses);
+	RowSinkSummary commit();
+	void rollback();
+
+private:
+	size_t columns;
+	std::uint64_t rows = 0;
+};
+
+/**
+* Keeps the committed rows in memory, each value rendered as text, e.g. to verify an import.
+*/
+class MemoryRowSink : public RowSink {
+public:
+	explicit MemoryRowSink(size_t columns);
+	void writeRow(const ConvertedValue* values, mcsapi::columnstore_data_convert_status_t* statuses);
+	RowSinkSummary commit();
+	void rollback();
+
+	/*
+	* returns the committed rows, NULL values are rendered as "\N"
+	*/
+	const std::vector<std::vector<std::string>>& committedRows() const { return this->committed; }
+
+	/*
+	* renders a prepared value as the text it stands for
+	*/
+	static std::string toString(const ConvertedValue& value);
+
+private:
+	size_t columns;
+	std::vector<std::vector<std::string>> written;
+	std::vector<std::vector<std::string>> committed;
+};
@@ -0,0 +1,604 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#include "row_sorter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+static const size_t RUN_IO_BUFFER_SIZE = 256 * 1024;
+
+// marks that order NULLs before all values and values a date key couldn't be parsed from after them
+static const char KEY_NULL = 0;
+static const char KEY_VALUE = 1;
+static const char KEY_UNPARSED = 2;
+
+static void appendBytes(std::vector<char>& out, const void* data, size_t length) {
+	const char* bytes = static_cast<const char*>(data);
+	out.insert(out.end(), bytes, bytes + length);
+}
+
+static void appendUint32(std::vector<char>& out, std::uint32_t value) {
+	appendBytes(out, &value, sizeof(value));
+}
+
+static std::uint32_t readUint32(const char*& data) {
+	std::uint32_t value;
+	std::memcpy(&value, data, sizeof(value));
+	data += sizeof(value);
+	return value;
+}
+
+/*
+* appends a value whose bytes compare in the order of the unsigned numbers
+*/
+static void appendBigEndian(std::vector<char>& out, std::uint64_t value) {
+	out.push_back(KEY_VALUE);
+	for (int shift = 56; shift >= 0; shift -= 8) {
+		out.push_back((char) (std::uint8_t) (value >> shift));
+	}
+}
+
+/*
+* appends text terminated by two zero bytes, zero bytes in the text are followed by 0xff, so that a text orders before its extensions
+*/
+static void appendText(std::vector<char>& out, char mark, const char* data, size_t length) {
+	out.push_back(mark);
+	for (size_t i = 0; i < length; i++) {
+		out.push_back(data[i]);
+		if (data[i] == '\0') {
+			out.push_back((char) 0xff);
+		}
+	}
+	out.push_back('\0');
+	out.push_back('\0');
+}
+
+/*
+* parses the number mcsapi would convert the text to, values that aren't numbers are 0
+*/
+static long double parseNumber(const CsvField& text) {
+	char buffer[128];
+	size_t length = std::min(text.length, sizeof(buffer) - 1);
+	std::memcpy(buffer, text.data, length);
+	buffer[length] = '\0';
+	char* end;
+	long double value = std::strtold(buffer, &end);
+	return end == buffer || value != value ? 0 : value;
+}
+
+static std::int64_t clampSigned(long double value) {
+	if (value <= (long double) INT64_MIN) {
+		return INT64_MIN;
+	}
+	if (value >= (long double) INT64_MAX) {
+		return INT64_MAX;
+	}
+	return (std::int64_t) value;
+}
+
+static std::uint64_t clampUnsigned(long double value) {
+	if (value <= 0) {
+		return 0;
+	}
+	if (value >= (long double) UINT64_MAX) {
+		return UINT64_MAX;
+	}
+	return (std::uint64_t) value;
+}
+
+/*
+* returns the value of a numeric column as number, with the decimals shifted by scale
+*/
+static long double numericValue(const ConvertedValue& value, std::int64_t factor) {
+	switch (value.type) {
+	case ConvertedValue::VALUE_TRUE: return factor;
+	case ConvertedValue::VALUE_INT: return (long double) value.int_value * factor;
+	case ConvertedValue::VALUE_UINT: return (long double) value.uint_value * factor;
+	case ConvertedValue::VALUE_DOUBLE: return (long double) value.double_value * factor;
+	case ConvertedValue::VALUE_DECIMAL: return (long double) value.int_value * factor / std::pow(10.0L, value.scale);
+	default: return parseNumber(value.text) * factor;
+	}
+}
+
+static std::uint64_t packDateTime(const DateTimeFields& fields) {
+	return ((std::uint64_t) fields.year << 40) | ((std::uint64_t) fields.month << 32) | ((std::uint64_t) fields.day << 24) | ((std::uint64_t) fields.hour << 16) | ((std::uint64_t) fields.minute << 8) | fields.second;
+}
+
+RowSorter::Run::~Run() {
+	if (this->file != nullptr) {
+		std::fclose(this->file);
+	}
+	// on Windows an open file can't be removed, elsewhere it was removed right after it was created
+#ifdef _WIN32
+	if (this->path != "") {
+		std::remove(this->path.c_str());
+	}
+#endif
+}
+
+RowSorter::RowSorter(const ConversionPlan& plan, const std::vector<SortKey>& keys, bool keep_fields, size_t memory_budget, const std::string& temp_directory, unsigned threads, ImportStats* stats) : plan(plan) {
+	this->keys = keys;
+	this->keep_fields = keep_fields;
+	this->buffer_budget = std::max(memory_budget / 2, (size_t) 1);
+	this->temp_directory = temp_directory;
+	this->threads = std::max(threads, 1u);
+	this->stats = stats;
+	this->datetime_format.compile("%Y-%m-%d %H:%M:%S");
+	this->date_format.compile("%Y-%m-%d");
+	for (auto const& key : keys) {
+		KeyKind kind;
+		switch (key.type) {
+		case mcsapi::DATA_TYPE_TINYINT:
+		case mcsapi::DATA_TYPE_SMALLINT:
+		case mcsapi::DATA_TYPE_MEDINT:
+		case mcsapi::DATA_TYPE_INT:
+		case mcsapi::DATA_TYPE_BIGINT:
+			kind = KEY_SIGNED;
+			break;
+		case mcsapi::DATA_TYPE_BIT:
+		case mcsapi::DATA_TYPE_UTINYINT:
+		case mcsapi::DATA_TYPE_USMALLINT:
+		case mcsapi::DATA_TYPE_UMEDINT:
+		case mcsapi::DATA_TYPE_UINT:
+		case mcsapi::DATA_TYPE_UBIGINT:
+			kind = KEY_UNSIGNED;
+			break;
+		case mcsapi::DATA_TYPE_DECIMAL:
+		case mcsapi::DATA_TYPE_UDECIMAL:
+			kind = key.scale <= 18 ? KEY_DECIMAL : KEY_DOUBLE;
+			break;
+		case mcsapi::DATA_TYPE_FLOAT:
+		case mcsapi::DATA_TYPE_UFLOAT:
+		case mcsapi::DATA_TYPE_DOUBLE:
+		case mcsapi::DATA_TYPE_UDOUBLE:
+			kind = KEY_DOUBLE;
+			break;
+		case mcsapi::DATA_TYPE_DATE:
+		case mcsapi::DATA_TYPE_DATETIME:
+			kind = KEY_DATETIME;
+			break;
+		default:
+			kind = KEY_TEXT;
+		}
+		std::int64_t factor = 1;
+		for (std::uint32_t i = 0; kind == KEY_DECIMAL && i < key.scale; i++) {
+			factor *= 10;
+		}
+		this->key_kinds.push_back(kind);
+		this->key_factors.push_back(factor);
+	}
+	this->values.resize(plan.columnCount());
+}
+
+RowSorter::~RowSorter() {
+	if (this->writer.joinable()) {
+		this->writer.join();
+	}
+}
+
+std::string RowSorter::defaultTempDirectory() {
+#ifdef _WIN32
+	const char* directory = std::getenv("TEMP");
+	return directory != nullptr ? directory : ".";
+#else
+	const char* directory = std::getenv("TMPDIR");
+	return directory != nullptr && *directory != '\0' ? directory : "/tmp";
+#endif
+}
+
+void RowSorter::appendKey(std::vector<char>& out, size_t key, const ConvertedValue& value) const {
+	if (value.type == ConvertedValue::VALUE_NULL) {
+		out.push_back(KEY_NULL);
+		return;
+	}
+	switch (this->key_kinds[key]) {
+	case KEY_SIGNED: {
+		std::int64_t number = value.type == ConvertedValue::VALUE_INT ? value.int_value : clampSigned(numericValue(value, 1));
+		appendBigEndian(out, (std::uint64_t) number ^ ((std::uint64_t) 1 << 63));
+		break;
+	}
+	case KEY_UNSIGNED:
+		appendBigEndian(out, value.type == ConvertedValue::VALUE_UINT ? value.uint_value : clampUnsigned(numericValue(value, 1)));
+		break;
+	case KEY_DECIMAL: {
+		// decimals that fit the column are exact, mcsapi saturates the others
+		std::int64_t factor = this->key_factors[key];
+		std::int64_t number;
+		if (value.type == ConvertedValue::VALUE_DECIMAL) {
+			number = value.int_value;
+			for (std::uint32_t scale = value.scale; scale < this->keys[key].scale; scale++) {
+				number *= 10;
+			}
+		}
+		else {
+			number = clampSigned(numericValue(value, factor));
+		}
+		appendBigEndian(out, (std::uint64_t) number ^ ((std::uint64_t) 1 << 63));
+		break;
+	}
+	case KEY_DOUBLE: {
+		double number = value.type == ConvertedValue::VALUE_DOUBLE ? value.double_value : (double) numericValue(value, 1);
+		std::uint64_t bits;
+		std::memcpy(&bits, &number, sizeof(bits));
+		// negative numbers order reversed, and below the positive ones
+		appendBigEndian(out, (bits >> 63) != 0 ? ~bits : bits | ((std::uint64_t) 1 << 63));
+		break;
+	}
+	case KEY_DATETIME: {
+		DateTimeFields fields;
+		if (value.type == ConvertedValue::VALUE_DATETIME_FIELDS) {
+			appendBigEndian(out, packDateTime(value.datetime));
+		}
+		else if (this->datetime_format.parse(value.text.data, value.text.length, fields) || this->date_format.parse(value.text.data, value.text.length, fields)) {
+			appendBigEndian(out, packDateTime(fields));
+		}
+		else {
+			// dates in formats that aren't parsed natively order after the others, as text
+			appendText(out, KEY_UNPARSED, value.text.data, value.text.length);
+		}
+		break;
+	}
+	default:
+		appendText(out, KEY_VALUE, value.text.data, value.text.length);
+	}
+}
+
+void RowSorter::add(size_t file, const ConvertedValue* values, const CsvField* fields, size_t field_count) {
+	std::vector<char>& data = this->filling.data;
+	size_t offset = data.size();
+	// the lengths of the record and its key are filled in once they are known
+	appendUint32(data, 0);
+	appendUint32(data, 0);
+	for (size_t key = 0; key < this->keys.size(); key++) {
+		appendKey(data, key, values[this->keys[key].column]);
+	}
+	size_t key_length = data.size() - offset - 8;
+	appendUint32(data, (std::uint32_t) file);
+	for (size_t col = 0; col < this->plan.columnCount(); col++) {
+		const ConvertedValue& v = values[col];
+		data.push_back((char) v.type);
+		switch (v.type) {
+		case ConvertedValue::VALUE_NULL:
+		case ConvertedValue::VALUE_TRUE:
+			break;
+		case ConvertedValue::VALUE_INT:
+		case ConvertedValue::VALUE_UINT:
+		case ConvertedValue::VALUE_DOUBLE:
+			appendBytes(data, &v.int_value, sizeof(v.int_value));
+			break;
+		case ConvertedValue::VALUE_DECIMAL:
+			appendBytes(data, &v.int_value, sizeof(v.int_value));
+			data.push_back((char) v.scale);
+			break;
+		case ConvertedValue::VALUE_DATETIME_FIELDS:
+			appendBytes(data, &v.datetime, sizeof(v.datetime));
+			break;
+		default:
+			appendUint32(data, (std::uint32_t) v.text.length);
+			appendBytes(data, v.text.data, v.text.length);
+		}
+	}
+	appendUint32(data, this->keep_fields ? (std::uint32_t) field_count : 0);
+	for (size_t i = 0; this->keep_fields && i < field_count; i++) {
+		appendUint32(data, (std::uint32_t) fields[i].length);
+		appendBytes(data, fields[i].data, fields[i].length);
+	}
+	std::uint32_t lengths[2] = { (std::uint32_t) (data.size() - offset - 4), (std::uint32_t) key_length };
+	std::memcpy(data.data() + offset, lengths, sizeof(lengths));
+
+	Entry entry;
+	entry.prefix = 0;
+	const char* key = data.data() + offset + 8;
+	for (size_t i = 0; i < 8; i++) {
+		entry.prefix = (entry.prefix << 8) | (i < key_length ? (std::uint8_t) key[i] : 0);
+	}
+	entry.offset = offset;
+	this->filling.entries.push_back(entry);
+	this->rows++;
+	if (this->filling.bytes() >= this->buffer_budget) {
+		spill();
+	}
+}
+
+bool RowSorter::keyLess(const char* a, const char* b) {
+	std::uint32_t a_length;
+	std::uint32_t b_length;
+	std::memcpy(&a_length, a + 4, sizeof(a_length));
+	std::memcpy(&b_length, b + 4, sizeof(b_length));
+	int c = std::memcmp(a + 8, b + 8, std::min(a_length, b_length));
+	return c < 0 || (c == 0 && a_length < b_length);
+}
+
+void RowSorter::sortEntries(Buffer& buffer) const {
+	const char* data = buffer.data.data();
+	auto less = [data](const Entry& a, const Entry& b) {
+		return a.prefix < b.prefix || (a.prefix == b.prefix && keyLess(data + a.offset, data + b.offset));
+	};
+	std::vector<Entry>& entries = buffer.entries;
+	// sort equal slices on the threads, then merge neighbouring slices in parallel until one is left
+	size_t slices = std::min((size_t) this->threads, std::max(entries.size() / 4096, (size_t) 1));
+	std::vector<size_t> bounds;
+	for (size_t i = 0; i <= slices; i++) {
+		bounds.push_back(entries.size() * i / slices);
+	}
+	std::vector<std::thread> workers;
+	for (size_t i = 1; i < slices; i++) {
+		workers.push_back(std::thread([&entries, &bounds, &less, i] { std::stable_sort(entries.begin() + bounds[i], entries.begin() + bounds[i + 1], less); }));
+	}
+	std::stable_sort(entries.begin() + bounds[0], entries.begin() + bounds[1], less);
+	for (auto& w : workers) {
+		w.join();
+	}
+	while (bounds.size() > 2) {
+		std::vector<size_t> merged;
+		workers.clear();
+		for (size_t i = 0; i + 2 < bounds.size(); i += 2) {
+			workers.push_back(std::thread([&entries, &bounds, &less, i] { std::inplace_merge(entries.begin() + bounds[i], entries.begin() + bounds[i + 1], entries.begin() + bounds[i + 2], less); }));
+			merged.push_back(bounds[i]);
+		}
+		if (bounds.size() % 2 == 0) {
+			// an odd number of slices, the last one is merged in the next round
+			merged.push_back(bounds[bounds.size() - 2]);
+		}
+		merged.push_back(bounds.back());
+		for (auto& w : workers) {
+			w.join();
+		}
+		bounds.swap(merged);
+	}
+}
+
+RowSorter::Run* RowSorter::createRun() {
+	static std::atomic<unsigned> counter(0);
+	std::unique_ptr<Run> run(new Run());
+	run->path = this->temp_directory + "/mcsimport_sort_" + std::to_string((long long) getpid()) + "_" + std::to_string(counter++) + ".run";
+	run->file = std::fopen(run->path.c_str(), "w+b");
+	if (run->file == nullptr) {
+		throw std::runtime_error("Can't create sort run file " + run->path);
+	}
+#ifndef _WIN32
+	// the file stays accessible through its handle and disappears with it, even if mcsimport is killed
+	std::remove(run->path.c_str());
+#endif
+	run->io_buffer.reset(new char[RUN_IO_BUFFER_SIZE]);
+	std::setvbuf(run->file, run->io_buffer.get(), _IOFBF, RUN_IO_BUFFER_SIZE);
+	return run.release();
+}
+
+void RowSorter::writeRun(Buffer& buffer) {
+	// called on the writer thread
+	StageTimer timer(this->stats, ImportStats::STAGE_SORT);
+	sortEntries(buffer);
+	std::unique_ptr<Run> run(createRun());
+	for (auto const& entry : buffer.entries) {
+		const char* record = buffer.data.data() + entry.offset;
+		std::uint32_t length;
+		std::memcpy(&length, record, sizeof(length));
+		if (std::fwrite(record, 1, 4 + length, run->file) != 4 + length) {
+			throw std::runtime_error("Can't write sort run file " + run->path);
+		}
+	}
+	if (std::fflush(run->file) != 0) {
+		throw std::runtime_error("Can't write sort run file " + run->path);
+	}
+	this->runs.push_back(std::move(run));
+	buffer.data.clear();
+	buffer.entries.clear();
+}
+
+void RowSorter::joinWriter() {
+	if (this->writer.joinable()) {
+		this->writer.join();
+	}
+	if (this->writer_error) {
+		std::exception_ptr error = this->writer_error;
+		this->writer_error = nullptr;
+		std::rethrow_exception(error);
+	}
+}
+
+void RowSorter::spill() {
+	// the previous run has to be written before its buffer is reused
+	{
+		StageTimer timer(this->stats, ImportStats::STAGE_WAIT);
+		joinWriter();
+	}
+	std::swap(this->filling, this->writing);
+	this->run_count++;
+	this->writer = std::thread([this] {
+		try {
+			writeRun(this->writing);
+		}
+		catch (...) {
+			this->writer_error = std::current_exception();
+		}
+	});
+}
+
+void RowSorter::openSources(size_t first, size_t count, const Buffer* buffer) {
+	this->sources.clear();
+	this->sources.resize(count + (buffer != nullptr ? 1 : 0));
+	for (size_t i = 0; i < count; i++) {
+		Run* run = this->runs[first + i].get();
+		if (std::fseek(run->file, 0, SEEK_SET) != 0) {
+			throw std::runtime_error("Can't read sort run file " + run->path);
+		}
+		this->sources[i].run = run;
+	}
+	if (buffer != nullptr) {
+		this->sources.back().buffer = buffer;
+	}
+	this->heap.clear();
+	for (size_t i = 0; i < this->sources.size(); i++) {
+		Source& source = this->sources[i];
+		if (source.buffer != nullptr) {
+			source.current = source.buffer->entries.empty() ? nullptr : source.buffer->data.data() + source.buffer->entries[0].offset;
+		}
+		else {
+			advance(source);
+		}
+		if (source.current != nullptr) {
+			this->heap.push_back(i);
+		}
+	}
+	auto greater = [this](size_t a, size_t b) { return sourceGreater(a, b); };
+	std::make_heap(this->heap.begin(), this->heap.end(), greater);
+}
+
+bool RowSorter::advance(Source& source) {
+	if (source.buffer != nullptr) {
+		source.position++;
+		source.current = source.position < source.buffer->entries.size() ? source.buffer->data.data() + source.buffer->entries[source.position].offset : nullptr;
+		return source.current != nullptr;
+	}
+	std::uint32_t length;
+	size_t read = std::fread(&length, 1, sizeof(length), source.run->file);
+	if (read == 0 && std::feof(source.run->file)) {
+		source.current = nullptr;
+		return false;
+	}
+	source.record.resize(4 + (size_t) length);
+	std::memcpy(source.record.data(), &length, sizeof(length));
+	if (read != sizeof(length) || std::fread(source.record.data() + 4, 1, length, source.run->file) != length) {
+		throw std::runtime_error("Can't read sort run file " + source.run->path);
+	}
+	source.current = source.record.data();
+	return true;
+}
+
+bool RowSorter::sourceGreater(size_t a, size_t b) const {
+	// equal keys are taken from the earlier source first, which holds the earlier rows
+	const char* a_record = this->sources[a].current;
+	const char* b_record = this->sources[b].current;
+	if (keyLess(b_record, a_record)) {
+		return true;
+	}
+	return !keyLess(a_record, b_record) && a > b;
+}
+
+void RowSorter::mergeRuns(size_t first, size_t count, Run& target) {
+	openSources(first, count, nullptr);
+	auto greater = [this](size_t a, size_t b) { return sourceGreater(a, b); };
+	while (!this->heap.empty()) {
+		std::pop_heap(this->heap.begin(), this->heap.end(), greater);
+		Source& source = this->sources[this->heap.back()];
+		std::uint32_t length;
+		std::memcpy(&length, source.current, sizeof(length));
+		if (std::fwrite(source.current, 1, 4 + length, target.file) != 4 + length) {
+			throw std::runtime_error("Can't write sort run file " + target.path);
+		}
+		if (advance(source)) {
+			std::push_heap(this->heap.begin(), this->heap.end(), greater);
+		}
+		else {
+			this->heap.pop_back();
+		}
+	}
+	if (std::fflush(target.file) != 0) {
+		throw std::runtime_error("Can't write sort run file " + target.path);
+	}
+}
+
+bool RowSorter::next(SortedRow& row) {
+	auto greater = [this](size_t a, size_t b) { return sourceGreater(a, b); };
+	if (!this->merging) {
+		this->merging = true;
+		joinWriter();
+		sortEntries(this->filling);
+		// the oldest runs are merged first, so that the runs stay in input order
+		while (this->runs.size() + 1 > MAX_MERGE_WIDTH) {
+			std::unique_ptr<Run> merged(createRun());
+			mergeRuns(0, MAX_MERGE_WIDTH, *merged);
+			this->runs.erase(this->runs.begin(), this->runs.begin() + MAX_MERGE_WIDTH);
+			this->runs.insert(this->runs.begin(), std::move(merged));
+		}
+		openSources(0, this->runs.size(), &this->filling);
+	}
+	else if (this->last_source != SIZE_MAX) {
+		if (advance(this->sources[this->last_source])) {
+			std::push_heap(this->heap.begin(), this->heap.end(), greater);
+		}
+		else {
+			this->heap.pop_back();
+		}
+	}
+	if (this->heap.empty()) {
+		this->last_source = SIZE_MAX;
+		return false;
+	}
+	// the top source stays at the back of the heap until it was advanced
+	std::pop_heap(this->heap.begin(), this->heap.end(), greater);
+	this->last_source = this->heap.back();
+	decode(this->sources[this->last_source].current, row);
+	return true;
+}
+
+void RowSorter::decode(const char* record, SortedRow& row) {
+	const char* data = record + 4;
+	std::uint32_t key_length = readUint32(data);
+	data += key_length;
+	row.file = readUint32(data);
+	for (size_t col = 0; col < this->values.size(); col++) {
+		ConvertedValue& v = this->values[col];
+		v.type = (ConvertedValue::Type) *data++;
+		switch (v.type) {
+		case ConvertedValue::VALUE_NULL:
+		case ConvertedValue::VALUE_TRUE:
+			break;
+		case ConvertedValue::VALUE_INT:
+		case ConvertedValue::VALUE_UINT:
+		case ConvertedValue::VALUE_DOUBLE:
+			std::memcpy(&v.int_value, data, sizeof(v.int_value));
+			data += sizeof(v.int_value);
+			break;
+		case ConvertedValue::VALUE_DECIMAL:
+			std::memcpy(&v.int_value, data, sizeof(v.int_value));
+			data += sizeof(v.int_value);
+			v.scale = (std::uint8_t) *data++;
+			break;
+		case ConvertedValue::VALUE_DATETIME_FIELDS:
+			std::memcpy(&v.datetime, data, sizeof(v.datetime));
+			data += sizeof(v.datetime);
+			break;
+		default:
+			v.text.length = readUint32(data);
+			v.text.data = data;
+			data += v.text.length;
+			// the date format is the one of the column's conversion
+			v.format = &this->plan.column(col).value;
+		}
+	}
+	std::uint32_t field_count = readUint32(data);
+	this->fields.resize(field_count);
+	for (std::uint32_t i = 0; i < field_count; i++) {
+		this->fields[i].length = readUint32(data);
+		this->fields[i].data = data;
+		data += this->fields[i].length;
+	}
+	row.values = this->values.data();
+	row.fields = this->fields.data();
+	row.field_count = field_count;
+}
@@ -0,0 +1,150 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <libmcsapi/mcsapi.h>
+#include "csv_reader.h"
+#include "import_stats.h"
+#include "row_conversion.h"
+
+/**
+* A target column the rows are sorted by, compared according to its ColumnStore type.
+*/
+struct SortKey {
+	size_t column;
+	mcsapi::columnstore_data_types_t type;
+	std::uint32_t scale;
+};
+
+/**
+* A row handed out by RowSorter. Its values and fields stay valid until the next row is requested.
+*/
+struct SortedRow {
+	size_t file; // the input file the row was read from
+	const ConvertedValue* values;
+	const CsvField* fields; // the parsed csv fields if they are kept, for the error logs
+	size_t field_count;
+};
+
+/**
+* Sorts the prepared rows of an import by a list of target columns within a
+* memory budget. Each row is copied into a record that starts with a key, whose
+* bytes compare like the values in their column types with NULLs first. A full
+* buffer is sorted on several threads and written as a sorted run to a temporary
+* file in the background, while the next buffer is filled. The runs and the last
+* buffer are merged when the rows are read back. Rows with equal keys keep their
+* input order.
+*/
+class RowSorter {
+public:
+	static const size_t MAX_MERGE_WIDTH = 64; // runs merged at once, more runs are merged into intermediate runs first
+
+	/*
+	* sorts rows of the target columns of plan by keys. keep_fields also stores the parsed csv fields of each row. memory_budget bytes are shared by the buffer that is filled and the one that is written, the runs are written into temp_directory.
+	*/
+	RowSorter(const ConversionPlan& plan, const std::vector<SortKey>& keys, bool keep_fields, size_t memory_budget, const std::string& temp_directory, unsigned threads, ImportStats* stats);
+	~RowSorter();
+
+	/*
+	* copies a row into the sorter. throws std::runtime_error if a run can't be written.
+	*/
+	void add(size_t file, const ConvertedValue* values, const CsvField* fields, size_t field_count);
+
+	/*
+	* returns the next row in sorted order, or false after the last one. no rows can be added after the first call, which sorts the last buffer and merges runs if there are too many to read at once. throws std::runtime_error if a run can't be written or read.
+	*/
+	bool next(SortedRow& row);
+
+	std::uint64_t rowCount() const { return this->rows; }
+	size_t runCount() const { return this->run_count; }
+
+	/*
+	* returns the directory of temporary files of the system
+	*/
+	static std::string defaultTempDirectory();
+
+private:
+	enum KeyKind { KEY_SIGNED, KEY_UNSIGNED, KEY_DECIMAL, KEY_DOUBLE, KEY_DATETIME, KEY_TEXT };
+	struct Entry {
+		std::uint64_t prefix; // the first key bytes in big endian order
+		size_t offset; // of the record in the buffer
+	};
+	struct Buffer {
+		std::vector<char> data; // the records
+		std::vector<Entry> entries;
+		size_t bytes() const { return this->data.size() + this->entries.size() * sizeof(Entry); }
+	};
+	struct Run {
+		std::FILE* file = nullptr;
+		std::string path;
+		std::unique_ptr<char[]> io_buffer;
+		~Run();
+	};
+	struct Source {
+		const Buffer* buffer = nullptr; // the last buffer, or nullptr for a run
+		size_t position = 0; // of the current entry in buffer
+		Run* run = nullptr;
+		std::vector<char> record; // the current record of a run
+		const char* current = nullptr; // the current record, nullptr if exhausted
+	};
+
+	const ConversionPlan& plan;
+	std::vector<SortKey> keys;
+	std::vector<KeyKind> key_kinds;
+	std::vector<std::int64_t> key_factors; // 10^scale of decimal keys
+	DateFormat datetime_format;
+	DateFormat date_format;
+	bool keep_fields;
+	size_t buffer_budget;
+	std::string temp_directory;
+	unsigned threads;
+	ImportStats* stats;
+	std::uint64_t rows = 0;
+	size_t run_count = 0;
+
+	Buffer filling;
+	Buffer writing; // sorted and written by the writer thread
+	std::thread writer;
+	std::exception_ptr writer_error;
+	std::vector<std::unique_ptr<Run>> runs; // in input order
+
+	// state of the merge
+	bool merging = false;
+	std::vector<Source> sources;
+	std::vector<size_t> heap; // indexes of the sources that aren't exhausted
+	size_t last_source = SIZE_MAX; // the source of the row returned last, advanced on the next call
+	std::vector<ConvertedValue> values;
+	std::vector<CsvField> fields;
+
+	void appendKey(std::vector<char>& out, size_t key, const ConvertedValue& value) const;
+	void spill();
+	void writeRun(Buffer& buffer);
+	void sortEntries(Buffer& buffer) const;
+	void joinWriter();
+	Run* createRun();
+	void mergeRuns(size_t first, size_t count, Run& target);
+	void openSources(size_t first, size_t count, const Buffer* buffer);
+	bool advance(Source& source);
+	bool sourceGreater(size_t a, size_t b) const;
+	void decode(const char* record, SortedRow& row);
+	static bool keyLess(const char* a, const char* b);
+};
@@ -0,0 +1,182 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#include "spool_directory.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <io.h>
+#else
+#include <dirent.h>
+#endif
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+SpoolDirectory::SpoolDirectory(const std::string& directory) {
+	this->directory = directory;
+	while (this->directory.size() > 1 && (this->directory.back() == '/' || this->directory.back() == '\\')) {
+		this->directory.pop_back();
+	}
+}
+
+SpoolDirectory::~SpoolDirectory() {
+#ifdef __linux__
+	if (this->watch_fd >= 0) {
+		::close(this->watch_fd);
+	}
+#endif
+}
+
+void SpoolDirectory::open() {
+	struct stat st;
+	if (stat(this->directory.c_str(), &st) != 0 || !(st.st_mode & S_IFDIR)) {
+		throw std::runtime_error("Spool directory " + this->directory + " doesn't exist");
+	}
+	for (const char* subdirectory : { "done", "failed" }) {
+		std::string path = this->directory + "/" + subdirectory;
+#ifdef _WIN32
+		int ret = _mkdir(path.c_str());
+#else
+		int ret = mkdir(path.c_str(), 0755);
+#endif
+		if (ret != 0 && errno != EEXIST) {
+			throw std::runtime_error("Can't create directory " + path);
+		}
+	}
+#ifdef __linux__
+	// the watch is added before the directory is scanned, so that no file is missed in between
+	this->watch_fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+	if (this->watch_fd < 0 || inotify_add_watch(this->watch_fd, this->directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_ONLYDIR) < 0) {
+		throw std::runtime_error("Can't watch spool directory " + this->directory + ": " + std::strerror(errno));
+	}
+	this->events.resize(64 * 1024);
+#endif
+}
+
+std::vector<std::string> SpoolDirectory::wait(double timeout) {
+	std::vector<std::string> ready;
+	// the files that are already there are ready at the first call
+	if (!this->scanned) {
+		this->scanned = true;
+		scan(ready);
+		if (!ready.empty()) {
+			return ready;
+		}
+	}
+	int milliseconds = (int) std::min(timeout * 1000, 3600000.0);
+#ifdef __linux__
+	pollfd fd = { this->watch_fd, POLLIN, 0 };
+	int ret = poll(&fd, 1, milliseconds);
+	if (ret < 0 && errno != EINTR) {
+		throw std::runtime_error(std::string("Can't watch spool directory ") + this->directory + ": " + std::strerror(errno));
+	}
+	if (ret <= 0) {
+		return ready;
+	}
+	for (;;) {
+		ssize_t length = read(this->watch_fd, this->events.data(), this->events.size());
+		if (length <= 0) {
+			break;
+		}
+		for (ssize_t offset = 0; offset < length;) {
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(this->events.data() + offset);
+			offset += sizeof(inotify_event) + event->len;
+			if (event->mask & IN_Q_OVERFLOW) {
+				// events were lost, the directory listing tells which files arrived
+				scan(ready);
+			}
+			else if (event->len > 0 && !(event->mask & IN_ISDIR)) {
+				add(event->name, ready);
+			}
+		}
+	}
+#else
+	std::this_thread::sleep_for(std::chrono::milliseconds(std::min(milliseconds, 1000)));
+	scan(ready);
+#endif
+	return ready;
+}
+
+void SpoolDirectory::scan(std::vector<std::string>& ready) {
+	// files are listed in the order of their names
+	std::vector<std::string> names;
+#ifdef _WIN32
+	struct _finddata_t file_info;
+	intptr_t handle = _findfirst((this->directory + "/*").c_str(), &file_info);
+	if (handle != -1) {
+		do {
+			if (!(file_info.attrib & _A_SUBDIR)) {
+				names.push_back(file_info.name);
+			}
+		} while (_findnext(handle, &file_info) == 0);
+		_findclose(handle);
+	}
+#else
+	DIR* dir = opendir(this->directory.c_str());
+	if (dir == nullptr) {
+		throw std::runtime_error("Can't read spool directory " + this->directory);
+	}
+	while (struct dirent* entry = readdir(dir)) {
+		names.push_back(entry->d_name);
+	}
+	closedir(dir);
+#endif
+	std::sort(names.begin(), names.end());
+	for (auto const& name : names) {
+		add(name, ready);
+	}
+}
+
+void SpoolDirectory::add(const std::string& name, std::vector<std::string>& ready) {
+	if (name.empty() || name[0] == '.' || this->returned.count(name) > 0) {
+		return;
+	}
+	std::string path = this->directory + "/" + name;
+	if (!isRegularFile(path)) {
+		return;
+	}
+	this->returned.insert(name);
+	ready.push_back(path);
+}
+
+bool SpoolDirectory::move(const std::string& path, const char* subdirectory) {
+	std::string name = path.substr(path.find_last_of('/') + 1);
+	std::string target = this->directory + "/" + subdirectory + "/" + name;
+#ifdef _WIN32
+	std::remove(target.c_str());
+#endif
+	if (std::rename(path.c_str(), target.c_str()) != 0) {
+		return false;
+	}
+	this->returned.erase(name);
+	return true;
+}
+
+bool SpoolDirectory::isRegularFile(const std::string& path) {
+	struct stat st;
+	return stat(path.c_str(), &st) == 0 && (st.st_mode & S_IFREG);
+}
@@ -0,0 +1,65 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#pragma once
+
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+* Watches a spool directory for input files to import. A file is ready once it
+* was written and closed in the directory or moved into it, files that are
+* already there when the watch starts are ready right away. Hidden files, whose
+* names start with a dot, and subdirectories are ignored, so that writers can
+* create a file under a hidden name and rename it once it is complete. Imported
+* files are moved into its done or failed subdirectory. On Linux the directory
+* is watched with inotify, elsewhere it is scanned for new files, which only
+* sees complete files if they are renamed into the directory.
+*/
+class SpoolDirectory {
+public:
+	explicit SpoolDirectory(const std::string& directory);
+	~SpoolDirectory();
+
+	/*
+	* creates the done and failed subdirectories and starts watching. throws std::runtime_error if the directory can't be watched.
+	*/
+	void open();
+
+	/*
+	* waits up to timeout seconds until files are ready and returns their paths in the order they became ready. each file is only returned once until it was moved. returns an empty list after the timeout or if the wait was interrupted by a signal. throws std::runtime_error if the directory can't be read.
+	*/
+	std::vector<std::string> wait(double timeout);
+
+	/*
+	* moves a returned file into the done or failed subdirectory, returns false if it couldn't be moved
+	*/
+	bool moveToDone(const std::string& path) { return move(path, "done"); }
+	bool moveToFailed(const std::string& path) { return move(path, "failed"); }
+
+	const std::string& path() const { return this->directory; }
+
+private:
+	std::string directory;
+	int watch_fd = -1; // the inotify instance, -1 when scanning
+	bool scanned = false; // the files that were there before the watch started were listed
+	std::set<std::string> returned; // names of files that were returned and not moved yet
+	std::vector<char> events;
+
+	void scan(std::vector<std::string>& ready);
+	void add(const std::string& name, std::vector<std::string>& ready);
+	bool move(const std::string& path, const char* subdirectory);
+	static bool isRegularFile(const std::string& path);
+};
@@ -0,0 +1,39 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#include "table_schema.h"
+
+TableSchema::TableSchema(mcsapi::ColumnStoreSystemCatalogTable& table) {
+	this->database = table.getSchemaName();
+	this->table = table.getTableName();
+	this->oid = table.getOID();
+	for (std::uint16_t col = 0; col < table.getColumnCount(); col++) {
+		mcsapi::ColumnStoreSystemCatalogColumn& c = table.getColumn(col);
+		ColumnSchema column;
+		column.name = c.getColumnName();
+		column.type = c.getType();
+		column.position = c.getPosition();
+		column.width = c.getWidth();
+		column.precision = c.getPrecision();
+		column.scale = c.getScale();
+		column.nullable = c.isNullable();
+		column.default_value = c.getDefaultValue();
+		addColumn(column);
+	}
+}
+
+void TableSchema::addColumn(const ColumnSchema& column) {
+	this->index.insert(std::make_pair(column.name, (std::int32_t) this->columns.size()));
+	this->columns.push_back(column);
+}
@@ -0,0 +1,73 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <libmcsapi/mcsapi.h>
+
+/**
+* The catalog metadata of a ColumnStore column that an import needs.
+*/
+struct ColumnSchema {
+	std::string name;
+	mcsapi::columnstore_data_types_t type = mcsapi::DATA_TYPE_CHAR;
+	std::uint32_t position = 0;
+	std::uint32_t width = 0;
+	std::uint32_t precision = 0;
+	std::uint32_t scale = 0;
+	bool nullable = true;
+	std::string default_value;
+};
+
+/**
+* The columns of a ColumnStore table, either resolved from the system catalog or
+* read from a cache, so that an import doesn't depend on the catalog afterwards.
+*/
+class TableSchema {
+public:
+	TableSchema() {}
+
+	/*
+	* copies the metadata of the given catalog table
+	*/
+	explicit TableSchema(mcsapi::ColumnStoreSystemCatalogTable& table);
+
+	std::string database;
+	std::string table;
+	std::uint32_t oid = 0;
+	std::vector<ColumnSchema> columns; // in the order of their positions, only appended by addColumn
+
+	/*
+	* appends the next column and indexes its name
+	*/
+	void addColumn(const ColumnSchema& column);
+
+	std::int32_t columnCount() const { return (std::int32_t) this->columns.size(); }
+	const ColumnSchema& column(std::int32_t col) const { return this->columns[col]; }
+
+	/*
+	* returns the position of the column with the given name, or -1 if there is none
+	*/
+	std::int32_t findColumn(const std::string& name) const {
+		auto it = this->index.find(name);
+		return it == this->index.end() ? -1 : it->second;
+	}
+
+private:
+	std::unordered_map<std::string, std::int32_t> index; // column name, position
+};
@@ -0,0 +1 @@
+CREATE TABLE IF NOT EXISTS mcsimport_test_conversion_cache_1 (id int, dt date, dtm datetime, status varchar(10)) engine=columnstore
\ No newline at end of file
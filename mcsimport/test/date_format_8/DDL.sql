@@ -0,0 +1 @@
+CREATE TABLE IF NOT EXISTS mcsimport_test_date_format_8 (id bigint unsigned, dt date, dtm datetime) engine=columnstore
\ No newline at end of file
@@ -0,0 +1 @@
+CREATE TABLE IF NOT EXISTS mcsimport_test_enclose_6 (id int, v varchar(128), i2 int) engine=columnstore
\ No newline at end of file
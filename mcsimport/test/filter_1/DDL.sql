@@ -0,0 +1 @@
+CREATE TABLE IF NOT EXISTS mcsimport_test_filter_1 (id int, region varchar(10), amount decimal(10,2), day date, note varchar(10)) engine=columnstore
\ No newline at end of file
@@ -0,0 +1 @@
+CREATE TABLE IF NOT EXISTS mcsimport_test_follow_1 (id int, name varchar(20), amount decimal(10,2)) engine=columnstore
\ No newline at end of file
@@ -0,0 +1,89 @@
+import threading
+
+appender = None
+
+def committed_offset(test_directory):
+    import os
+    # the checkpoint of -follow holds the offset up to which the rows are committed
+    try:
+        with open(os.path.join(test_directory,'input.csv.checkpoint')) as f:
+            for line in f:
+                if line.startswith('offset:'):
+                    return int(line.split(':')[1])
+    except (IOError, ValueError):
+        pass
+    return -1
+
+def wait_for_commit(test_directory, offset, timeout):
+    import time
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        if committed_offset(test_directory) >= offset:
+            return True
+        time.sleep(0.05)
+    return False
+
+def append(input_file, data):
+    import os
+    with open(input_file,'a') as f:
+        f.write(data)
+    return os.path.getsize(input_file)
+
+def append_rows(test_directory):
+    import os, time
+    input_file = os.path.join(test_directory,'input.csv')
+    size = os.path.getsize(input_file)
+    # mcsimport is started once the test table is created
+    if not wait_for_commit(test_directory, size, 60):
+        append(input_file, '0,not started,0.00\n')
+        return
+    # rows appended while the file is followed have to be committed within -commit_ms and the latency of reading them, far below -follow_idle
+    id = 5
+    for burst in range(3):
+        data = ''
+        for i in range(2):
+            data += '%d,row %d,%d.25\n' % (id, id, id)
+            id += 1
+        size = append(input_file, data)
+        if not wait_for_commit(test_directory, size, 1.5):
+            append(input_file, '0,too late,0.00\n')
+            return
+    # a row without its line break is held back until it is complete
+    start = append(input_file, '11,"partial, ')
+    time.sleep(0.3)
+    append(input_file, 'row",11.')
+    time.sleep(0.3)
+    if committed_offset(test_directory) > start:
+        append(input_file, '\n0,partial row committed,0.00\n')
+        return
+    size = append(input_file, '75\n')
+    if not wait_for_commit(test_directory, size, 1.5):
+        append(input_file, '0,too late,0.00\n')
+        return
+    # the last row has no line break when mcsimport ends, and isn't injected
+    append(input_file, '12,unfinished,12.00')
+
+def prepare_test(test_directory):
+    import os
+    global appender
+    # a checkpoint of a previous run would skip the rows
+    if os.path.exists(os.path.join(test_directory,'input.csv.checkpoint')):
+        os.remove(os.path.join(test_directory,'input.csv.checkpoint'))
+    with open(os.path.join(test_directory,'input.csv'),'w') as f:
+        f.write('id,name,amount\n1,alpha,1.50\n2,"beta, gamma",2.25\n3,delta,3.00\n4,"epsilon\nzeta",4.75\n')
+    # appends to the input file while mcsimport follows it
+    appender = threading.Thread(target=append_rows, args=(test_directory,))
+    appender.daemon = True
+    appender.start()
+    return
+
+def cleanup_test(test_directory):
+    import os
+    if appender is not None:
+        appender.join()
+    # -follow keeps the checkpoint file, as the input file could still grow
+    if os.path.exists(os.path.join(test_directory,'input.csv.checkpoint')):
+        os.remove(os.path.join(test_directory,'input.csv.checkpoint'))
+    if os.path.exists(os.path.join(test_directory,'input.csv')):
+        os.remove(os.path.join(test_directory,'input.csv'))
+    return
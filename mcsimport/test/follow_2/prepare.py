@@ -0,0 +1,50 @@
+import threading
+
+truncater = None
+
+def committed_offset(test_directory):
+    import os
+    # the checkpoint of -follow holds the offset up to which the rows are committed
+    try:
+        with open(os.path.join(test_directory,'input.csv.checkpoint')) as f:
+            for line in f:
+                if line.startswith('offset:'):
+                    return int(line.split(':')[1])
+    except (IOError, ValueError):
+        pass
+    return -1
+
+def truncate_input(test_directory):
+    import os, time
+    input_file = os.path.join(test_directory,'input.csv')
+    size = os.path.getsize(input_file)
+    # mcsimport is started once the test table is created, the committed rows stay injected
+    deadline = time.time() + 60
+    while time.time() < deadline and committed_offset(test_directory) < size:
+        time.sleep(0.05)
+    with open(input_file,'w') as f:
+        f.write('id,name,amount\n')
+
+def prepare_test(test_directory):
+    import os
+    global truncater
+    # a checkpoint of a previous run would skip the rows
+    if os.path.exists(os.path.join(test_directory,'input.csv.checkpoint')):
+        os.remove(os.path.join(test_directory,'input.csv.checkpoint'))
+    with open(os.path.join(test_directory,'input.csv'),'w') as f:
+        f.write('id,name,amount\n1,alpha,1.50\n2,"beta, gamma",2.25\n3,delta,3.00\n')
+    # truncates the input file while mcsimport follows it, which aborts the import
+    truncater = threading.Thread(target=truncate_input, args=(test_directory,))
+    truncater.daemon = True
+    truncater.start()
+    return
+
+def cleanup_test(test_directory):
+    import os
+    if truncater is not None:
+        truncater.join()
+    if os.path.exists(os.path.join(test_directory,'input.csv.checkpoint')):
+        os.remove(os.path.join(test_directory,'input.csv.checkpoint'))
+    if os.path.exists(os.path.join(test_directory,'input.csv')):
+        os.remove(os.path.join(test_directory,'input.csv'))
+    return
@@ -0,0 +1 @@
+CREATE TABLE IF NOT EXISTS mcsimport_test_mapping_header_1 (id int, name varchar(20), city varchar(20)) engine=columnstore
\ No newline at end of file
@@ -0,0 +1 @@
+CREATE TABLE IF NOT EXISTS mcsimport_test_max_errors_1 (id int, i int, ch varchar(5)) engine=columnstore
@@ -0,0 +1 @@
+CREATE TABLE IF NOT EXISTS mcsimport_test_multi_file_1 (id int, v varchar(16), i2 int) engine=columnstore
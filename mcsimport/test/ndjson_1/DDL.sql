@@ -0,0 +1 @@
+CREATE TABLE IF NOT EXISTS mcsimport_test_ndjson_1 (id int, name varchar(20), price decimal(6,2), active tinyint, d date) engine=columnstore
@@ -0,0 +1 @@
+CREATE TABLE IF NOT EXISTS mcsimport_test_ndjson_2 (id int, name varchar(20), tags varchar(30), src varchar(10)) engine=columnstore
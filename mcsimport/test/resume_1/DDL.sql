@@ -0,0 +1 @@
+CREATE TABLE IF NOT EXISTS mcsimport_test_resume_1 (id int, name varchar(20), amount int) engine=columnstore
\ No newline at end of file
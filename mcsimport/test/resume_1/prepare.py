@@ -0,0 +1,34 @@
+def prepare_test(test_directory):
+    import os
+    rows = 1000
+    resumed_row = 400
+
+    # generate input.csv, and expected.csv with the rows after the checkpoint
+    offset = 0
+    with open(os.path.join(test_directory,'input.csv'), 'w') as input:
+        with open(os.path.join(test_directory,'expected.csv'), 'w') as expected:
+            for r in range(rows):
+                line = '%d,name %d,%d\n' % (r, r, rows - r)
+                input.write(line)
+                if r < resumed_row:
+                    offset += len(line)
+                else:
+                    expected.write(line)
+
+    # write the checkpoint of an import that committed the first rows, so that -resume only imports the remaining ones
+    with open(os.path.join(test_directory,'input.csv.checkpoint'), 'w') as checkpoint:
+        checkpoint.write('database: test\n')
+        checkpoint.write('table: mcsimport_test_resume_1\n')
+        checkpoint.write('input_files:\n')
+        checkpoint.write('  - %s\n' % (os.path.join(test_directory,'input.csv'),))
+        checkpoint.write('input_file: 0\n')
+        checkpoint.write('offset: %d\n' % (offset,))
+        checkpoint.write('rows: %d\n' % (resumed_row,))
+    return
+
+def cleanup_test(test_directory):
+    import os
+    for f in ['input.csv', 'expected.csv', 'input.csv.checkpoint']:
+        if os.path.exists(os.path.join(test_directory,f)):
+            os.remove(os.path.join(test_directory,f))
+    return
@@ -0,0 +1 @@
+CREATE TABLE IF NOT EXISTS mcsimport_test_sort_1 (id int, day date, amount decimal(10,2), name varchar(10)) engine=columnstore
\ No newline at end of file
@@ -1,6 +1,6 @@
 #!/usr/bin/python
 
-import os, sys, subprocess, datetime, yaml, csv, random, time
+import os, sys, subprocess, datetime, yaml, csv, random, time, glob
 import mysql.connector as mariadb
 
 DB_NAME = 'test'
@@ -164,6 +164,28 @@ def loadTestConfig(test_directory):
         testConfig["enclosing_character"] = None
     if not "escaping_character" in testConfig:
         testConfig["escaping_character"] = None
+    if not "threads" in testConfig:
+        testConfig["threads"] = None
+    if not "commit_rows" in testConfig:
+        testConfig["commit_rows"] = None
+    if not "resume" in testConfig:
+        testConfig["resume"] = False
+    if not "validate_only" in testConfig:
+        testConfig["validate_only"] = False
+    if not "max_errors" in testConfig:
+        testConfig["max_errors"] = None
+    if not "ndjson" in testConfig:
+        testConfig["ndjson"] = False
+    if not "sort_by" in testConfig:
+        testConfig["sort_by"] = None
+    if not "conversion_cache" in testConfig:
+        testConfig["conversion_cache"] = None
+    if not "follow" in testConfig:
+        testConfig["follow"] = False
+    if not "follow_idle" in testConfig:
+        testConfig["follow_idle"] = None
+    if not "commit_ms" in testConfig:
+        testConfig["commit_ms"] = None
     return testConfig
     
 # executes the SQL statements of given file to set up the test table
@@ -203,6 +225,12 @@ def executeMcsimport(test_directory,testConfig):
     cmd = [mcsimport_executable, DB_NAME, testConfig["table"]]
     if os.path.exists(os.path.join(test_directory,"input.csv")):
         cmd.append(os.path.join(test_directory,"input.csv"))
+    elif os.path.exists(os.path.join(test_directory,"input.csv.gz")):
+        cmd.append(os.path.join(test_directory,"input.csv.gz"))
+    elif os.path.exists(os.path.join(test_directory,"input.json")):
+        cmd.append(os.path.join(test_directory,"input.json"))
+    elif glob.glob(os.path.join(test_directory,"input_*.csv")):
+        cmd.append(os.path.join(test_directory,"input_*.csv")) # expanded by mcsimport
     if os.path.exists(os.path.join(test_directory,"mapping.yaml")):
         cmd.append("-m")
         cmd.append("%s" % (os.path.join(test_directory,"mapping.yaml"),))
@@ -230,6 +258,35 @@ def executeMcsimport(test_directory,testConfig):
     if testConfig["null_option"] is not None:
         cmd.append("-n")
         cmd.append("%s" % (testConfig["null_option"]))
+    if testConfig["threads"] is not None:
+        cmd.append("-j")
+        cmd.append("%s" % (testConfig["threads"]))
+    if testConfig["commit_rows"] is not None:
+        cmd.append("-commit_rows")
+        cmd.append("%s" % (testConfig["commit_rows"]))
+    if testConfig["resume"]:
+        cmd.append("-resume")
+    if testConfig["validate_only"]:
+        cmd.append("-validate_only")
+    if testConfig["max_errors"] is not None:
+        cmd.append("-max_errors")
+        cmd.append("%s" % (testConfig["max_errors"]))
+    if testConfig["ndjson"]:
+        cmd.append("-ndjson")
+    if testConfig["sort_by"] is not None:
+        cmd.append("-sort_by")
+        cmd.append("%s" % (testConfig["sort_by"]))
+    if testConfig["conversion_cache"] is not None:
+        cmd.append("-conversion_cache")
+        cmd.append("%s" % (testConfig["conversion_cache"]))
+    if testConfig["follow"]:
+        cmd.append("-follow")
+    if testConfig["follow_idle"] is not None:
+        cmd.append("-follow_idle")
+        cmd.append("%s" % (testConfig["follow_idle"]))
+    if testConfig["commit_ms"] is not None:
+        cmd.append("-commit_ms")
+        cmd.append("%s" % (testConfig["commit_ms"]))
     
     print("Execute mcsimport: %s" % (cmd,))
     try:
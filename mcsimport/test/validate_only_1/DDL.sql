@@ -0,0 +1 @@
+CREATE TABLE IF NOT EXISTS mcsimport_test_validate_only_1 (id int, i8 tinyint, ch varchar(5), d date, dc decimal(5,2)) engine=columnstore
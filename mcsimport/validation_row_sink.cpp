@@ -0,0 +1,141 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#include "validation_row_sink.h"
+
+#include <cctype>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+
+ValidationRowSink::ValidationRowSink(const TableSchema& table) {
+	for (auto const& c : table.columns) {
+		Column column;
+		column.type = c.type;
+		column.width = c.width;
+		column.range.setColumnType(column.type, c.precision, c.scale);
+		this->columns.push_back(column);
+	}
+	this->datetime_format.compile("%Y-%m-%d %H:%M:%S");
+	this->date_format.compile("%Y-%m-%d");
+	this->start = std::chrono::steady_clock::now();
+}
+
+void ValidationRowSink::writeRow(const ConvertedValue* values, mcsapi::columnstore_data_convert_status_t* statuses) {
+	for (size_t col = 0; col < this->columns.size(); col++) {
+		const ConvertedValue& v = values[col];
+		mcsapi::columnstore_data_convert_status_t status = mcsapi::CONVERT_STATUS_NONE;
+		switch (v.type) {
+		case ConvertedValue::VALUE_DATETIME: {
+			// like in a real import a value that doesn't match the date format aborts the import
+			v.text.assignTo(this->string_value);
+			mcsapi::ColumnStoreDateTime dt = mcsapi::ColumnStoreDateTime(this->string_value, *v.format);
+			break;
+		}
+		case ConvertedValue::VALUE_STRING:
+			status = validateString(this->columns[col], v.text);
+			break;
+		default:
+			// NULL and natively converted values always fit the column
+			break;
+		}
+		switch (status) {
+		case mcsapi::CONVERT_STATUS_TRUNCATED:
+			this->written.truncation_count++;
+			break;
+		case mcsapi::CONVERT_STATUS_SATURATED:
+			this->written.saturated_count++;
+			break;
+		case mcsapi::CONVERT_STATUS_INVALID:
+			this->written.invalid_count++;
+			break;
+		default:
+			break;
+		}
+		statuses[col] = status;
+	}
+	this->written.rows_inserted++;
+}
+
+RowSinkSummary ValidationRowSink::commit() {
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	RowSinkSummary summary = this->written;
+	summary.execution_time = std::chrono::duration<double>(now - this->start).count();
+	this->written = RowSinkSummary();
+	this->start = now;
+	return summary;
+}
+
+void ValidationRowSink::rollback() {
+	this->written = RowSinkSummary();
+	this->start = std::chrono::steady_clock::now();
+}
+
+mcsapi::columnstore_data_convert_status_t ValidationRowSink::validateString(const Column& column, const CsvField& text) {
+	switch (column.type) {
+	case mcsapi::DATA_TYPE_DATE:
+	case mcsapi::DATA_TYPE_DATETIME: {
+		DateTimeFields fields;
+		if (this->datetime_format.parse(text.data, text.length, fields) || this->date_format.parse(text.data, text.length, fields)) {
+			return mcsapi::CONVERT_STATUS_NONE;
+		}
+		return mcsapi::CONVERT_STATUS_INVALID;
+	}
+	case mcsapi::DATA_TYPE_CHAR:
+	case mcsapi::DATA_TYPE_VARCHAR:
+	case mcsapi::DATA_TYPE_TEXT:
+	case mcsapi::DATA_TYPE_BLOB:
+	case mcsapi::DATA_TYPE_VARBINARY:
+		return text.length > column.width ? mcsapi::CONVERT_STATUS_TRUNCATED : mcsapi::CONVERT_STATUS_NONE;
+	default:
+		if (ConversionPlan::isNumericType(column.type)) {
+			return validateNumber(column, text);
+		}
+		return mcsapi::CONVERT_STATUS_NONE;
+	}
+}
+
+mcsapi::columnstore_data_convert_status_t ValidationRowSink::validateNumber(const Column& column, const CsvField& text) {
+	text.assignTo(this->string_value);
+	const char* begin = this->string_value.c_str();
+	char* end;
+	long double value = std::strtold(begin, &end);
+	if (end == begin || *end != '\0') {
+		return mcsapi::CONVERT_STATUS_INVALID;
+	}
+	const ColumnConversion& range = column.range;
+	switch (range.handler) {
+	case ColumnConversion::CSV_INTEGER:
+		value = std::round(value);
+		return value < (long double) range.min_value || value > (long double) (std::int64_t) range.max_value ? mcsapi::CONVERT_STATUS_SATURATED : mcsapi::CONVERT_STATUS_NONE;
+	case ColumnConversion::CSV_UNSIGNED:
+		value = std::round(value);
+		return value < 0 || value > (long double) range.max_value ? mcsapi::CONVERT_STATUS_SATURATED : mcsapi::CONVERT_STATUS_NONE;
+	case ColumnConversion::CSV_DECIMAL:
+		if (!range.allow_negative && value < 0) {
+			return mcsapi::CONVERT_STATUS_SATURATED;
+		}
+		// the integral part has precision - scale digits
+		return std::fabs(value) >= std::pow(10.0L, (long double) (range.precision - range.scale)) ? mcsapi::CONVERT_STATUS_SATURATED : mcsapi::CONVERT_STATUS_NONE;
+	default:
+		if (!range.allow_negative && value < 0) {
+			return mcsapi::CONVERT_STATUS_SATURATED;
+		}
+		if ((column.type == mcsapi::DATA_TYPE_FLOAT || column.type == mcsapi::DATA_TYPE_UFLOAT) && std::fabs(value) > FLT_MAX) {
+			return mcsapi::CONVERT_STATUS_SATURATED;
+		}
+		return mcsapi::CONVERT_STATUS_NONE;
+	}
+}
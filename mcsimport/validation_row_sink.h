@@ -0,0 +1,54 @@
+/*
+* Copyright (c) 2018 MariaDB Corporation Ab
+*
+* Use of this software is governed by the Business Source License included
+* in the LICENSE file and at www.mariadb.com/bsl11.
+*
+* Change Date: 2021-12-01
+*
+* On the date above, in accordance with the Business Source License, use
+* of this software will be governed by version 2 or later of the General
+* Public License.
+*/
+
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <libmcsapi/mcsapi.h>
+#include "row_conversion.h"
+#include "row_sink.h"
+#include "table_schema.h"
+
+/**
+* Checks the rows against the columns of a ColumnStore table without writing them.
+* The conversion status of each value is derived the way mcsapi converts it: text
+* longer than the column is truncated, numbers outside of the column's range are
+* saturated, and values that aren't numbers or dates of a numeric or date column
+* are invalid. No bulk insert is started, so the table isn't locked.
+*/
+class ValidationRowSink : public RowSink {
+public:
+	explicit ValidationRowSink(const TableSchema& table);
+	void writeRow(const ConvertedValue* values, mcsapi::columnstore_data_convert_status_t* statuses);
+	RowSinkSummary commit();
+	void rollback();
+
+private:
+	struct Column {
+		mcsapi::columnstore_data_types_t type;
+		std::uint32_t width;
+		ColumnConversion range; // the native range of numeric columns
+	};
+	std::vector<Column> columns;
+	RowSinkSummary written; // the rows since the last commit
+	std::chrono::steady_clock::time_point start;
+	DateFormat datetime_format;
+	DateFormat date_format;
+	std::string string_value; // reused buffer for values that are converted as string
+
+	mcsapi::columnstore_data_convert_status_t validateString(const Column& column, const CsvField& text);
+	mcsapi::columnstore_data_convert_status_t validateNumber(const Column& column, const CsvField& text);
+};